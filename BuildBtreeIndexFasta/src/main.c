@@ -13,12 +13,18 @@
 #include <time.h>
 #include <zlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "btime.h"
 #include "berror.h"
 #include "bmemory.h"
 #include "bstring.h"
 #include "btree.h"
 #include "fasta.h"
+#include "taxonomy.h"
+#include "btreeimage.h"
+#include "bzindex.h"
+#include "gitaxmap.h"
+#include "accession.h"
 
 char *program_name;
 
@@ -28,8 +34,14 @@ void print_usage(FILE *stream, int exit_code) {
     fprintf(stream, "\n\n%s options:\n\n", program_name);
     fprintf(stream, "-v,   --verbose                     Print info\n");
     fprintf(stream, "-h,   --help                        Display this usage information.\n");
-    fprintf(stream, "-i,   --input                       The input fasta file\n");
+    fprintf(stream, "-i,   --input                       The input fasta file. For a gzip file the random access index is written to the output name plus %s\n", ZINDEX_EXTENSION);
     fprintf(stream, "-o,   --output                      The output binary file as index\n");
+    fprintf(stream, "-b,   --image                       Write the index as a memory mappable B+ tree image\n");
+    fprintf(stream, "-f,   --fai                         Write a samtools like .fai text index (name, length, offset, line bases, line width)\n");
+    fprintf(stream, "-p,   --pthread                     The number of threads to index a not compressed fasta file (default: 1). The index records are sorted by Gi\n");
+    fprintf(stream, "-t,   --taxgi                       Write a B+ tree image from a gi-taxids file (like: gi_taxid_nucl.dmp) instead of the fasta index\n");
+    fprintf(stream, "-m,   --map                         With -t write a compact memory mappable Gi to taxId map instead of the B+ tree image\n");
+    fprintf(stream, "-a,   --acc2taxid                   Write a memory mappable accession.version to taxId index from an accession2taxid file (like: nucl_gb.accession2taxid.gz) instead of the fasta index\n");
     fprintf(stream, "********************************************************************************\n");
     fprintf(stream, "\n            Roberto Vera Alvarez (e-mail: r78v10a07@gmail.com)\n\n");
     fprintf(stream, "********************************************************************************\n");
@@ -42,12 +54,17 @@ void print_usage(FILE *stream, int exit_code) {
 int main(int argc, char** argv) {
 
     struct timespec start, stop;
-    int next_option, verbose, gzip;
-    const char* const short_options = "vhi:o:";
-    char *input, *output;
+    int next_option, verbose, gzip, image, fai, giMap, threads, count;
+    int *gis, *taxIds;
+    off_t *offsets;
+    const char* const short_options = "vhbfmi:o:p:t:a:";
+    char *input, *output, *taxgi, *acc2taxid, *tmp;
+    BtreeNode_t *root;
     FILE *fo;
     FILE *fd = NULL;
-    gzFile gFile = NULL;
+    ZIndex_t *zindex = NULL;
+    GiTaxMap_t *map;
+    AccTaxMap_t *accMap;
 
     clock_gettime(CLOCK_MONOTONIC, &start);
     program_name = argv[0];
@@ -56,11 +73,18 @@ int main(int argc, char** argv) {
         { "help", 0, NULL, 'h'},
         { "input", 1, NULL, 'i'},
         { "output", 1, NULL, 'o'},
+        { "image", 0, NULL, 'b'},
+        { "fai", 0, NULL, 'f'},
+        { "pthread", 1, NULL, 'p'},
+        { "taxgi", 1, NULL, 't'},
+        { "map", 0, NULL, 'm'},
+        { "acc2taxid", 1, NULL, 'a'},
         { NULL, 0, NULL, 0} /* Required at end of array.  */
     };
 
-    verbose = gzip = 0;
-    input = output = NULL;
+    verbose = gzip = image = fai = giMap = 0;
+    threads = 1;
+    input = output = taxgi = acc2taxid = NULL;
     do {
         next_option = getopt_long(argc, argv, short_options, long_options, NULL);
 
@@ -80,30 +104,113 @@ int main(int argc, char** argv) {
                 input = strdup(optarg);
                 gzip = 1 - strbcmp(input, ".gz");
                 break;
+
+            case 'b':
+                image = 1;
+                break;
+
+            case 'f':
+                fai = 1;
+                break;
+
+            case 'm':
+                giMap = 1;
+                break;
+
+            case 'p':
+                threads = atoi(optarg);
+                break;
+
+            case 't':
+                taxgi = strdup(optarg);
+                break;
+
+            case 'a':
+                acc2taxid = strdup(optarg);
+                break;
         }
     } while (next_option != -1);
 
-    if (!input || !output) {
+    if ((!input && !taxgi && !acc2taxid) || !output) {
         print_usage(stderr, -1);
     }
 
+    if (acc2taxid) {
+        accMap = AccTaxMapLoad(acc2taxid, verbose);
+        AccTaxMapWrite(accMap, output);
+        AccTaxMapFree(accMap);
+        free(acc2taxid);
+        if (taxgi) free(taxgi);
+        if (input) free(input);
+        free(output);
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+        printf("\n\tThe total time was %.1f sec\n\n", timespecDiffSec(&stop, &start));
+        return (EXIT_SUCCESS);
+    }
+
+    if (taxgi) {
+        if (giMap) {
+            map = GiTaxMapLoad(taxgi, 0, verbose);
+            GiTaxMapWrite(map, output);
+            GiTaxMapFree(map);
+        } else {
+            count = TaxonomyNuclLoad(taxgi, 0, &gis, &taxIds, verbose);
+            BtreeImageWriteArrays(output, gis, taxIds, count, sizeof (int));
+            free(gis);
+            free(taxIds);
+        }
+        free(taxgi);
+        if (input) free(input);
+        free(output);
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+        printf("\n\tThe total time was %.1f sec\n\n", timespecDiffSec(&stop, &start));
+        return (EXIT_SUCCESS);
+    }
+
+    /* A gzip file is read through its random access index, built while
+     * the fasta index is created. The offsets are uncompressed offsets
+     */
     if (!gzip) {
         fd = checkPointerError(fopen(input, "r"), "Can't open input file", __FILE__, __LINE__, -1);
     } else {
-        gFile = checkPointerError(gzopen(input, "rb"), "Can't open the input file", __FILE__, __LINE__, -1);
+        zindex = zindexCreate(ZINDEX_SPAN);
+        fd = zindexOpen(input, zindex);
+        threads = 1;
     }
-    fo = checkPointerError(fopen(output, "wb"), "Can't open output file", __FILE__, __LINE__, -1);
-    if (!gzip) {
-        CreateFastaIndexToFile(fd, fo, verbose);
+    if (image) {
+        if (!gzip) {
+            /* The sorted index is written without building the tree */
+            count = FastaIndexParallel(input, NULL, threads, 0, &gis, &offsets, verbose);
+            BtreeImageWriteArrays(output, gis, offsets, count, sizeof (off_t));
+            free(gis);
+            free(offsets);
+        } else {
+            root = CreateBtreeFromFasta(fd, verbose);
+            BtreeImageWrite(output, root, sizeof (off_t));
+            BTreeFree(root, free);
+        }
+    } else if (fai) {
+        fo = checkPointerError(fopen(output, "w"), "Can't open output file", __FILE__, __LINE__, -1);
+        CreateFastaFaiToFile(fd, fo, verbose);
+        fclose(fo);
     } else {
-        CreateFastaIndexGzipToFile(gFile, fo, verbose);
+        fo = checkPointerError(fopen(output, "wb"), "Can't open output file", __FILE__, __LINE__, -1);
+        if (threads != 1) {
+            CreateFastaIndexToFileParallel(input, fo, threads, verbose);
+        } else {
+            CreateFastaIndexToFile(fd, fo, verbose);
+        }
+        fclose(fo);
     }
-    fclose(fo);
 
-    if (!gzip) {
-        fclose(fd);
-    } else {
-        gzclose(gFile);
+    fclose(fd);
+    if (zindex) {
+        tmp = allocate(sizeof (char) * (strlen(output) + strlen(ZINDEX_EXTENSION) + 1), __FILE__, __LINE__);
+        sprintf(tmp, "%s%s", output, ZINDEX_EXTENSION);
+        if (verbose) printf("Writing the gzip random access index: %s\n", tmp);
+        zindexWrite(zindex, tmp);
+        zindexFree(zindex);
+        free(tmp);
     }
     if (input) free(input);
     if (output) free(output);
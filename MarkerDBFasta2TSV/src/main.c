@@ -52,6 +52,7 @@ int main(int argc, char** argv) {
     FILE *in;
     FILE *out;
     fasta_l fasta;
+    FastaReader_t *reader;
     off_t pos, length;
 
     clock_gettime(CLOCK_MONOTONIC, &start);
@@ -110,7 +111,8 @@ int main(int argc, char** argv) {
     fseeko(in, 0, SEEK_SET);
 
     i = 1;
-    while ((fasta = ReadFasta(in, 0)) != NULL) {
+    reader = CreateFastaReader(in);
+    while ((fasta = FastaReaderNext(reader, 0)) != NULL) {
         if (sscanf(fasta->header, "%d|%d-%d\n", &gi, &from, &to) != 3) {
             fprintf(stderr, "Bad header format:\n>gi|from-to\n%s", fasta->header);
             checkPointerError(NULL, "ERORR!!", __FILE__, __LINE__, -1);
@@ -122,8 +124,9 @@ int main(int argc, char** argv) {
         fprintf(out, "%d\t%d\t%d\t%s\n", gi, from, to, fasta->seq);
         fasta->free(fasta);
         i++;
-        pos = ftello(in);
+        pos = FastaReaderTell(reader);
     }
+    FreeFastaReader(reader);
     if (verbose) {
         printf("100.0 %%\t\t%6d\t%10d\t%5d\t%5d\n", i, gi, from, to);
         fflush(stdout);
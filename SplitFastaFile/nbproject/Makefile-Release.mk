@@ -35,7 +35,6 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
-	${OBJECTDIR}/src/split.o \
 	${OBJECTDIR}/src/splitFasta.o
 
 
@@ -63,11 +62,6 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/splitfastafile: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
 	${LINK.c} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/splitfastafile ${OBJECTFILES} ${LDLIBSOPTIONS}
 
-${OBJECTDIR}/src/split.o: src/split.c 
-	${MKDIR} -p ${OBJECTDIR}/src
-	${RM} "$@.d"
-	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/split.o src/split.c
-
 ${OBJECTDIR}/src/splitFasta.o: src/splitFasta.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
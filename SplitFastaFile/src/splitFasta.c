@@ -23,19 +23,6 @@
 
 char *program_name;
 
-/**
- * Creates segments of length with an overlap of offset
- * 
- * @param self the container object
- * @param out the output file 
- * @param length the length of the segments
- * @param offset the offset of the segments
- * @param lineLength the length of the fasta line
- * @param threads_number Number of threads
- * @param inMem du the generation in memory
- */
-void splitInSegmentsLocal(void * self, FILE *out, int length, int offset, int lineLength, int threads_number, int inMem, int tax);
-
 void print_usage(FILE *stream, int exit_code) {
     fprintf(stream, "\n********************************************************************************\n");
     fprintf(stream, "\nUsage: %s \n", program_name);
@@ -49,7 +36,12 @@ void print_usage(FILE *stream, int exit_code) {
     fprintf(stream, "-s,   --size                        The fasta line size (default: 80)\n");
     fprintf(stream, "-p,   --pthread                     The number of threads (default: 2)\n");
     fprintf(stream, "-t,   --split                       Split the result fasta file. Value in Gb (Ex: --split 2, not set for not split)\n");
-    fprintf(stream, "-m,   --mem                         Do the pthread work in memory\n");
+    fprintf(stream, "-m,   --mem                         Skip the segments with NNNNN and parse the Gi with the parser\n");
+    fprintf(stream, "-c,   --maxn                        Skip the segments with more than this number of N\n");
+    fprintf(stream, "-u,   --nrun                        Skip the segments with a run of N longer than this (default with -m: 4)\n");
+    fprintf(stream, "-a,   --acgt                        Skip the segments with a lower fraction of ACGT bases (Ex: --acgt 0.9)\n");
+    fprintf(stream, "-d,   --dust                        Skip the low-complexity segments with a higher DUST score (Ex: --dust 2.0)\n");
+    fprintf(stream, "-k,   --packed                      Keep the sequences 2-bit packed in memory\n");
     fprintf(stream, "-n,   --name                        Just rename fasta file\n");
     fprintf(stream, "-r,   --parser                      Sscanf format to parse the fasta header (Don't use it for default fasta header)\n");
     fprintf(stream, "-g,   --gi                          The GenBank Gi files. If  -n is used the output header is >gi;taxId\n");
@@ -64,12 +56,17 @@ void print_usage(FILE *stream, int exit_code) {
  */
 int main(int argc, char** argv) {
     fasta_l fasta;
+    FastaReader_t *reader;
+    FastaWriter_t *writer = NULL;
+    FastaSplitter_t *splitter = NULL;
+    FastaSegmentFilter_t filter = {-1, -1, -1, -1};
+    int filtered = 0;
 
     struct timespec start, stop, mid;
     int i, next_option, verbose;
-    const char* const short_options = "vhi:o:l:f:s:p:t:mnr:g:";
+    const char* const short_options = "vhi:o:l:f:s:p:t:mknr:g:c:u:a:d:";
     char *input, *output, *tmp, *headerParser, *giName;
-    int length, offset, size, threads, count, mem, name;
+    int length, offset, size, threads, count, mem, name, packed;
     FILE *fo;
     FILE *fd;
     char **ids = NULL;
@@ -93,17 +90,22 @@ int main(int argc, char** argv) {
         { "pthread", 1, NULL, 'p'},
         { "split", 1, NULL, 't'},
         { "mem", 0, NULL, 'm'},
+        { "packed", 0, NULL, 'k'},
         { "name", 0, NULL, 'n'},
         { "tax", 0, NULL, 'x'},
         { "parser", 0, NULL, 'r'},
         { "gi", 1, NULL, 'g'},
+        { "maxn", 1, NULL, 'c'},
+        { "nrun", 1, NULL, 'u'},
+        { "acgt", 1, NULL, 'a'},
+        { "dust", 1, NULL, 'd'},
         { NULL, 0, NULL, 0} /* Required at end of array.  */
     };
 
     verbose = split = countWords = count = mem = 0;
     input = output = tmp = headerParser = giName = NULL;
     size = 80;
-    length = offset = name = 0;
+    length = offset = name = packed = 0;
     threads = 1;
     do {
         next_option = getopt_long(argc, argv, short_options, long_options, NULL);
@@ -152,6 +154,10 @@ int main(int argc, char** argv) {
                 mem = 1;
                 break;
 
+            case 'k':
+                packed = 1;
+                break;
+
             case 'n':
                 name = 1;
                 break;
@@ -159,6 +165,26 @@ int main(int argc, char** argv) {
             case 'r':
                 headerParser = strdup(optarg);
                 break;
+
+            case 'c':
+                filter.maxN = atoi(optarg);
+                filtered = 1;
+                break;
+
+            case 'u':
+                filter.maxNRun = atoi(optarg);
+                filtered = 1;
+                break;
+
+            case 'a':
+                filter.minACGT = atof(optarg);
+                filtered = 1;
+                break;
+
+            case 'd':
+                filter.maxDust = atof(optarg);
+                filtered = 1;
+                break;
         }
     } while (next_option != -1);
 
@@ -192,8 +218,18 @@ int main(int argc, char** argv) {
         fflush(stdout);
     }
 
+    /* The renamed entries are copied through the buffered writer */
+    if (name || giName) writer = CreateFastaWriter(fo, size);
+    /* The entries share one pool of threads */
+    if (mem && filter.maxNRun < 0) {
+        filter.maxNRun = FASTA_FILTER_N_RUN;
+        filtered = 1;
+    }
+    if (name == 0 && !giName) splitter = CreateFastaSplitter(fo, mem ? headerParser : NULL, length, offset, size, threads, filtered ? &filter : NULL);
+
     clock_gettime(CLOCK_MONOTONIC, &mid);
-    while ((fasta = ReadFasta(fd, 0)) != NULL) {
+    reader = CreateFastaReader(fd);
+    while ((fasta = (packed ? FastaReaderNextPacked(reader) : FastaReaderNext(reader, 0))) != NULL) {
         clock_gettime(CLOCK_MONOTONIC, &stop);
         if (verbose) printf("Read sequence of size: %8d in %4.2f sec\n", fasta->len, timespecDiffSec(&stop, &mid));
         if (name == 0 && !giName) {
@@ -202,13 +238,16 @@ int main(int argc, char** argv) {
                 if (countWords >= split * 1024 * 1024 * 1024) {
                     count++;
                     countWords = fasta->length(fasta);
+                    FastaSplitterFlush(splitter);
                     fclose(fo);
                     sprintf(tmp, "%s_%d.fna", output, count);
                     if (verbose) printf("Creating a new file: %s\n", tmp);
                     fo = checkPointerError(fopen(tmp, "w"), "Can't open output file", __FILE__, __LINE__, -1);
+                    FastaSplitterSetOutput(splitter, fo);
                 }
             }
-            fasta->splitInSegments(fasta, fo, headerParser, length, offset, size, threads, mem);
+            FastaSplitterAdd(splitter, fasta);
+            fasta = NULL;
         } else if (name && !giName) {
             gi = fromTo = -1;
             ids_number = splitString(&ids, ((fasta_l) fasta)->header, "|");
@@ -226,7 +265,7 @@ int main(int argc, char** argv) {
             }
             memset(fasta->header, 0, strlen(fasta->header));
             sprintf(fasta->header, "%s|%s", ids[gi], ids[fromTo]);
-            fasta->toFile(fasta, fo, size);
+            FastaWriterWriteFasta(writer, fasta);
 
             freeArrayofPointers((void **) ids, ids_number);
         } else if (giName) {
@@ -242,15 +281,18 @@ int main(int argc, char** argv) {
                 } else {
                     sprintf(fasta->header, "%d;%d", gi, tax);
                 }
-                fasta->toFile(fasta, fo, size);
+                FastaWriterWriteFasta(writer, fasta);
             }
         }
-        fasta->free(fasta);
+        if (fasta) fasta->free(fasta);
         clock_gettime(CLOCK_MONOTONIC, &mid);
     }
+    FreeFastaReader(reader);
+    FreeFastaWriter(writer);
+    FreeFastaSplitter(splitter);
 
     if (giName) {
-        BTreeFree(gi_tax, free);
+        TaxonomyNuclFree(gi_tax);
         free(giName);
     }
 
@@ -13,27 +13,73 @@
 #include <getopt.h>
 #include <stdbool.h>
 #include <pthread.h>
+#include <stdint.h>
 #include <zlib.h>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <errno.h>
 #include "btree.h"
+#include "btreeimage.h"
 #include "btime.h"
+#include "bzreader.h"
 #include "berror.h"
 #include "bmemory.h"
 #include "bstring.h"
+#include "bsimd.h"
+#include "bbitset.h"
+#include "gitaxmap.h"
+#include "accession.h"
 #include "taxonomy.h"
 #include "fasta.h"
 
 char *program_name;
 
+/* Output buffer of the threads, bigger entries are written directly */
+#define TAXFILTER_BUFFER (1 << 20)
+/* A new output file is started before an entry if the current one is bigger */
+#define TAXFILTER_FILE_SIZE 4294967296LL
+/* Entries whose taxIds are searched together */
+#define TAXFILTER_BATCH 256
+
+/*
+ * An entry of the block being filtered: the header is [pos, headerEnd)
+ * and the next entry starts at next. hasSeq is 0 if the header is the
+ * last line of the file without newline
+ */
+typedef struct taxfilter_entry_t {
+    off_t pos;
+    off_t headerEnd;
+    off_t next;
+    int hasSeq;
+} taxfilter_entry_t;
+
+/*
+ * map is the mapped fasta file of size bytes. The thread filters the
+ * entries whose header starts in [start, end) to the file out. records
+ * are the offsets in out of the entries written and written is the size
+ * of out
+ */
 typedef struct thread_param {
     int number;
     char *out;
-    char *in;
+    char *map;
+    off_t size;
     off_t start;
     off_t end;
-    BtreeNode_t *taxIn;
-    BtreeNode_t *gi_tax;
+    Bitset_t *taxIn;
+    GiTaxMap_t *gi_tax;
+    BtreeImage_t *gi_taxImage;
+    AccTaxMap_t *acc_tax;
     int verbose;
+    off_t *records;
+    size_t recordsNumber;
+    size_t recordsCapacity;
+    off_t written;
 } thread_param_t;
 
 void print_usage(FILE *stream, int exit_code) {
@@ -44,10 +90,11 @@ void print_usage(FILE *stream, int exit_code) {
     fprintf(stream, "-h,   --help                        Display this usage information.\n");
     fprintf(stream, "-n,   --nt                          NT fasta file\n");
     fprintf(stream, "-o,   --output                      Output fasta file prefix\n");
-    fprintf(stream, "-t,   --taxgi                       File with the gi-taxids (like: gi_taxid_nucl.dmp)\n");
+    fprintf(stream, "-t,   --taxgi                       File with the gi-taxids (like: gi_taxid_nucl.dmp or gi_taxid_nucl.dmp.gz) its B+ tree image (BuildBtreeIndexFasta -t) its map (BuildBtreeIndexFasta -t -m), an accession2taxid file (like: nucl_gb.accession2taxid.gz) or its index (BuildBtreeIndexFasta -a). With accessions the output headers are >accession.version;taxId\n");
     fprintf(stream, "-d,   --dir                         NCBI Taxonomy db dir\n");
     fprintf(stream, "-s,   --skip                        File with the TaxId to skip\n");
     fprintf(stream, "-i,   --include                     File with the TaxId to include. All children will be included\n");
+    fprintf(stream, "-c,   --cache                       Cache file of the taxonomies to include. Rebuilt if the nodes.dmp, include or skip files change\n");
     fprintf(stream, "-p,   --threads                     NUmber of threads (default: 2)\n");
     fprintf(stream, "********************************************************************************\n");
     fprintf(stream, "\n            Roberto Vera Alvarez (e-mail: r78v10a07@gmail.com)\n\n");
@@ -55,168 +102,301 @@ void print_usage(FILE *stream, int exit_code) {
     exit(0);
 }
 
-BtreeNode_t *TaxsToInclude(char *dirName, char *include, char *skip, int verbose) {
-    FILE *fd1, *fd2;
-
-    int *lineage, lineage_number, *value;
-    void **records = NULL;
-    int i, j, records_number = 0;
-    BtreeNode_t *taxDB = NULL;
-    BtreeNode_t *taxIn = NULL;
-    BtreeNode_t *toInTaxId = NULL;
-    BtreeNode_t *toSkTaxId = NULL;
-    taxonomy_l tax;
-
+/*
+ * Read an int per line from the file (plain or gzip compressed)
+ */
+int *readTaxIds(char *filename, int *count) {
+    ZReader_t *reader;
+    int *taxIds = NULL;
+    int capacity = 0;
     char *line = NULL;
     size_t len = 0;
-    ssize_t read;
 
-    taxDB = TaxonomyDBIndex(dirName, verbose);
+    reader = zreaderOpen(filename);
+    *count = 0;
+    while (zreaderGetline(&line, &len, reader) != -1) {
+        if (*count == capacity) {
+            capacity = (capacity == 0) ? 1024 : capacity * 2;
+            taxIds = reallocate(taxIds, sizeof (int) * capacity, __FILE__, __LINE__);
+        }
+        taxIds[*count] = 0;
+        sscanf(line, "%d", &taxIds[*count]);
+        (*count)++;
+    }
+    if (line) free(line);
+    zreaderClose(reader);
+    return taxIds;
+}
+
+/*
+ * Key of the taxonomy set cache: a FNV-1a hash of the device, inode, size
+ * and modification time of the nodes.dmp, include and skip files
+ */
+uint64_t taxSetKey(char *dirName, char *include, char *skip) {
+    char *files[3], *nodes;
+    int64_t fields[4];
+    struct stat st;
+    uint64_t key = 14695981039346656037ULL;
+    int i;
+    size_t j;
+
+    nodes = allocate(sizeof (char) * (strlen(dirName) + 20), __FILE__, __LINE__);
+    sprintf(nodes, "%s/nodes.dmp", dirName);
+    files[0] = nodes;
+    files[1] = include;
+    files[2] = skip;
+    for (i = 0; i < 3; i++) {
+        memset(fields, 0, sizeof (fields));
+        if (files[i] && stat(files[i], &st) == 0) {
+            fields[0] = st.st_dev;
+            fields[1] = st.st_ino;
+            fields[2] = st.st_size;
+            fields[3] = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+        }
+        for (j = 0; j < sizeof (fields); j++) {
+            key = (key ^ ((unsigned char *) fields)[j]) * 1099511628211ULL;
+        }
+    }
+    free(nodes);
+    return key;
+}
+
+/*
+ * Return the set of taxonomies to include: the ones with any include
+ * taxId in their lineage minus the ones in the skip file. If cache is not
+ * NULL the set is read from it when it was built from the same files, 
+ * otherwise it is built and saved there
+ */
+Bitset_t *TaxsToInclude(char *dirName, char *include, char *skip, char *cache, int threads, int verbose) {
+    int i, toInNumber, toSkNumber = 0;
+    int *toInTaxId, *toSkTaxId = NULL;
+    TaxonomyTable_t *taxDB = NULL;
+    Bitset_t *taxIn, *taxSkip;
+    char *mark;
+    uint64_t key = 0;
+
+    if (cache) {
+        key = taxSetKey(dirName, include, skip);
+        if ((taxIn = bitsetRead(cache, key)) != NULL) {
+            if (verbose) {
+                printf("Taxonomies to include read from the cache: %s\n", cache);
+                fflush(stdout);
+            }
+            return taxIn;
+        }
+    }
 
-    fd2 = NULL;
-    fd1 = checkPointerError(fopen(include, "r"), "Can't open include file", __FILE__, __LINE__, -1);
-    if (skip)
-        fd2 = checkPointerError(fopen(skip, "r"), "Can't open skip file", __FILE__, __LINE__, -1);
+    taxDB = TaxonomyTableLoad(dirName, threads, verbose);
 
     if (verbose) {
-        printf("Extracting the records to array\n");
+        printf("Extracting the taxonomies to include\n");
         fflush(stdout);
     }
 
-    while ((read = getline(&line, &len, fd1)) != -1) {
-        value = allocate(sizeof (int), __FILE__, __LINE__);
-        sscanf(line, "%d", value);
-        toInTaxId = BtreeInsert(toInTaxId, *value, value);
-    }
+    toInTaxId = readTaxIds(include, &toInNumber);
+    if (skip) toSkTaxId = readTaxIds(skip, &toSkNumber);
 
-    if (fd2) {
-        while ((read = getline(&line, &len, fd2)) != -1) {
-            value = allocate(sizeof (int), __FILE__, __LINE__);
-            sscanf(line, "%d", value);
-            toSkTaxId = BtreeInsert(toSkTaxId, *value, value);
-        }
+    TaxonomyTableEulerTour(taxDB);
+    mark = allocate(sizeof (char) * (taxDB->maxTaxId + 1), __FILE__, __LINE__);
+    TaxonomyTableDescendants(taxDB, toInTaxId, toInNumber, mark);
+    taxIn = bitsetCreate(taxDB->maxTaxId + 1);
+    for (i = 0; i <= taxDB->maxTaxId; i++) {
+        if (mark[i]) bitsetSet(taxIn, i);
+    }
+    taxSkip = bitsetCreate(taxDB->maxTaxId + 1);
+    for (i = 0; i < toSkNumber; i++) {
+        if (toSkTaxId[i] > 0) bitsetSet(taxSkip, toSkTaxId[i]);
     }
+    bitsetDifference(taxIn, taxSkip);
+    if (cache) bitsetWrite(taxIn, cache, key);
+
+    bitsetFree(taxSkip);
+    free(mark);
+    TaxonomyTableFree(taxDB);
+    if (toInTaxId) free(toInTaxId);
+    if (toSkTaxId) free(toSkTaxId);
+    return taxIn;
+}
 
-    BtreeRecordsToArray(&records, &records_number, taxDB);
-    for (i = 0; i < records_number; i++) {
-        lineage = NULL;
-        lineage_number = 0;
-        tax = ((taxonomy_l) records[i]);
-
-        if (BTreeFind(toSkTaxId, tax->taxId, false) == NULL) {
-
-            tax->getLineage(tax, &lineage, &lineage_number, taxDB);
-            for (j = 0; j < lineage_number; j++) {
-                if (BTreeFind(toInTaxId, lineage[j], false) != NULL) {
-                    value = allocate(sizeof (int), __FILE__, __LINE__);
-                    *value = tax->taxId;
-                    taxIn = BtreeInsert(taxIn, tax->taxId, value);
-                    break;
-                }
-            }
+/*
+ * Write all the bytes of the iovecs, retrying after partial writes
+ */
+void writevAll(int fd, struct iovec *iov, int iovcnt) {
+    ssize_t bytes;
 
-            free(lineage);
+    while (iovcnt > 0) {
+        bytes = writev(fd, iov, iovcnt);
+        if (bytes < 0) {
+            checkPointerError(NULL, "Can't write to the output file", __FILE__, __LINE__, -1);
+        }
+        while (iovcnt > 0 && (size_t) bytes >= iov->iov_len) {
+            bytes -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *) iov->iov_base + bytes;
+            iov->iov_len -= bytes;
         }
     }
+}
 
-    tax = CreateTaxonomy();
-    BTreeFree(taxDB, tax->free);
-    tax->free(tax);
+/*
+ * Offset of the first line starting with '>' after the newline at from
+ * or size if there is not more entries
+ */
+off_t nextHeader(char *map, off_t from, off_t size) {
+    size_t lines = 0;
+    return from + findLineStart(map + from, size - from, '>', &lines);
+}
 
-    BTreeFree(toInTaxId, free);
-    BTreeFree(toSkTaxId, free);
-    if (records) {
-        free(records);
+/*
+ * Append the bytes [from, to) of the file in to the file out. The copy is
+ * done by the kernel, with sendfile if copy_file_range can't be used
+ * between the files
+ */
+void copyRange(int in, int out, off_t from, off_t to) {
+    ssize_t bytes;
+    bool copyFileRange = true;
+
+    while (from < to) {
+        bytes = -1;
+        if (copyFileRange) {
+            bytes = copy_file_range(in, &from, out, NULL, to - from, 0);
+            if (bytes < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                copyFileRange = false;
+                continue;
+            }
+        } else {
+            bytes = sendfile(out, in, &from, to - from);
+        }
+        if (bytes <= 0) {
+            checkPointerError(NULL, "Can't write to the output file", __FILE__, __LINE__, -1);
+        }
     }
-    if (line) free(line);
-    fclose(fd1);
-    if (fd2)fclose(fd2);
-    return taxIn;
+}
+
+/*
+ * Open the output file number count for writing
+ */
+int openOutput(char *name, char *output, int count, int flags, int verbose) {
+    int fd;
+
+    sprintf(name, "%s_%d.fasta", output, count);
+    if (verbose) printf("Creating a new file: %s\n", name);
+    fd = open(name, O_WRONLY | flags, 0644);
+    if (fd < 0) checkPointerError(NULL, "Can't open output file", __FILE__, __LINE__, -1);
+    return fd;
 }
 
 void *pthreadTaxFilter(void *arg) {
     thread_param_t *parms = ((thread_param_t*) arg);
+    char *map = parms->map, *nl;
+    Bitset_t *taxIn = parms->taxIn;
+    GiTaxMap_t *gi_tax = parms->gi_tax;
+    BtreeImage_t *gi_taxImage = parms->gi_taxImage;
+    AccTaxMap_t *acc_tax = parms->acc_tax;
+    taxfilter_entry_t entries[TAXFILTER_BATCH], *entry;
+    char *accessions[TAXFILTER_BATCH];
+    int gis[TAXFILTER_BATCH], lengths[TAXFILTER_BATCH], taxIds[TAXFILTER_BATCH];
+    const char *accession;
+    int *value;
+    int fd, i, n;
+    char header[64], prefix[64];
+    char *buffer = allocate(sizeof (char) * TAXFILTER_BUFFER, __FILE__, __LINE__);
+    size_t size = 0, len, headerLen, seqLen;
+    off_t pos, page = sysconf(_SC_PAGESIZE);
+    struct iovec iov[3];
+
+    fd = open(parms->out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) checkPointerError(NULL, "Can't open output file", __FILE__, __LINE__, -1);
+
+    if (parms->end > parms->start) {
+        pos = parms->start - parms->start % page;
+        madvise(map + pos, parms->end - pos, MADV_SEQUENTIAL);
+    }
 
-    FILE *fd1 = checkPointerError(fopen(parms->in, "r"), "Can't open include file", __FILE__, __LINE__, -1);
-    FILE *fd2 = checkPointerError(fopen(parms->out, "w"), "Can't open include file", __FILE__, __LINE__, -1);
-    BtreeNode_t *taxIn = parms->taxIn;
-    BtreeNode_t *gi_tax = parms->gi_tax;
-    BtreeRecord_t *rec;
-
-    int bufferSize, excludeSeq, gi, ends;
-    size_t buf_size;
-    char *buffer, *line, *str;
-    int numLines, header;
-
-    off_t pos;
-
+    /* The first entry that starts in the range */
     pos = parms->start;
-    fseeko(fd1, parms->start, SEEK_SET);
-
-    bufferSize = 8000000;
-    if (parms->end - parms->start < bufferSize)
-        bufferSize = parms->end - parms->start;
-
-    excludeSeq = 1;
-    buf_size = sizeof (char) * bufferSize;
-    buffer = allocate(sizeof (char) * (bufferSize + 1), __FILE__, __LINE__);
-    numLines = ends = header = 0;
-    gi = -1;
-    while (!feof(fd1)) {
-        memset(buffer, 0, buf_size);
-        if (fread(buffer, buf_size, 1, fd1) == 1) {
-            buffer[bufferSize] = '\0';
+    if (pos < parms->end && (pos > 0 || map[0] != '>')) {
+        pos = nextHeader(map, (pos > 0) ? pos - 1 : 0, parms->size);
+    }
+
+    while (pos < parms->end) {
+        /* Parse the headers of a block of entries */
+        for (n = 0; n < TAXFILTER_BATCH && pos < parms->end; n++) {
+            entry = &entries[n];
+            nl = memchr(map + pos, '\n', parms->size - pos);
+            entry->pos = pos;
+            entry->hasSeq = (nl != NULL);
+            entry->headerEnd = (nl != NULL) ? nl - map : parms->size;
+            entry->next = (nl != NULL) ? nextHeader(map, entry->headerEnd, parms->size) : parms->size;
+            gis[n] = -1;
+            if (acc_tax) {
+                lengths[n] = AccessionFromHeader(map + pos, entry->headerEnd - pos, &accession);
+                accessions[n] = (char *) accession;
+            } else {
+                /* The mapped header is not NUL terminated */
+                len = (entry->headerEnd - pos < (off_t) sizeof (prefix) - 1) ? entry->headerEnd - pos : sizeof (prefix) - 1;
+                memcpy(prefix, map + pos, len);
+                prefix[len] = '\0';
+                if (sscanf(prefix, ">gi|%d|", &gis[n]) != 1) gis[n] = -1;
+            }
+            pos = entry->next;
         }
-        str = buffer;
-        while (1) {
-            line = strchr(str, '\n');
-            if (line) *line = '\0';
-            if (*str != '\0') {
-                if (*str == '>' || header) {
-                    if (ends == 2) {
-                        ends = 3;
-                        break;
-                    }
-                    if (!header) {
-                        excludeSeq = 1;
-                        sscanf(str, ">gi|%d|", &gi);
-                        if ((rec = BTreeFind(gi_tax, gi, false)) != NULL) {
-                            if ((rec = BTreeFind(taxIn, *((int *) rec->value), false)) != NULL) {
-                                fprintf(fd2, ">%d;%d\n", gi, *((int *) rec->value));
-                                excludeSeq = 0;
-                            }
-                        }
-                    }
-                    if (line) {
-                        header = 0;
-                    } else {
-                        header = 1;
-                    }
-                } else {
-                    if (gi != -1 && !excludeSeq) {
-                        fprintf(fd2, "%s", str);
-                        if (line) {
-                            fprintf(fd2, "\n");
-                        }
-                    }
-                }
+
+        /* The taxIds of the block */
+        if (acc_tax) {
+            AccTaxMapFindBatch(acc_tax, accessions, lengths, n, taxIds);
+        } else if (gi_taxImage) {
+            for (i = 0; i < n; i++) {
+                taxIds[i] = -1;
+                if (gis[i] != -1 && (value = BtreeImageFind(gi_taxImage, gis[i])) != NULL) taxIds[i] = *value;
             }
-            if (!line) break;
-            str = line + 1;
-            numLines++;
+        } else {
+            GiTaxMapFindBatch(gi_tax, gis, n, taxIds);
         }
-        if (ends == 1) ends = 2;
-        pos = ftello(fd1);
-        if (buf_size >= parms->end - pos && ends == 0) {
-            bufferSize = parms->end - pos;
-            buf_size = sizeof (char) * bufferSize;
-            ends = 1;
+
+        for (i = 0; i < n; i++) {
+            if (taxIds[i] <= 0 || !bitsetTest(taxIn, taxIds[i])) continue;
+            entry = &entries[i];
+            /* The new header and the sequence lines as they are in the file */
+            if (acc_tax) {
+                headerLen = sprintf(header, ">%.*s;%d\n", lengths[i], accessions[i], taxIds[i]);
+            } else {
+                headerLen = sprintf(header, ">%d;%d\n", gis[i], taxIds[i]);
+            }
+            seqLen = (entry->hasSeq) ? entry->next - entry->headerEnd - 1 : 0;
+            if (parms->recordsNumber == parms->recordsCapacity) {
+                parms->recordsCapacity = (parms->recordsCapacity == 0) ? 1024 : parms->recordsCapacity * 2;
+                parms->records = reallocate(parms->records, sizeof (off_t) * parms->recordsCapacity, __FILE__, __LINE__);
+            }
+            parms->records[parms->recordsNumber++] = parms->written + size;
+            if (size + headerLen + seqLen <= TAXFILTER_BUFFER) {
+                memcpy(buffer + size, header, headerLen);
+                memcpy(buffer + size + headerLen, map + entry->headerEnd + 1, seqLen);
+                size += headerLen + seqLen;
+            } else {
+                iov[0].iov_base = buffer;
+                iov[0].iov_len = size;
+                iov[1].iov_base = header;
+                iov[1].iov_len = headerLen;
+                iov[2].iov_base = map + entry->headerEnd + 1;
+                iov[2].iov_len = seqLen;
+                writevAll(fd, iov, 3);
+                parms->written += size + headerLen + seqLen;
+                size = 0;
+            }
         }
-        if (ends == 3) break;
+    }
+    if (size > 0) {
+        iov[0].iov_base = buffer;
+        iov[0].iov_len = size;
+        writevAll(fd, iov, 1);
+        parms->written += size;
     }
     free(buffer);
-    fclose(fd1);
-    fclose(fd2);
+    close(fd);
     return NULL;
 }
 
@@ -226,24 +406,26 @@ void *pthreadTaxFilter(void *arg) {
 int main(int argc, char** argv) {
     struct timespec start, stop, mid;
     int i, next_option, verbose, count, pthreads;
-    const char* const short_options = "vhn:o:t:d:s:i:p:";
-    char *ntName, *output, *taxgiName, *tmp, *dirName, *skipName, *includeName;
+    const char* const short_options = "vhn:o:t:d:s:i:c:p:";
+    char *ntName, *output, *taxgiName, *tmp, *dirName, *skipName, *includeName, *cacheName;
 
-    FILE *fd1, *fd2;
-    off_t tot, perThread;
+    int fd1, fd2;
+    size_t r;
+    off_t tot, perThread, from;
+    int ntFd;
+    struct stat ntStat;
+    char *ntMap = NULL;
 
     pthread_t *threads;
     thread_param_t *tp;
     int thread_join_res;
 
-    BtreeNode_t *taxIn = NULL;
-    BtreeNode_t *gi_tax = NULL;
+    Bitset_t *taxIn = NULL;
+    GiTaxMap_t *gi_tax = NULL;
+    BtreeImage_t *gi_taxImage = NULL;
+    AccTaxMap_t *acc_tax = NULL;
     long long int countWords;
 
-    int bufferSize;
-    size_t buf_size;
-    char *buffer, *line, *str;
-
     clock_gettime(CLOCK_MONOTONIC, &start);
     program_name = argv[0];
 
@@ -256,13 +438,14 @@ int main(int argc, char** argv) {
         { "dir", 1, NULL, 'd'},
         { "skip", 1, NULL, 's'},
         { "include", 1, NULL, 'i'},
+        { "cache", 1, NULL, 'c'},
         { "threads", 1, NULL, 'p'},
         { NULL, 0, NULL, 0} /* Required at end of array.  */
     };
 
     pthreads = 2;
     verbose = 0;
-    ntName = output = taxgiName = dirName = skipName = includeName = NULL;
+    ntName = output = taxgiName = dirName = skipName = includeName = cacheName = NULL;
     do {
         next_option = getopt_long(argc, argv, short_options, long_options, NULL);
 
@@ -298,6 +481,10 @@ int main(int argc, char** argv) {
                 includeName = strdup(optarg);
                 break;
 
+            case 'c':
+                cacheName = strdup(optarg);
+                break;
+
             case 'p':
                 pthreads = atoi(optarg);
                 break;
@@ -313,31 +500,46 @@ int main(int argc, char** argv) {
     threads = allocate(sizeof (pthread_t) * pthreads, __FILE__, __LINE__);
     tp = allocate(sizeof (thread_param_t) * pthreads, __FILE__, __LINE__);
 
-    taxIn = TaxsToInclude(dirName, includeName, skipName, verbose);
+    taxIn = TaxsToInclude(dirName, includeName, skipName, cacheName, pthreads, verbose);
 
     clock_gettime(CLOCK_MONOTONIC, &mid);
     if (verbose) {
         printf("Reading the Taxonomy-Nucleotide database ... ");
         fflush(stdout);
     }
-    gi_tax = TaxonomyNuclIndex(taxgiName, verbose);
+    if (GiTaxMapCheck(taxgiName)) {
+        gi_tax = GiTaxMapOpen(taxgiName);
+    } else if (AccTaxMapCheck(taxgiName)) {
+        acc_tax = AccTaxMapOpen(taxgiName);
+    } else if (BtreeImageCheck(taxgiName)) {
+        gi_taxImage = BtreeImageOpen(taxgiName, sizeof (int));
+    } else if (AccTaxMapCheckText(taxgiName)) {
+        acc_tax = AccTaxMapLoad(taxgiName, verbose);
+    } else {
+        gi_tax = GiTaxMapLoad(taxgiName, pthreads, verbose);
+        if (gi_tax->header->count == 0) {
+            checkPointerError(NULL, "There are not Gis in the gi-taxids file", __FILE__, __LINE__, -1);
+        }
+    }
     clock_gettime(CLOCK_MONOTONIC, &stop);
     if (verbose) {
         printf("%.1f sec\n", timespecDiffSec(&stop, &mid));
         fflush(stdout);
     }
      
-    count = countWords = 0;
-    fd1 = checkPointerError(fopen(ntName, "r"), "Can't open include file", __FILE__, __LINE__, -1);
     tmp = allocate(sizeof (char) * (strlen(output) + 100), __FILE__, __LINE__);
-    sprintf(tmp, "%s_%d.fasta", output, count);
-    if (verbose) printf("Creating a new file: %s\n", tmp);
-    fd2 = checkPointerError(fopen(tmp, "w"), "Can't open output file", __FILE__, __LINE__, -1);
 
-    fseeko(fd1, 0, SEEK_END);
-    tot = ftello(fd1);
-    fseeko(fd1, 0, SEEK_SET);
-    fclose(fd1);
+    /* The threads read their ranges from a shared read-only mapping */
+    ntFd = open(ntName, O_RDONLY);
+    if (ntFd < 0 || fstat(ntFd, &ntStat) != 0) {
+        checkPointerError(NULL, "Can't open the nt file", __FILE__, __LINE__, -1);
+    }
+    tot = ntStat.st_size;
+    if (tot > 0) {
+        ntMap = mmap(NULL, tot, PROT_READ, MAP_PRIVATE, ntFd, 0);
+        if (ntMap == MAP_FAILED) checkPointerError(NULL, "Can't map the nt file", __FILE__, __LINE__, -1);
+    }
+    close(ntFd);
 
     perThread = tot / pthreads;
 
@@ -348,10 +550,16 @@ int main(int argc, char** argv) {
         tp[i].number = i;
         tp[i].out = allocate(sizeof (char) * (strlen(output) + 20), __FILE__, __LINE__);
         sprintf(tp[i].out, "%s_%d_p.fasta", output, i);
-        tp[i].in = ntName;
+        tp[i].map = ntMap;
+        tp[i].size = tot;
         tp[i].gi_tax = gi_tax;
+        tp[i].gi_taxImage = gi_taxImage;
+        tp[i].acc_tax = acc_tax;
         tp[i].taxIn = taxIn;
         tp[i].verbose = verbose;
+        tp[i].records = NULL;
+        tp[i].recordsNumber = tp[i].recordsCapacity = 0;
+        tp[i].written = 0;
         tp[i].start = i * perThread;
         if (i == pthreads - 1) {
             tp[i].end = tot;
@@ -361,71 +569,76 @@ int main(int argc, char** argv) {
         pthread_create(&threads[i], NULL, pthreadTaxFilter, (void*) &(tp[i]));
     }
 
-    bufferSize = 8000000;
-    buf_size = sizeof (char) * bufferSize;
-    buffer = allocate(sizeof (char) * (bufferSize + 1), __FILE__, __LINE__);
-
     for (i = 0; i < pthreads; i++) {
         thread_join_res = pthread_join(threads[i], NULL);
         if (thread_join_res != 0) {
             checkPointerError(NULL, "JOIN ERROR", __FILE__, __LINE__, -1);
-        } else {
-            printf("Thread %d ends\n", i);
-            fd1 = checkPointerError(fopen(tp[i].out, "r"), "Can't open include file", __FILE__, __LINE__, -1);
-            while (!feof(fd1)) {
-                memset(buffer, 0, buf_size);
-                if (fread(buffer, buf_size, 1, fd1) == 1) {
-                    buffer[bufferSize] = '\0';
-                }
-
-                str = buffer;
-                while (1) {
-                    line = strchr(str, '\n');
-                    if (line) *line = '\0';
-                    if (*str != '\0') {
-                        if (*str == '>') {
-                            if (countWords > 4294967296) {
-                                count++;
-                                countWords = 0;
-                                fclose(fd2);
-                                sprintf(tmp, "%s_%d.fasta", output, count);
-                                if (verbose) printf("Creating a new file: %s\n", tmp);
-                                fd2 = checkPointerError(fopen(tmp, "w"), "Can't open output file", __FILE__, __LINE__, -1);
-                            }
-                            countWords += strlen(str);
-                            fprintf(fd2, "%s", str);
-                            if (line) {
-                                countWords++;
-                                fprintf(fd2, "\n");
-                            }
-                        } else {
-                            countWords += strlen(str);
-                            fprintf(fd2, "%s", str);
-                            if (line) {
-                                countWords++;
-                                fprintf(fd2, "\n");
-                            }
-                        }
-                    }
-                    if (!line) break;
-                    str = line + 1;
-                }
+        }
+        printf("Thread %d ends\n", i);
+    }
+
+    /*
+     * The thread files are concatenated in order, a new output file is
+     * started before the entry that finds the current one with more than
+     * TAXFILTER_FILE_SIZE bytes. If the first thread file is not split it
+     * becomes the first output file
+     */
+    count = 0;
+    i = 0;
+    countWords = 0;
+    sprintf(tmp, "%s_%d.fasta", output, count);
+    if (tp[0].recordsNumber == 0 || tp[0].records[tp[0].recordsNumber - 1] <= TAXFILTER_FILE_SIZE) {
+        if (rename(tp[0].out, tmp) != 0) {
+            checkPointerError(NULL, "Can't rename the thread file", __FILE__, __LINE__, -1);
+        }
+        if (verbose) printf("Creating a new file: %s\n", tmp);
+        /* copy_file_range does not accept O_APPEND */
+        fd2 = open(tmp, O_WRONLY);
+        if (fd2 < 0 || lseek(fd2, 0, SEEK_END) < 0) {
+            checkPointerError(NULL, "Can't open output file", __FILE__, __LINE__, -1);
+        }
+        countWords = tp[0].written;
+        i = 1;
+    } else {
+        fd2 = openOutput(tmp, output, count, O_CREAT | O_TRUNC, verbose);
+    }
+    for (; i < pthreads; i++) {
+        fd1 = open(tp[i].out, O_RDONLY);
+        if (fd1 < 0) checkPointerError(NULL, "Can't open the thread file", __FILE__, __LINE__, -1);
+        from = 0;
+        for (r = 0; r < tp[i].recordsNumber; r++) {
+            if (countWords + tp[i].records[r] - from > TAXFILTER_FILE_SIZE) {
+                copyRange(fd1, fd2, from, tp[i].records[r]);
+                close(fd2);
+                fd2 = openOutput(tmp, output, ++count, O_CREAT | O_TRUNC, verbose);
+                countWords = 0;
+                from = tp[i].records[r];
             }
-            fclose(fd1);
         }
+        copyRange(fd1, fd2, from, tp[i].written);
+        countWords += tp[i].written - from;
+        close(fd1);
+        unlink(tp[i].out);
+    }
+    close(fd2);
+    for (i = 0; i < pthreads; i++) {
+        if (tp[i].records) free(tp[i].records);
         free(tp[i].out);
     }
     free(tp);
+    if (ntMap) munmap(ntMap, tot);
     if (threads) free(threads);
     if (tmp) free(tmp);
-    BTreeFree(gi_tax, free);
-    BTreeFree(taxIn, free);
-    if (fd2) fclose(fd2);
+    GiTaxMapFree(gi_tax);
+    BtreeImageClose(gi_taxImage);
+    AccTaxMapFree(acc_tax);
+    bitsetFree(taxIn);
     if (dirName) free(dirName);
     if (output) free(output);
     if (ntName) free(ntName);
     if (taxgiName) free(taxgiName);
     if (includeName) free(includeName);
+    if (cacheName) free(cacheName);
     if (skipName) free(skipName);
     clock_gettime(CLOCK_MONOTONIC, &stop);
     printf("\n\tThe total time was %.1f sec\n\n", timespecDiffSec(&stop, &start));
@@ -11,8 +11,11 @@
 #include <getopt.h>
 #include <stdbool.h>
 #include <time.h>
+#include <pthread.h>
+#include <zlib.h>
 #include "btree.h"
 #include "btime.h"
+#include "bzreader.h"
 #include "berror.h"
 #include "bmemory.h"
 #include "bstring.h"
@@ -20,6 +23,9 @@
 
 char *program_name;
 
+/* Number of Gis resolved together with BTreeFindBatch */
+#define GI_BATCH 4096
+
 void print_usage(FILE *stream, int exit_code) {
     fprintf(stream, "\n********************************************************************************\n");
     fprintf(stream, "\nUsage: %s \n", program_name);
@@ -35,48 +41,70 @@ void print_usage(FILE *stream, int exit_code) {
     exit(0);
 }
 
-int getPrintIndex(char *rank, int useNoRank) {
-    if (strcmp(rank, "no rank") == 0 && useNoRank) {
-        return 0;
-    } else if (strcmp(rank, "species") == 0) {
-        return 1;
-    } else if (strcmp(rank, "genus") == 0) {
-        return 2;
-    } else if (strcmp(rank, "family") == 0) {
-        return 3;
-    } else if (strcmp(rank, "order") == 0) {
-        return 4;
-    } else if (strcmp(rank, "class") == 0) {
-        return 5;
-    } else if (strcmp(rank, "phylum") == 0) {
-        return 6;
-    } else if (strcmp(rank, "superkingdom") == 0) {
-        return 7;
+int getPrintIndex(int rank, int useNoRank) {
+    if (rank == TAXONOMY_RANK_NO_RANK) {
+        return useNoRank ? 0 : -1;
+    } else if (rank < TAXONOMY_RANK_FIXED) {
+        return rank;
     }
     return -1;
 }
 
+/*
+ * Print the lineage of the taxonomy if it was not printed before
+ */
+void printLineage(FILE *fd, TaxonomyTable_t *taxDB, int taxId, char *printed, char **lineToPrint) {
+    int i, index, parentTaxId;
+    int *lineage = NULL;
+    int lineage_count = 0;
+
+    if (!printed[taxId]) {
+        printed[taxId] = 1;
+        for (i = 0; i < 8; i++) {
+            lineToPrint[i][0] = '\t';
+            lineToPrint[i][1] = '\0';
+        }
+        index = getPrintIndex(taxDB->nodes[taxId].rank, 1);
+        if (index != -1) {
+            sprintf(lineToPrint[index], "%s (%d)\t", TaxonomyTableName(taxDB, taxId), taxId);
+        }
+        parentTaxId = taxDB->nodes[taxId].parentTaxId;
+        if (TaxonomyTableContains(taxDB, parentTaxId)) {
+            TaxonomyTableLineage(taxDB, parentTaxId, &lineage, &lineage_count);
+            for (i = 0; i < lineage_count; i++) {
+                index = getPrintIndex(taxDB->nodes[lineage[i]].rank, 0);
+                if (index != -1) {
+                    sprintf(lineToPrint[index], "%s (%d)\t", TaxonomyTableName(taxDB, lineage[i]), lineage[i]);
+                }
+            }
+            for (i = 0; i < 8; i++) {
+                fprintf(fd, "%s", lineToPrint[i]);
+            }
+            fprintf(fd, "\n");
+            free(lineage);
+        }
+    }
+}
+
 /*
  * 
  */
 int main(int argc, char** argv) {
-    taxonomy_l tax;
     struct timespec start, stop, mid;
-    int i, next_option, verbose, gi;
+    int i, next_option, verbose, gi, n, taxId;
     const char* const short_options = "vhd:o:g:";
     char *dir, *output, *taxgi, *giName;
-    FILE *gis;
+    ZReader_t *gis;
     FILE *fd;
-    BtreeNode_t *taxDB = NULL;
+    TaxonomyTable_t *taxDB = NULL;
     BtreeNode_t *gi_tax = NULL;
-    BtreeNode_t *foundTax = NULL;
-    BtreeRecord_t *rec;
+    char *printed = NULL;
     char *line = NULL;
     size_t len = 0;
     ssize_t read;
-    int *lineage = NULL;
-    int lineage_count = 0;
     char **lineToPrint = NULL;
+    int *giBatch;
+    BtreeRecord_t **giRecs;
 
     clock_gettime(CLOCK_MONOTONIC, &start);
     program_name = argv[0];
@@ -125,17 +153,13 @@ int main(int argc, char** argv) {
     taxgi = allocate(sizeof (char) * (strlen(dir) + 31), __FILE__, __LINE__);
     sprintf(taxgi, "%s/gi_taxid_nucl.dmp.gz", dir);
 
-    gis = checkPointerError(fopen(giName, "r"), "Can't open the Gi file", __FILE__, __LINE__, -1);
+    gis = zreaderOpen(giName);
 
-    clock_gettime(CLOCK_MONOTONIC, &mid);
-    if (verbose) printf("Reading the Taxonomy database ... ");
-    fflush(stdout);
-    taxDB = TaxonomyDBIndex(dir, verbose);
-    clock_gettime(CLOCK_MONOTONIC, &stop);
-    if (verbose) printf("%.1f sec\n", timespecDiffSec(&stop, &mid));
-    fflush(stdout);
+    taxDB = TaxonomyTableLoad(dir, 0, verbose);
 
-    printf("The Btree has a height of %d\n", BTreeHeight(taxDB));
+    printf("The Taxonomy table has %d taxonomies\n", taxDB->count);
+    printed = allocate(sizeof (char) * (taxDB->maxTaxId + 1), __FILE__, __LINE__);
+    memset(printed, 0, sizeof (char) * (taxDB->maxTaxId + 1));
 
     clock_gettime(CLOCK_MONOTONIC, &mid);
     if (verbose) printf("Reading the Taxonomy-Nucleotide database ... ");
@@ -154,57 +178,40 @@ int main(int argc, char** argv) {
         lineToPrint[i][1] = '\0';
     }
     fprintf(fd, "strain\tspecies\tgenus\tfamily\torder\tclass\tphylum\tsuperkingdom\n");
-    while ((read = getline(&line, &len, gis)) != -1) {
-        sscanf(line, "%d\n", &gi);
-        if ((rec = BTreeFind(gi_tax, gi, false)) != NULL) {
-            if ((rec = BTreeFind(taxDB, *((int *) rec->value), false)) != NULL) {
-                tax = (taxonomy_l) rec->value;
-                if (BTreeFind(foundTax, tax->taxId, false) == NULL) {
-                    foundTax = BtreeInsert(foundTax, tax->taxId, tax);
-                    for (i = 0; i < 8; i++) {
-                        lineToPrint[i][0] = '\t';
-                        lineToPrint[i][1] = '\0';
-                    }
-                    next_option = getPrintIndex(tax->rank, 1);
-                    if (next_option != -1) {
-                        sprintf(lineToPrint[next_option], "%s (%d)\t", tax->name, tax->taxId);
-                    }
-                    if ((rec = BTreeFind(taxDB, tax->parentTaxId, false)) != NULL) {
-                        tax = (taxonomy_l) rec->value;
-                        tax->getLineage(tax, &lineage, &lineage_count, taxDB);
-                        for (i = 0; i < lineage_count; i++) {
-                            if ((rec = BTreeFind(taxDB, lineage[i], false)) != NULL) {
-                                tax = (taxonomy_l) rec->value;
-                                next_option = getPrintIndex(tax->rank, 0);
-                                if (next_option != -1) {
-                                    sprintf(lineToPrint[next_option], "%s (%d)\t", tax->name, tax->taxId);
-                                }
-                            }
-                        }
-                        for (i = 0; i < 8; i++) {
-                            fprintf(fd, "%s", lineToPrint[i]);
-                        }
-                        fprintf(fd, "\n");
-                        free(lineage);
-                        lineage = NULL;
-                        lineage_count = 0;
+    giBatch = allocate(sizeof (int) * GI_BATCH, __FILE__, __LINE__);
+    giRecs = allocate(sizeof (BtreeRecord_t *) * GI_BATCH, __FILE__, __LINE__);
+    gi = n = 0;
+    do {
+        if ((read = zreaderGetline(&line, &len, gis)) != -1) {
+            sscanf(line, "%d\n", &gi);
+            giBatch[n++] = gi;
+        }
+        if (n == GI_BATCH || (read == -1 && n != 0)) {
+            /* Resolve the Gis in batches */
+            BTreeFindBatch(gi_tax, giBatch, n, giRecs);
+            for (i = 0; i < n; i++) {
+                if (giRecs[i] != NULL) {
+                    taxId = *((int *) giRecs[i]->value);
+                    if (TaxonomyTableContains(taxDB, taxId)) {
+                        printLineage(fd, taxDB, taxId, printed, lineToPrint);
                     }
                 }
             }
+            n = 0;
         }
-    }
+    } while (read != -1);
+    free(giBatch);
+    free(giRecs);
 
-    tax = CreateTaxonomy();
-    BTreeFree(taxDB, tax->free);
-    BTreeFree(gi_tax, free);
-    BTreeFree(foundTax, NULL);
-    tax->free(tax);
+    TaxonomyTableFree(taxDB);
+    TaxonomyNuclFree(gi_tax);
+    free(printed);
 
     freeArrayofPointers((void **)lineToPrint, 8);
     if (fd) fclose(fd);
     if (line) free(line);
     if (giName) free(giName);
-    if (gis) fclose(gis);
+    if (gis) zreaderClose(gis);
     if (taxgi) free(taxgi);
     if (dir) free(dir);
     if (output) free(output);
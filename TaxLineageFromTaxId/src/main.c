@@ -11,8 +11,11 @@
 #include <getopt.h>
 #include <stdbool.h>
 #include <time.h>
+#include <pthread.h>
+#include <zlib.h>
 #include "btree.h"
 #include "btime.h"
+#include "bzreader.h"
 #include "berror.h"
 #include "bmemory.h"
 #include "bstring.h"
@@ -35,23 +38,11 @@ void print_usage(FILE *stream, int exit_code) {
     exit(0);
 }
 
-int getPrintIndex(char *rank, int useNoRank) {
-    if (strcmp(rank, "no rank") == 0 && useNoRank) {
-        return 0;
-    } else if (strcmp(rank, "species") == 0) {
-        return 1;
-    } else if (strcmp(rank, "genus") == 0) {
-        return 2;
-    } else if (strcmp(rank, "family") == 0) {
-        return 3;
-    } else if (strcmp(rank, "order") == 0) {
-        return 4;
-    } else if (strcmp(rank, "class") == 0) {
-        return 5;
-    } else if (strcmp(rank, "phylum") == 0) {
-        return 6;
-    } else if (strcmp(rank, "superkingdom") == 0) {
-        return 7;
+int getPrintIndex(int rank, int useNoRank) {
+    if (rank == TAXONOMY_RANK_NO_RANK) {
+        return useNoRank ? 0 : -1;
+    } else if (rank < TAXONOMY_RANK_FIXED) {
+        return rank;
     }
     return -1;
 }
@@ -60,16 +51,14 @@ int getPrintIndex(char *rank, int useNoRank) {
  * 
  */
 int main(int argc, char** argv) {
-    taxonomy_l tax;
     struct timespec start, stop;
-    int i, next_option, verbose, taxId;
+    int i, next_option, verbose, taxId, parentTaxId;
     const char* const short_options = "vhd:o:t:";
     char *dir, *output, *taxIdsName;
-    FILE *taxids;
+    ZReader_t *taxids;
     FILE *fd;
-    BtreeNode_t *taxDB = NULL;
-    BtreeNode_t *foundTax = NULL;
-    BtreeRecord_t *rec;
+    TaxonomyTable_t *taxDB = NULL;
+    char *printed = NULL;
     char *line = NULL;
     size_t len = 0;
     ssize_t read;
@@ -122,12 +111,14 @@ int main(int argc, char** argv) {
 
     fd = checkPointerError(fopen(output, "w"), "Can't open output file", __FILE__, __LINE__, -1);
 
-    taxids = checkPointerError(fopen(taxIdsName, "r"), "Can't open the Gi file", __FILE__, __LINE__, -1);
+    taxids = zreaderOpen(taxIdsName);
 
-    taxDB = TaxonomyDBIndex(dir, verbose);
+    taxDB = TaxonomyTableLoad(dir, 0, verbose);
 
-    printf("The Btree has a height of %d\n", BTreeHeight(taxDB));
+    printf("The Taxonomy table has %d taxonomies\n", taxDB->count);
 
+    printed = allocate(sizeof (char) * (taxDB->maxTaxId + 1), __FILE__, __LINE__);
+    memset(printed, 0, sizeof (char) * (taxDB->maxTaxId + 1));
     lineToPrint = allocate(sizeof (char *) * 8, __FILE__, __LINE__);
     for (i = 0; i < 8; i++) {
         lineToPrint[i] = allocate(sizeof (char) * 1000, __FILE__, __LINE__);
@@ -135,30 +126,26 @@ int main(int argc, char** argv) {
         lineToPrint[i][1] = '\0';
     }
     fprintf(fd, "strain\tspecies\tgenus\tfamily\torder\tclass\tphylum\tsuperkingdom\n");
-    while ((read = getline(&line, &len, taxids)) != -1) {
+    while ((read = zreaderGetline(&line, &len, taxids)) != -1) {
         sscanf(line, "%d", &taxId);
-        if ((rec = BTreeFind(taxDB, taxId, false)) != NULL) {
-            tax = (taxonomy_l) rec->value;
-            if (BTreeFind(foundTax, tax->taxId, false) == NULL) {
-                foundTax = BtreeInsert(foundTax, tax->taxId, tax);
+        if (TaxonomyTableContains(taxDB, taxId)) {
+            if (!printed[taxId]) {
+                printed[taxId] = 1;
                 for (i = 0; i < 8; i++) {
                     lineToPrint[i][0] = '\t';
                     lineToPrint[i][1] = '\0';
                 }
-                next_option = getPrintIndex(tax->rank, 1);
+                next_option = getPrintIndex(taxDB->nodes[taxId].rank, 1);
                 if (next_option != -1) {
-                    sprintf(lineToPrint[next_option], "%s (%d)\t", tax->name, tax->taxId);
+                    sprintf(lineToPrint[next_option], "%s (%d)\t", TaxonomyTableName(taxDB, taxId), taxId);
                 }
-                if ((rec = BTreeFind(taxDB, tax->parentTaxId, false)) != NULL) {
-                    tax = (taxonomy_l) rec->value;
-                    tax->getLineage(tax, &lineage, &lineage_count, taxDB);
+                parentTaxId = taxDB->nodes[taxId].parentTaxId;
+                if (TaxonomyTableContains(taxDB, parentTaxId)) {
+                    TaxonomyTableLineage(taxDB, parentTaxId, &lineage, &lineage_count);
                     for (i = 0; i < lineage_count; i++) {
-                        if ((rec = BTreeFind(taxDB, lineage[i], false)) != NULL) {
-                            tax = (taxonomy_l) rec->value;
-                            next_option = getPrintIndex(tax->rank, 0);
-                            if (next_option != -1) {
-                                sprintf(lineToPrint[next_option], "%s (%d)\t", tax->name, tax->taxId);
-                            }
+                        next_option = getPrintIndex(taxDB->nodes[lineage[i]].rank, 0);
+                        if (next_option != -1) {
+                            sprintf(lineToPrint[next_option], "%s (%d)\t", TaxonomyTableName(taxDB, lineage[i]), lineage[i]);
                         }
                     }
                     for (i = 0; i < 8; i++) {
@@ -175,16 +162,14 @@ int main(int argc, char** argv) {
         }
     }
 
-    tax = CreateTaxonomy();
-    BTreeFree(taxDB, tax->free);
-    BTreeFree(foundTax, NULL);
-    tax->free(tax);
+    TaxonomyTableFree(taxDB);
+    free(printed);
 
     freeArrayofPointers((void **) lineToPrint, 8);
     if (fd) fclose(fd);
     if (line) free(line);
     if (taxIdsName) free(taxIdsName);
-    if (taxids) fclose(taxids);
+    if (taxids) zreaderClose(taxids);
     if (dir) free(dir);
     if (output) free(output);
     clock_gettime(CLOCK_MONOTONIC, &stop);
@@ -71,13 +71,14 @@ extern "C" {
      * @param fd the input file
      * @param score the score to be used as cutoff
      * @param fBtree the fasta btree index
+     * @param fImage the fasta btree index image or NULL to use fBtree
      * @param fFasta the fasta file
      * @param taxDB the NCBI Taxonomy db
      * @param readLenght length of the reads
      * @param readOffset offset used to overlap the reads
      * @param verbose 1 to print info
      */
-    extern void ParseTaxonerResult(char *output, char *rankToPrint, FILE *fd, float score, BtreeNode_t *fBtree, FILE * fFasta, BtreeNode_t *taxDB, int readLength, int readOffset, int verbose);
+    extern void ParseTaxonerResult(char *output, char *rankToPrint, FILE *fd, float score, BtreeNode_t *fBtree, BtreeImage_t *fImage, FILE * fFasta, BtreeNode_t *taxDB, int readLength, int readOffset, int verbose);
 
 
 #ifdef	__cplusplus
@@ -13,11 +13,14 @@
 #include <time.h>
 #include <zlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "btime.h"
 #include "berror.h"
 #include "bmemory.h"
 #include "bstring.h"
 #include "btree.h"
+#include "btreeimage.h"
+#include "bzindex.h"
 #include "fasta.h"
 #include "taxonomy.h"
 #include "taxoner.h"
@@ -33,8 +36,8 @@ void print_usage(FILE *stream, int exit_code) {
     fprintf(stream, "-i,   --input                       The input Taxoner out file (Taxonomy.txt)\n");
     fprintf(stream, "-o,   --output                      The output directory\n");
     fprintf(stream, "-t,   --tax                         The NCBI Taxonomy DB directory\n");
-    fprintf(stream, "-f,   --fasta                       Fasta file with the sequences\n");
-    fprintf(stream, "-n,   --index                       Fasta file index file (optional, it can be created by this program)\n");
+    fprintf(stream, "-f,   --fasta                       Fasta file with the sequences (plain or gzip)\n");
+    fprintf(stream, "-n,   --index                       Fasta file index file or B+ tree image (optional, it can be created by BuildBtreeIndexFasta)\n");
     fprintf(stream, "-s,   --score                       Cutoff score to use the read (default: 0.90)\n");
     fprintf(stream, "-l,   --readlength                  The length of the reads (default: 100)\n");
     fprintf(stream, "-z,   --readOffset                  The offset used to overlap the reads (default: 75)\n");
@@ -57,9 +60,12 @@ int main(int argc, char** argv) {
     char *input, *output, *fasta, *index, *taxDir, *giPattern;
     float score;
     FILE *fInput, *fFasta, *fIndex;
-    gzFile gInput, gFasta;
+    gzFile gInput;
+    ZIndex_t *zindex = NULL;
+    char *tmp;
     BtreeNode_t *taxDB = NULL;
     BtreeNode_t *fBtree = NULL;
+    BtreeImage_t *fImage = NULL;
     taxonomy_l tax;
     int readLength, readOffset;
     char *rankToPrint;
@@ -89,7 +95,7 @@ int main(int argc, char** argv) {
     verbose = gInputFlag = gFastaFlag = 0;
     input = output = fasta = index = taxDir = giPattern = NULL;
     fInput = fFasta = fIndex = NULL;
-    gInput = gFasta = NULL;
+    gInput = NULL;
     rankToPrint = NULL;
     do {
         next_option = getopt_long(argc, argv, short_options, long_options, NULL);
@@ -159,35 +165,41 @@ int main(int argc, char** argv) {
     if (!gFastaFlag) {
         fFasta = checkPointerError(fopen(fasta, "r"), "Can't open input file", __FILE__, __LINE__, -1);
     } else {
-        gFasta = checkPointerError(gzopen(fasta, "rb"), "Can't open the input file", __FILE__, __LINE__, -1);
+        /* The gzip random access index is next to the Gi index (or to the
+         * fasta file). Without it the access points are added while the
+         * file is read
+         */
+        tmp = allocate(sizeof (char) * (strlen((index) ? index : fasta) + strlen(ZINDEX_EXTENSION) + 1), __FILE__, __LINE__);
+        sprintf(tmp, "%s%s", (index) ? index : fasta, ZINDEX_EXTENSION);
+        if ((zindex = zindexRead(tmp)) == NULL) {
+            zindex = zindexCreate(ZINDEX_SPAN);
+        }
+        free(tmp);
+        fFasta = zindexOpen(fasta, zindex);
     }
-    if (index) {
+    if (index && BtreeImageCheck(index)) {
+        fImage = BtreeImageOpen(index, sizeof (off_t));
+    } else if (index) {
         fIndex = checkPointerError(fopen(index, "r"), "Can't open input file", __FILE__, __LINE__, -1);
         fBtree = CreateBtreeFromIndex(fIndex, verbose);
         fclose(fIndex);
     } else {
-        if (!gFastaFlag) {
-            fBtree = CreateBtreeFromFastawithPattern(fFasta, giPattern, verbose);
-        } else {
-            fBtree = CreateBtreeFromFastaGzip(gFasta, verbose);
-        }
+        fBtree = CreateBtreeFromFastawithPattern(fFasta, giPattern, verbose);
     }
     taxDB = TaxonomyDBIndex(taxDir, verbose);
 
-    ParseTaxonerResult(output, rankToPrint, fInput, score, fBtree, fFasta, taxDB, readLength, readOffset, verbose);
+    ParseTaxonerResult(output, rankToPrint, fInput, score, fBtree, fImage, fFasta, taxDB, readLength, readOffset, verbose);
 
     if (!gInputFlag) {
         fclose(fInput);
     } else {
         gzclose(gInput);
     }
-    if (!gFastaFlag) {
-        fclose(fFasta);
-    } else {
-        gzclose(gFasta);
-    }
+    fclose(fFasta);
+    zindexFree(zindex);
 
     BTreeFree(fBtree, free);
+    BtreeImageClose(fImage);
 
     tax = CreateTaxonomy();
     BTreeFree(taxDB, tax->free);
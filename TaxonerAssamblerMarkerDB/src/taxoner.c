@@ -11,11 +11,13 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <zlib.h>
 #include "berror.h"
 #include "bmemory.h"
 #include "bstring.h"
 #include "btree.h"
+#include "btreeimage.h"
 #include "btime.h"
 #include "fasta.h"
 #include "taxonomy.h"
@@ -112,18 +114,20 @@ taxoner_tax_l CreateTaxonerTax() {
  * @param outs array with the outputs files. [0] summary, [1] error
  * @param tax2 the input taxoner option
  * @param fBtree the fasta btree index
+ * @param fImage the fasta btree index image or NULL to use fBtree
  * @param fFasta the fasta file
  * @param taxDB the NCBI Taxonomy db * 
  * @param readLenght length of the reads
  * @param readOffset offset used to overlap the reads
  * @param verbose 1 to print info
  */
-void printTaxwithReads(FILE **outs, char **ids, int ids_number, taxoner_tax_l tax2, BtreeNode_t *fBtree, FILE * fFasta, BtreeNode_t *taxDB, int readLength, int readOffset, int verbose) {
+void printTaxwithReads(FILE **outs, char **ids, int ids_number, taxoner_tax_l tax2, BtreeNode_t *fBtree, BtreeImage_t *fImage, FILE * fFasta, BtreeNode_t *taxDB, int readLength, int readOffset, int verbose) {
     int j, k, i;
     taxoner_gi_l tmpTaxGi;
     taxonomy_l taxon;
     fasta_l fna;
     BtreeRecord_t *rec;
+    void *value;
     off_t offset;
     int nt, reads;
     int headerSize = 1000;
@@ -138,8 +142,14 @@ void printTaxwithReads(FILE **outs, char **ids, int ids_number, taxoner_tax_l ta
             fna = NULL;
             if ((rec = BTreeFind(taxDB, tax2->taxId, false)) != NULL) {
                 taxon = ((taxonomy_l) rec->value);
-                if ((rec = BTreeFind(fBtree, tmpTaxGi->gi, false)) != NULL) {
-                    offset = *((off_t *) rec->value);
+                value = NULL;
+                if (fImage) {
+                    value = BtreeImageFind(fImage, tmpTaxGi->gi);
+                } else if ((rec = BTreeFind(fBtree, tmpTaxGi->gi, false)) != NULL) {
+                    value = rec->value;
+                }
+                if (value != NULL) {
+                    offset = *((off_t *) value);
                     fseeko(fFasta, offset, SEEK_SET);
                     fna = ReadFasta(fFasta, 0);
                     nt = reads = 0;
@@ -190,7 +200,7 @@ void printTaxwithReads(FILE **outs, char **ids, int ids_number, taxoner_tax_l ta
     free(header);
 }
 
-void checkTaxForContReads(FILE **outs, char **ids, int ids_number, taxoner_tax_l tax, BtreeNode_t *fBtree, FILE * fFasta, BtreeNode_t *taxDB, int readLength, int readOffset, int verbose) {
+void checkTaxForContReads(FILE **outs, char **ids, int ids_number, taxoner_tax_l tax, BtreeNode_t *fBtree, BtreeImage_t *fImage, FILE * fFasta, BtreeNode_t *taxDB, int readLength, int readOffset, int verbose) {
     taxoner_tax_l tax2;
     taxoner_gi_l tmpTaxGi;
     BtreeRecord_t *rec;
@@ -267,7 +277,7 @@ void checkTaxForContReads(FILE **outs, char **ids, int ids_number, taxoner_tax_l
             tax2->gisIndex = BtreeInsert(tax2->gisIndex, tax2->gis[tax2->gis_numbers].gi, index);
         }
     }
-    printTaxwithReads(outs, ids, ids_number, tax2, fBtree, fFasta, taxDB, readLength, readOffset, verbose);
+    printTaxwithReads(outs, ids, ids_number, tax2, fBtree, fImage, fFasta, taxDB, readLength, readOffset, verbose);
     tax2->free(tax2);
 }
 
@@ -279,13 +289,14 @@ void checkTaxForContReads(FILE **outs, char **ids, int ids_number, taxoner_tax_l
  * @param fd the input file
  * @param score the score to be used as cutoff
  * @param fBtree the fasta btree index
+ * @param fImage the fasta btree index image or NULL to use fBtree
  * @param fFasta the fasta file
  * @param taxDB the NCBI Taxonomy db
  * @param readLenght length of the reads
  * @param readOffset offset used to overlap the reads
  * @param verbose 1 to print info
  */
-void ParseTaxonerResult(char *output, char *rankToPrint, FILE *fd, float score, BtreeNode_t *fBtree, FILE * fFasta, BtreeNode_t *taxDB, int readLength, int readOffset, int verbose) {
+void ParseTaxonerResult(char *output, char *rankToPrint, FILE *fd, float score, BtreeNode_t *fBtree, BtreeImage_t *fImage, FILE * fFasta, BtreeNode_t *taxDB, int readLength, int readOffset, int verbose) {
     int *index, lastTaxId;
     taxoner_tax_l tax;
     char *line = NULL;
@@ -341,7 +352,7 @@ void ParseTaxonerResult(char *output, char *rankToPrint, FILE *fd, float score,
         if (rScore >= score) {
             if (lastTaxId != taxId) {
                 if (tax) {
-                    checkTaxForContReads(outs, ids, ids_number, tax, fBtree, fFasta, taxDB, readLength, readOffset, verbose);
+                    checkTaxForContReads(outs, ids, ids_number, tax, fBtree, fImage, fFasta, taxDB, readLength, readOffset, verbose);
                     tax->free(tax);
                 }
                 tax = CreateTaxonerTax();
@@ -387,7 +398,7 @@ void ParseTaxonerResult(char *output, char *rankToPrint, FILE *fd, float score,
         }
     }
     if (tax) {
-        checkTaxForContReads(outs, ids, ids_number, tax, fBtree, fFasta, taxDB, readLength, readOffset, verbose);
+        checkTaxForContReads(outs, ids, ids_number, tax, fBtree, fImage, fFasta, taxDB, readLength, readOffset, verbose);
         tax->free(tax);
     }
     if (verbose) {
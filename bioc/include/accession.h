@@ -0,0 +1,202 @@
+/*
+ * File:   accession.h
+ * Author: roberto
+ *
+ * Created on Oct 19, 2026, 12:30 AM
+ */
+
+#ifndef ACCESSION_H
+#define	ACCESSION_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+    /*
+     * Accession.version to taxId index. An accession like NZ_CP012345.1 is
+     * split in its prefix (NZ_CP), its number (012345, 6 digits) and its
+     * version (1). The accessions with the same prefix and number of
+     * digits are a group and the index keeps the sorted groups with their
+     * first and last numbers. The key of an accession is the base of its
+     * group plus its number minus the first number of the group, where
+     * the base is 1 plus the ranges of the groups before it. So the keys
+     * are dense 64 bits integers even if the prefixes are not.
+     *
+     * The keys are stored in a GiTaxMap and the versions are packed with
+     * versionBits bits in the order of the keys. If an accession is
+     * repeated the latest version is kept.
+     *
+     * File: AccTaxMapHeader_t, the groups, the versions (uint64_t words)
+     * and the GiTaxMap file of the keys
+     */
+#define ACCTAXMAP_MAGIC "ACCTAXM"
+#define ACCTAXMAP_VERSION 1
+#define ACCESSION_PREFIX 16
+#define ACCESSION_DIGITS 12
+#define ACCESSION_LENGTH 40
+
+    typedef struct AccTaxMapHeader_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t versionBits;
+        uint64_t groups;
+        uint64_t count;
+        uint64_t size;
+    } AccTaxMapHeader_t;
+
+    typedef struct AccessionGroup_t {
+        char prefix[ACCESSION_PREFIX];
+        uint32_t digits;
+        uint32_t reserved;
+        uint64_t first;
+        uint64_t last;
+        uint64_t base;
+    } AccessionGroup_t;
+
+    /*
+     * keys points inside map, it is not freed with GiTaxMapFree
+     */
+    typedef struct AccTaxMap_t {
+        void *map;
+        size_t size;
+        int mapped;
+        AccTaxMapHeader_t *header;
+        AccessionGroup_t *groups;
+        uint64_t *versions;
+        GiTaxMap_t keys;
+    } AccTaxMap_t;
+
+    /**
+     * Split an accession in its prefix, number and version
+     *
+     * @param accession the accession (it does not need to end with '\0')
+     * @param length the accession length
+     * @param prefix returns the prefix (ACCESSION_PREFIX bytes)
+     * @param number returns the number
+     * @param digits returns the number of digits of the number
+     * @param version returns the version or 0 if the accession has not version
+     * @return 1 if the accession can be encoded (prefix of [A-Z_], up to
+     * ACCESSION_DIGITS digits and an optional version), 0 otherwise
+     */
+    extern int AccessionParse(const char *accession, int length, char *prefix, uint64_t *number, int *digits, int *version);
+
+    /**
+     * Return the accession of a fasta header: the first word, the field
+     * after gi|number|db| in the old NCBI headers or the field after
+     * db| in headers like ref|NC_000913.3|
+     *
+     * @param header the header line, with or without the '>'
+     * @param length the header length
+     * @param accession returns the start of the accession in the header
+     * @return the accession length or 0 if there is not accession
+     */
+    extern int AccessionFromHeader(const char *header, int length, const char **accession);
+
+    /**
+     * Encode an accession with the prefix table of the index
+     *
+     * @param map the index
+     * @param accession the accession
+     * @param length the accession length
+     * @param version returns the version or 0 if the accession has not version
+     * @return the key or 0 if the accession can't be encoded or its group is not in the index
+     */
+    extern uint64_t AccessionEncode(AccTaxMap_t *map, const char *accession, int length, int *version);
+
+    /**
+     * Write the accession of a key
+     *
+     * @param map the index
+     * @param key the key
+     * @param version the version or 0 to write the accession without version
+     * @param accession returns the accession (ACCESSION_LENGTH bytes)
+     * @return the accession length
+     */
+    extern int AccessionDecode(AccTaxMap_t *map, uint64_t key, int version, char *accession);
+
+    /**
+     * Read an accession2taxid file from NCBI Taxonomy (plain or gzip
+     * compressed) into an index. The accession.version and taxid columns
+     * are used, the files with only these two columns (like
+     * prot.accession2taxid.FULL) are supported. The accessions that can't be
+     * encoded are skipped
+     *
+     * @param accession2taxid the accession2taxid file
+     * @param verbose 1 to print a verbose info
+     * @return the index
+     */
+    extern AccTaxMap_t *AccTaxMapLoad(char *accession2taxid, int verbose);
+
+    /**
+     * Write the index to a file
+     *
+     * @param map the index
+     * @param name the file name
+     */
+    extern void AccTaxMapWrite(AccTaxMap_t *map, char *name);
+
+    /**
+     * Check if the file is an accession to taxId index
+     *
+     * @param name the file name
+     * @return 1 if the file starts with the index magic number, 0 otherwise
+     */
+    extern int AccTaxMapCheck(char *name);
+
+    /**
+     * Check if the file is an accession2taxid text file, plain or gzip 
+     * compressed: its first line is the accession, accession.version 
+     * header or its first field is not a number (a gi_taxid file starts
+     * with a Gi)
+     *
+     * @param name the file name
+     * @return 1 if the file is an accession2taxid file, 0 otherwise
+     */
+    extern int AccTaxMapCheckText(char *name);
+
+    /**
+     * Map an index file read-only. The program exits if the file is not a
+     * valid index
+     *
+     * @param name the file name
+     * @return the index
+     */
+    extern AccTaxMap_t *AccTaxMapOpen(char *name);
+
+    /**
+     * Find the taxId of an accession. An accession without version matches
+     * any version
+     *
+     * @param map the index
+     * @param accession the accession
+     * @param length the accession length
+     * @return the taxId or -1 if the accession is not in the index
+     */
+    extern int AccTaxMapFind(AccTaxMap_t *map, const char *accession, int length);
+
+    /**
+     * Find the taxIds of many accessions at once (see GiTaxMapFindBatch).
+     * The results are the same that AccTaxMapFind returns for each
+     * accession
+     *
+     * @param map the index
+     * @param accessions the accessions
+     * @param lengths the accession lengths
+     * @param n the number of accessions
+     * @param taxIds array of n elements with the taxId of each accession or -1
+     */
+    extern void AccTaxMapFindBatch(AccTaxMap_t *map, char **accessions, int *lengths, int n, int *taxIds);
+
+    /**
+     * Free the index (unmap the file)
+     *
+     * @param map the index
+     */
+    extern void AccTaxMapFree(AccTaxMap_t *map);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ACCESSION_H */
+
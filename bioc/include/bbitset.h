@@ -0,0 +1,130 @@
+/*
+ * File:   bbitset.h
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 9:40 PM
+ */
+
+#ifndef BBITSET_H
+#define	BBITSET_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+    /*
+     * Set of integers in [0, size) stored as one bit per integer, like the
+     * taxIds of a taxonomy subtree. The whole NCBI Taxonomy fits in a few
+     * hundred KB.
+     *
+     * The set can be saved to a cache file tagged with a key computed by
+     * the caller from the inputs of the set. Reading the file with a
+     * different key fails, so the set is rebuilt when its inputs change.
+     *
+     * File: BitsetHeader_t and the words of the set
+     */
+#define BITSET_MAGIC "BBITSET"
+#define BITSET_VERSION 1
+
+    typedef struct BitsetHeader_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t key;
+        int64_t size;
+    } BitsetHeader_t;
+
+    typedef struct Bitset_t {
+        uint64_t *words;
+        int size;
+    } Bitset_t;
+
+    /**
+     * Create an empty set
+     *
+     * @param size the number of integers the set can hold, [0, size)
+     * @return the set
+     */
+    extern Bitset_t *bitsetCreate(int size);
+
+    /**
+     * Add an integer to the set. Integers out of [0, size) are ignored
+     *
+     * @param set the set
+     * @param bit the integer
+     */
+    extern void bitsetSet(Bitset_t *set, int bit);
+
+    /**
+     * Remove an integer from the set. Integers out of [0, size) are ignored
+     *
+     * @param set the set
+     * @param bit the integer
+     */
+    extern void bitsetClear(Bitset_t *set, int bit);
+
+    /**
+     * Check if an integer is in the set
+     *
+     * @param set the set
+     * @param bit the integer
+     * @return 1 if the integer is in the set, 0 otherwise or if it is out of [0, size)
+     */
+    extern int bitsetTest(Bitset_t *set, int bit);
+
+    /**
+     * Add the integers of other to the set. The integers of other out of
+     * the set range are ignored
+     *
+     * @param set the set
+     * @param other the set to add
+     */
+    extern void bitsetUnion(Bitset_t *set, Bitset_t *other);
+
+    /**
+     * Remove the integers of other from the set
+     *
+     * @param set the set
+     * @param other the set to remove
+     */
+    extern void bitsetDifference(Bitset_t *set, Bitset_t *other);
+
+    /**
+     * Count the integers in the set
+     *
+     * @param set the set
+     * @return the number of integers in the set
+     */
+    extern size_t bitsetCount(Bitset_t *set);
+
+    /**
+     * Write the set to a cache file
+     *
+     * @param set the set
+     * @param filename the file name
+     * @param key the key of the set inputs
+     */
+    extern void bitsetWrite(Bitset_t *set, char *filename, uint64_t key);
+
+    /**
+     * Read a set from a cache file
+     *
+     * @param filename the file name
+     * @param key the key of the set inputs
+     * @return the set or NULL if the file can't be read or it has a different key
+     */
+    extern Bitset_t *bitsetRead(char *filename, uint64_t key);
+
+    /**
+     * Free the set
+     *
+     * @param set the set
+     */
+    extern void bitsetFree(Bitset_t *set);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BBITSET_H */
+
@@ -34,6 +34,38 @@ extern "C" {
      */
     extern void *reallocate(void *self, size_t size, char *file, int line);
 
+    /**
+     * The function allocates memory of size bytes aligned to alignment bytes.
+     * The memory is released with free
+     * 
+     * @param alignment the alignment in bytes (a power of two multiple of sizeof(void *))
+     * @param size size in bytes
+     * @param file the source code file (__FILE__) or NULL to not print this info
+     * @param line the source code line (__LINE__) or 0
+     * @return return a pointer to the allocated memory
+     */
+    extern void *allocateAligned(size_t alignment, size_t size, char *file, int line);
+
+    /**
+     * Map a whole file read-only in memory for a sequential scan. The 
+     * program exits if the file can't be mapped
+     * 
+     * @param filename the file to map
+     * @param size returns the size of the file in bytes
+     * @param file the source code file (__FILE__) or NULL to not print this info
+     * @param line the source code line (__LINE__) or 0
+     * @return a pointer to the file content (an empty string for an empty file)
+     */
+    extern char *mapFile(char *filename, size_t *size, char *file, int line);
+
+    /**
+     * Unmap a file mapped with mapFile
+     * 
+     * @param map the pointer returned by mapFile
+     * @param size the size of the file
+     */
+    extern void unmapFile(char *map, size_t size);
+
     /**
      * Free an array of pointers
      * 
@@ -0,0 +1,101 @@
+/*
+ * File:   bsimd.h
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 11:20 AM
+ */
+
+#ifndef BSIMD_H
+#define	BSIMD_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+    /*
+     * Vectorized searches over sorted key arrays and text blocks. The implementation is
+     * selected at startup from the instructions supported by the CPU
+     * (AVX2, SSE4.2 or plain C).
+     */
+#define SIMD_SCALAR 0
+#define SIMD_SSE42 1
+#define SIMD_AVX2 2
+
+    /**
+     * Count the number of elements lower than key in a sorted int array.
+     * This is the index of the first element greater than or equal to key
+     *
+     * @param keys the sorted array
+     * @param n the number of elements in the array
+     * @param key the key to compare
+     * @return the number of elements lower than key
+     */
+    extern int countLessInt(const int *keys, int n, int key);
+
+    /**
+     * Count the number of elements lower than key in a sorted array of
+     * unsigned 64 bits string prefixes (see stringPrefix)
+     *
+     * @param prefixes the sorted array
+     * @param n the number of elements in the array
+     * @param key the prefix to compare
+     * @return the number of elements lower than key
+     */
+    extern int countLessPrefix(const uint64_t *prefixes, int n, uint64_t key);
+
+    /**
+     * Find the first line that starts with the character c. The newlines 
+     * up to that line are added to lines. A line starting at data[0] is not
+     * found because the newline before it is not in the block
+     *
+     * @param data the block of text
+     * @param size the number of bytes in the block
+     * @param c the first character of the line to find
+     * @param lines returns the number of newlines added
+     * @return the offset of the line or size if there is not such line
+     */
+    extern size_t findLineStart(const char *data, size_t size, char c, size_t *lines);
+
+    /**
+     * Count the N bases of a sequence block, upper case only like the 
+     * NNNNN check of the splitter, and the ACGT bases, upper or lower case
+     *
+     * @param data the sequence block
+     * @param size the number of bases in the block
+     * @param acgt returns the number of ACGT bases added
+     * @return the number of N bases
+     */
+    extern size_t countBases(const char *data, size_t size, size_t *acgt);
+
+    /**
+     * Pack the first 8 bytes of the string in big-endian order so the
+     * prefixes compare as unsigned integers in the same order that strcmp
+     * compares the strings. Equal prefixes need a strcmp to break the tie
+     *
+     * @param str the string
+     * @return the prefix
+     */
+    extern uint64_t stringPrefix(const char *str);
+
+    /**
+     * Set the implementation used by the search functions. The level is
+     * capped to the best one supported by the CPU
+     *
+     * @param level SIMD_SCALAR, SIMD_SSE42 or SIMD_AVX2
+     * @return the level in use after the call
+     */
+    extern int setSimdLevel(int level);
+
+    /**
+     * Return the best implementation supported by the CPU
+     *
+     * @return SIMD_SCALAR, SIMD_SSE42 or SIMD_AVX2
+     */
+    extern int getSimdSupported(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BSIMD_H */
+
@@ -56,12 +56,18 @@ extern "C" {
      * track of the number of valid keys.
      * In an internal node, the number of valid
      * pointers is always num_keys + 1.
-     * In a leaf, the number of valid pointers
-     * to data is always num_keys.  The
+     * In a leaf, the number of valid records
+     * is always num_keys.  The records are stored
+     * inline in the pointers array (records points
+     * to the same memory) so a lookup does not follow
+     * an extra pointer per value.  The
      * last leaf pointer points to the next leaf.
+     * The node, its keys and its pointers are allocated
+     * in one cache line aligned block.
      */
     typedef struct BtreeNode_t {
         void ** pointers;
+        BtreeRecord_t * records;
         int * keys;
         struct BtreeNode_t * parent;
         bool is_leaf;
@@ -69,13 +75,28 @@ extern "C" {
         struct BtreeNode_t * next; // Used for queue.
     } BtreeNode_t;
 
-    // Default order is 10.
-#define DEFAULT_ORDER 20
+#define BTREE_CACHE_LINE 64
+
+    // Default order fills a 4 KiB node: one cache line for
+    // the node header, order - 1 keys and order pointers.
+#ifndef DEFAULT_ORDER
+#define DEFAULT_ORDER 336
+#endif
 
     // Minimum order is necessarily 3.  We set the maximum
     // order arbitrarily.  You may change the maximum order.
 #define MIN_ORDER 3
-#define MAX_ORDER 20    
+#define MAX_ORDER 8192
+
+    /**
+     * Set the order used by the B+ tree functions. It must be called
+     * before any tree is created, the trees already created keep the
+     * order they were built with and must not be used after the change.
+     * 
+     * @param newOrder the new order (between MIN_ORDER and MAX_ORDER)
+     * @return the order in use after the call
+     */
+    extern int BtreeSetOrder(int newOrder);
 
     /**
      * Master insertion function.
@@ -91,6 +112,36 @@ extern "C" {
      */
     extern BtreeNode_t *BtreeInsert(BtreeNode_t * root, int key, void *value);
 
+    /**
+     * Bulk load function.
+     * Builds the B+ tree bottom-up from an array of keys and
+     * the array of their associated values. The leaves are
+     * fully packed and every internal node is built only once,
+     * so there is no root-to-leaf descent or node split per key.
+     * The arrays are sorted in place by key if they are not
+     * sorted yet. As in BtreeInsert, duplicated keys are ignored
+     * and the first value of the key is kept.
+     * 
+     * @param keys the keys array
+     * @param values the values array
+     * @param n the number of elements in the arrays
+     * @return the root node
+     */
+    extern BtreeNode_t *BtreeBulkLoad(int *keys, void **values, int n);
+
+    /**
+     * Append a key and its value to the arrays used by BtreeBulkLoad,
+     * growing the arrays as needed
+     * 
+     * @param keys the keys array
+     * @param values the values array
+     * @param n the number of elements in the arrays
+     * @param capacity the allocated number of elements in the arrays
+     * @param key the key to append
+     * @param value the value to append
+     */
+    extern void BtreeBulkAppend(int **keys, void ***values, int *n, int *capacity, int key, void *value);
+
     /**
      * Finds and returns the record to which a key refers.
      * 
@@ -101,6 +152,20 @@ extern "C" {
      */
     extern BtreeRecord_t *BTreeFind(BtreeNode_t * root, int key, bool verbose);
 
+    /**
+     * Finds the records of many keys at once. The keys are walked down
+     * the tree in groups, one level at a time for the whole group, and
+     * the nodes of the next level are prefetched so the memory accesses
+     * of the different keys overlap. The results are the same that
+     * BTreeFind returns for each key.
+     * 
+     * @param root the root node
+     * @param keys the keys to find
+     * @param n the number of keys
+     * @param out array of n elements with the record of each key or NULL
+     */
+    extern void BTreeFindBatch(BtreeNode_t * root, int *keys, int n, BtreeRecord_t **out);
+
     /**
      * Prints the B+ tree in the command
      * line in level (rank) order, with the 
@@ -0,0 +1,120 @@
+/*
+ * File:   btreeimage.h
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 10:05 AM
+ */
+
+#ifndef BTREEIMAGE_H
+#define	BTREEIMAGE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+    /*
+     * On-disk image of a B+ tree with int keys and fixed size values.
+     *
+     * The file is a sequence of BTREE_IMAGE_PAGE bytes pages. The first
+     * page is the header, the rest are nodes. The nodes have no pointers,
+     * the children of the internal nodes are page numbers, so the file can
+     * be mapped read-only and searched directly without any load step.
+     *
+     * Leaf page:      BtreeImageNode_t, int keys[capacity], values[capacity]
+     * Internal page:  BtreeImageNode_t, int keys[capacity], uint32_t children[capacity + 1]
+     *
+     * In an internal page keys[i] is the smallest key of the children[i + 1]
+     * subtree.
+     */
+#define BTREE_IMAGE_MAGIC "BTIMAGE"
+#define BTREE_IMAGE_VERSION 1
+#define BTREE_IMAGE_PAGE 4096
+
+    typedef struct BtreeImageHeader_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t pageSize;
+        uint32_t valueSize;
+        uint32_t height;
+        uint32_t leafCapacity;
+        uint32_t internalCapacity;
+        uint64_t numKeys;
+        uint64_t numPages;
+        uint64_t root;
+    } BtreeImageHeader_t;
+
+    typedef struct BtreeImageNode_t {
+        uint32_t is_leaf;
+        uint32_t num_keys;
+    } BtreeImageNode_t;
+
+    typedef struct BtreeImage_t {
+        void *map;
+        size_t size;
+        BtreeImageHeader_t *header;
+    } BtreeImage_t;
+
+    /**
+     * Write the B+ tree as an on-disk image. The values are copied from the
+     * records (valueSize bytes from each record value)
+     *
+     * @param name the output file name
+     * @param root the B+ tree root
+     * @param valueSize the size in bytes of each value (sizeof(off_t), sizeof(int), ...)
+     */
+    extern void BtreeImageWrite(char *name, BtreeNode_t *root, size_t valueSize);
+
+    /**
+     * Write an on-disk image from sorted arrays of keys and values, without
+     * building the B+ tree in memory. Only the first value of a repeated key
+     * is written
+     *
+     * @param name the output file name
+     * @param keys the keys sorted in increasing order
+     * @param values the n values, valueSize bytes each
+     * @param n the number of keys
+     * @param valueSize the size in bytes of each value (sizeof(off_t), sizeof(int), ...)
+     */
+    extern void BtreeImageWriteArrays(char *name, int *keys, void *values, int n, size_t valueSize);
+
+    /**
+     * Check if the file is a B+ tree image
+     *
+     * @param name the file name
+     * @return 1 if the file starts with the image magic number, 0 otherwise
+     */
+    extern int BtreeImageCheck(char *name);
+
+    /**
+     * Map a B+ tree image read-only. The program exits if the file is not a
+     * valid image
+     *
+     * @param name the file name
+     * @param valueSize the expected size of the values or 0 to skip the check
+     * @return the image
+     */
+    extern BtreeImage_t *BtreeImageOpen(char *name, size_t valueSize);
+
+    /**
+     * Find a key in the image
+     *
+     * @param image the image
+     * @param key the key to search
+     * @return a pointer to the value inside the mapping or NULL if the key
+     * is not in the image
+     */
+    extern void *BtreeImageFind(BtreeImage_t *image, int key);
+
+    /**
+     * Unmap and free the image
+     *
+     * @param image the image
+     */
+    extern void BtreeImageClose(BtreeImage_t *image);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BTREEIMAGE_H */
+
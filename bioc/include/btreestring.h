@@ -12,15 +12,23 @@
 extern "C" {
 #endif
 
+    /* keys[i] and prefixes[i] are the same key, prefixes holds the
+     * first 8 bytes packed as an integer (stringPrefix) so the nodes are
+     * searched with vector compares and strcmp is only used on ties.
+     */
     typedef struct BtreeNodeString_t {
         void ** pointers;
         char **keys;
+        uint64_t *prefixes;
         struct BtreeNodeString_t * parent;
         bool is_leaf;
         int num_keys;
         struct BtreeNodeString_t * next; // Used for queue.
     } BtreeNodeString_t;
 
+    // Default order of the string B+ tree.
+#define DEFAULT_ORDER_STRING 20
+
 
     /**
      * Master insertion function.
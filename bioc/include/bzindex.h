@@ -0,0 +1,124 @@
+/*
+ * File:   bzindex.h
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 6:10 PM
+ */
+
+#ifndef BZINDEX_H
+#define	BZINDEX_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+    /*
+     * Random access to gzip files. The index keeps an inflate checkpoint
+     * (access point) every ZINDEX_SPAN uncompressed bytes: the compressed
+     * and uncompressed offsets of a deflate block boundary and the 32K
+     * window needed to restart the inflate there. Reading from an offset
+     * only inflates from the access point before it.
+     *
+     * The windows are kept deflated, in memory and in the file. The
+     * access points are added while the file is read, so the first
+     * sequential pass over a file builds its index. Concatenated gzip
+     * members (BGZF files included) are supported.
+     *
+     * BuildBtreeIndexFasta writes the index of a gzip fasta file next to
+     * the Gi index, with the ZINDEX_EXTENSION added to its name.
+     *
+     * File: ZIndexHeader_t, then for each point out, in (int64), bits
+     * (int32), windowSize (uint32) and the deflated window
+     */
+#define ZINDEX_MAGIC "BZINDEX"
+#define ZINDEX_EXTENSION ".zindex"
+#define ZINDEX_VERSION 1
+#define ZINDEX_WINDOW 32768
+#ifndef ZINDEX_SPAN
+#define ZINDEX_SPAN (4 << 20)
+#endif
+#define ZINDEX_CHUNK (1 << 18)
+
+    typedef struct ZIndexHeader_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t count;
+        int64_t span;
+        int64_t size;
+    } ZIndexHeader_t;
+
+    /*
+     * bits is the number of bits of the byte before in that belong to the
+     * block, -1 if in is the start of a gzip member (no window needed)
+     */
+    typedef struct ZIndexPoint_t {
+        off_t out;
+        off_t in;
+        int bits;
+        unsigned int windowSize;
+        unsigned char *window;
+    } ZIndexPoint_t;
+
+    /*
+     * size is the uncompressed size, -1 until the end of the file is
+     * reached
+     */
+    typedef struct ZIndex_t {
+        ZIndexPoint_t *points;
+        int count;
+        int capacity;
+        off_t span;
+        off_t size;
+    } ZIndex_t;
+
+    /**
+     * Create an empty index. The access points are added while the file is
+     * read with zindexOpen
+     *
+     * @param span the minimum number of uncompressed bytes between access points
+     * @return the index
+     */
+    extern ZIndex_t *zindexCreate(off_t span);
+
+    /**
+     * Read an index file
+     *
+     * @param filename the index file name
+     * @return the index or NULL if the file can't be opened
+     */
+    extern ZIndex_t *zindexRead(char *filename);
+
+    /**
+     * Write the index to a file
+     *
+     * @param index the index
+     * @param filename the index file name
+     */
+    extern void zindexWrite(ZIndex_t *index, char *filename);
+
+    /**
+     * Free the index
+     *
+     * @param index the index
+     */
+    extern void zindexFree(ZIndex_t *index);
+
+    /**
+     * Open a gzip file as a seekable read-only FILE over its uncompressed
+     * data. fseeko and ftello use uncompressed offsets. The index is
+     * completed with the access points of the parts of the file that are
+     * read, it has to be kept until the FILE is closed. The program exits
+     * if the file can't be opened
+     *
+     * @param filename the gzip file name
+     * @param index the index of the file
+     * @return the FILE (close it with fclose)
+     */
+    extern FILE *zindexOpen(char *filename, ZIndex_t *index);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BZINDEX_H */
+
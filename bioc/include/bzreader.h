@@ -0,0 +1,100 @@
+/*
+ * File:   bzreader.h
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 4:30 PM
+ */
+
+#ifndef BZREADER_H
+#define	BZREADER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+    /*
+     * Line reader for plain or gzip compressed text files. A background
+     * thread inflates the file into a ring of ZREADER_SLOTS blocks of
+     * ZREADER_BLOCK bytes, so the inflate overlaps with the parsing done
+     * by the caller. Plain files are read the same way (zlib copies them).
+     */
+#define ZREADER_SLOTS 4
+#ifndef ZREADER_BLOCK
+#define ZREADER_BLOCK (4 << 20)
+#endif
+
+    typedef struct ZReader_t {
+        gzFile file;
+        pthread_t thread;
+        pthread_mutex_t mutex;
+        pthread_cond_t filled;
+        pthread_cond_t emptied;
+        char *blocks[ZREADER_SLOTS];
+        size_t sizes[ZREADER_SLOTS];
+        int head;
+        int count;
+        int eof;
+        int error;
+        int closing;
+        int current;
+        size_t pos;
+        char *carry;
+        size_t carrySize;
+        size_t carryCapacity;
+        int carryReturned;
+        char *lines;
+        size_t linesSize;
+        size_t linesPos;
+    } ZReader_t;
+
+    /**
+     * Check if the file starts with the gzip magic number
+     * 
+     * @param filename the file name
+     * @return 1 if the file is gzip compressed
+     */
+    extern int isGzipFile(char *filename);
+
+    /**
+     * Open a plain or gzip compressed file and start the inflate thread.
+     * The program exits if the file can't be opened
+     * 
+     * @param filename the file name
+     * @return the reader
+     */
+    extern ZReader_t *zreaderOpen(char *filename);
+
+    /**
+     * Return the next block of complete lines of the file. The block is 
+     * owned by the reader and it is valid until the next call. The last
+     * line of the file may have no '\n'
+     * 
+     * @param reader the reader
+     * @param size returns the size of the block in bytes
+     * @return the block or NULL at the end of the file
+     */
+    extern char *zreaderLines(ZReader_t *reader, size_t *size);
+
+    /**
+     * Read a line like getline does
+     * 
+     * @param line the line buffer (allocated or grown as needed)
+     * @param len the size of the line buffer
+     * @param reader the reader
+     * @return the number of characters read or -1 at the end of the file
+     */
+    extern ssize_t zreaderGetline(char **line, size_t *len, ZReader_t *reader);
+
+    /**
+     * Stop the inflate thread, close the file and free the reader
+     * 
+     * @param reader the reader
+     */
+    extern void zreaderClose(ZReader_t *reader);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BZREADER_H */
+
@@ -12,6 +12,32 @@
 extern "C" {
 #endif
 
+    /*
+     * A run of len characters from start. In the exceptions list base is
+     * the uppercase character of the run (N or other IUPAC codes), in the 
+     * masks list (soft-masked lowercase bases) base is not used
+     */
+    typedef struct PackedRun_t {
+        int start;
+        int length;
+        char base;
+    } PackedRun_t;
+
+    /*
+     * Nucleotide sequence packed with 2 bits per base (A 0, C 1, G 2, T 3, 
+     * 4 bases per byte, the first base in the low bits). The bases that
+     * are not ACGT are packed as A and listed in the exceptions runs, the
+     * lowercase bases are listed in the masks runs
+     */
+    typedef struct PackedSeq_t {
+        unsigned char *bases;
+        int len;
+        PackedRun_t *exceptions;
+        int exceptions_number;
+        PackedRun_t *masks;
+        int masks_number;
+    } PackedSeq_t;
+
     struct fasta_s {
         /*
          * Members          
@@ -19,6 +45,8 @@ extern "C" {
         char *header;
         char *seq;
         int len;
+        /* The sequence when it is packed (seq is NULL) */
+        PackedSeq_t *packed;
 
         /*
          * Methods
@@ -71,7 +99,7 @@ extern "C" {
          * @param offset the offset of the segments
          * @param lineLength the length of the fasta line
          * @param threads_number Number of threads
-         * @param inMem du the generation in memory
+         * @param inMem 1 to skip the segments with a run of more than FASTA_FILTER_N_RUN N and parse the Gi with headerParser
          */
         void (*splitInSegments)(void * self, FILE *out, char *headerParser, int length, int offset, int lineLength, int threads_number, int inMem);
 
@@ -87,6 +115,14 @@ extern "C" {
          */
         void (*printSegment)(void * self, FILE *out, char *header, int start, int length, int lineLength);
 
+        /**
+         * Pack the sequence with 2 bits per base and free the text 
+         * sequence. The segment and print methods unpack it as needed
+         * 
+         * @param self the container object
+         */
+        void (*pack)(void *self);
+
         /**
          * Print in fasta file to the STDOUT
          * 
@@ -122,6 +158,112 @@ extern "C" {
 
     typedef struct fasta_s *fasta_l;
 
+    /*
+     * Sequential fasta reader. The read buffer and the sequence buffer are
+     * kept between records and only grow, so reading a record costs no
+     * allocation beyond the returned fasta_l
+     */
+#define FASTA_READER_BUFFER (1 << 20)
+
+    typedef struct FastaReader_t {
+        FILE *fp;
+        char *buffer;
+        size_t capacity;
+        size_t size;
+        size_t pos;
+        off_t offset;
+        int eof;
+        char *seq;
+        size_t seqCapacity;
+    } FastaReader_t;
+
+    /*
+     * Buffered fasta writer. The records are formatted in the buffer, the
+     * sequence lines are copied with memcpy and the newlines inserted 
+     * between them, and the full buffer is written with a direct write to
+     * the file descriptor of the FILE (fwrite if it does not have one)
+     */
+#define FASTA_WRITER_BUFFER (1 << 20)
+
+    typedef struct FastaWriter_t {
+        FILE *fp;
+        int fd;
+        char *buffer;
+        size_t capacity;
+        size_t size;
+        int lineLength;
+    } FastaWriter_t;
+
+    /*
+     * Segment generator shared by all the entries of a file. A pool of 
+     * threads takes (entry, segments range) tasks from per thread deques,
+     * stealing from the other threads when idle. A writer thread writes 
+     * the segments in the order of the entries. Only a few tasks per 
+     * thread wait to be written, so the memory does not depend on the 
+     * size of the file. The members are private
+     */
+    typedef struct FastaSplitter_s FastaSplitter_t;
+
+    /*
+     * Segment filter of the splitter, a negative value disables a check.
+     * maxN is the maximum number of N bases, maxNRun the longest run of N,
+     * minACGT the minimum fraction of ACGT bases and maxDust the maximum 
+     * DUST low-complexity score: the sum of c(c-1)/2 over the counts of 
+     * the ACGT triplets divided by the number of triplets (2.0 is the 
+     * dustmasker level 20). N is upper case only, so soft-masked n 
+     * bases are not counted, ACGT are upper or lower case
+     */
+#define FASTA_FILTER_N_RUN 4
+
+    typedef struct FastaSegmentFilter_t {
+        int maxN;
+        int maxNRun;
+        double minACGT;
+        double maxDust;
+    } FastaSegmentFilter_t;
+
+    /*
+     * Position of a fasta entry found by FastaReaderNextIndex, like a line
+     * of a samtools .fai file. length is the number of sequence characters
+     * (the len of the entry read with ReadFasta), lineBases and lineWidth
+     * are the characters and bytes of the first sequence line. header 
+     * points into the reader and is valid until the next call
+     */
+    typedef struct FastaIndexEntry_t {
+        char *header;
+        off_t offset;
+        off_t seqOffset;
+        long long int length;
+        int lineBases;
+        int lineWidth;
+    } FastaIndexEntry_t;
+
+    /**
+     * Pack a sequence with 2 bits per base
+     * 
+     * @param seq the sequence
+     * @param len the length of the sequence
+     * @return the packed sequence
+     */
+    extern PackedSeq_t *PackSequence(char *seq, int len);
+
+    /**
+     * Unpack a segment of a packed sequence
+     * 
+     * @param packed the packed sequence
+     * @param start the start position
+     * @param length the segment length (it has to be inside the sequence)
+     * @param out the output buffer of at least length characters (no '\0' is added)
+     */
+    extern void UnpackSequence(PackedSeq_t *packed, int start, int length, char *out);
+
+    /**
+     * Free the packed sequence
+     * 
+     * @param packed the packed sequence
+     */
+    extern void FreePackedSequence(PackedSeq_t *packed);
+
     /**
      * Create the Fasta object and initialized the pointers to the methods
      * 
@@ -158,6 +300,91 @@ extern "C" {
      */
     fasta_l ReadFastaBuffer(FILE *fp, int bufferSize, int excludeSeq);
 
+    /**
+     * Create a sequential fasta reader that starts at the current position 
+     * of the file
+     * 
+     * @param fp the input file
+     * @return the reader
+     */
+    extern FastaReader_t *CreateFastaReader(FILE *fp);
+
+    /**
+     * Read the next fasta entry
+     * 
+     * @param reader the reader
+     * @param excludeSeq 1 if you want to exclude the sequence and read only the header 
+     * @return the fasta entry or NULL at the end of the file
+     */
+    extern fasta_l FastaReaderNext(FastaReader_t *reader, int excludeSeq);
+
+    /**
+     * Read the next fasta entry with the sequence packed with 2 bits per
+     * base. The text sequence is only kept in the reader buffer
+     * 
+     * @param reader the reader
+     * @return the fasta entry or NULL at the end of the file
+     */
+    extern fasta_l FastaReaderNextPacked(FastaReader_t *reader);
+
+    /**
+     * Find the next fasta entry without reading its sequence. Only the 
+     * header is parsed, the sequence is skipped looking for the next 
+     * line starting with '>' 
+     * 
+     * @param reader the reader
+     * @param entry returns the position of the entry
+     * @return 1 if an entry was found, 0 at the end of the file
+     */
+    extern int FastaReaderNextIndex(FastaReader_t *reader, FastaIndexEntry_t *entry);
+
+    /**
+     * Return the file offset of the next fasta entry
+     * 
+     * @param reader the reader
+     * @return the offset
+     */
+    extern off_t FastaReaderTell(FastaReader_t *reader);
+
+    /**
+     * Free the reader. The file is not closed
+     * 
+     * @param reader the reader
+     */
+    extern void FreeFastaReader(FastaReader_t *reader);
+
+    /**
+     * Create a buffered fasta writer. Nothing else should write to the 
+     * file until the writer is flushed
+     * 
+     * @param fp the output file
+     * @param lineLength the length of the fasta line
+     * @return the writer
+     */
+    extern FastaWriter_t *CreateFastaWriter(FILE *fp, int lineLength);
+
+    /**
+     * Write a fasta object. Packed sequences are unpacked in the buffer
+     * 
+     * @param writer the writer
+     * @param fasta the fasta object
+     */
+    extern void FastaWriterWriteFasta(FastaWriter_t *writer, fasta_l fasta);
+
+    /**
+     * Write the buffer to the file
+     * 
+     * @param writer the writer
+     */
+    extern void FastaWriterFlush(FastaWriter_t *writer);
+
+    /**
+     * Flush and free the writer. The file is not closed
+     * 
+     * @param writer the writer
+     */
+    extern void FreeFastaWriter(FastaWriter_t *writer);
+
     /**
      * Read a fasta entry from a gzipped file
      * 
@@ -167,6 +394,53 @@ extern "C" {
      */
     extern fasta_l ReadFastaGzip(gzFile fp, int excludeSeq);
 
+    /**
+     * Create a splitter that generates the segments of length with an 
+     * overlap of offset of the sequences using a pool of threads
+     * 
+     * @param out the output file 
+     * @param headerParser sscanf format to parse the Gi from the fasta header. If null use default fasta header
+     * @param length the length of the segments
+     * @param offset the offset of the segments
+     * @param lineLength the length of the fasta line
+     * @param threads_number Number of threads
+     * @param filter the segments filter (copied) or NULL to keep all the segments
+     * @return the splitter
+     */
+    extern FastaSplitter_t *CreateFastaSplitter(FILE *out, char *headerParser, int length, int offset, int lineLength, int threads_number, FastaSegmentFilter_t *filter);
+
+    /**
+     * Queue the segments of a fasta entry. The splitter frees the entry 
+     * when its segments are written. It waits while the queue is full
+     * 
+     * @param splitter the splitter
+     * @param fasta the fasta entry
+     */
+    extern void FastaSplitterAdd(FastaSplitter_t *splitter, fasta_l fasta);
+
+    /**
+     * Wait until the segments of the queued entries are written
+     * 
+     * @param splitter the splitter
+     */
+    extern void FastaSplitterFlush(FastaSplitter_t *splitter);
+
+    /**
+     * Write the queued segments and change the output file
+     * 
+     * @param splitter the splitter
+     * @param out the new output file
+     */
+    extern void FastaSplitterSetOutput(FastaSplitter_t *splitter, FILE *out);
+
+    /**
+     * Write the queued segments, stop the threads and free the splitter.
+     * The output file is not closed
+     * 
+     * @param splitter the splitter
+     */
+    extern void FreeFastaSplitter(FastaSplitter_t *splitter);
+
     /**
      * Create a fasta binary index file which include the gi and the offset position
      * 
@@ -177,6 +451,17 @@ extern "C" {
      */
     extern int CreateFastaIndexToFile(FILE *fd, FILE *fo, int verbose);
 
+    /**
+     * Create a samtools like .fai text file with the name, sequence length,
+     * sequence offset, line bases and line width of each entry
+     * 
+     * @param fd the input fasta file
+     * @param fo the output text file
+     * @param verbose 1 to print info
+     * @return the number of elements read
+     */
+    extern int CreateFastaFaiToFile(FILE *fd, FILE *fo, int verbose);
+
     /**
      * Create a Btree index which include the gi and the offset position
      * 
@@ -215,6 +500,46 @@ extern "C" {
      */
     extern BtreeNode_t * CreateBtreeFromFastaGzip(gzFile fd, int verbose);
 
+    /**
+     * Index a fasta file with threads. The file is split in byte ranges, each
+     * range starts at its first header and is indexed by a thread, and the 
+     * sorted ranges are merged. The Gis are returned sorted, duplicated Gis 
+     * are kept in file order
+     * 
+     * @param filename the input fasta file (not compressed)
+     * @param giPattern pattern to extract the gi from the fasta header. If null use default fasta header
+     * @param threads the number of threads (0 to use all the processors)
+     * @param rangeMin minimum size in bytes of the range of a thread (0 for the default, 16 MB)
+     * @param gis returns the sorted Gis
+     * @param offsets returns the offset of the fasta entry of each Gi
+     * @param verbose 1 to print info
+     * @return the number of entries
+     */
+    extern int FastaIndexParallel(char *filename, char *giPattern, int threads, off_t rangeMin, int **gis, off_t **offsets, int verbose);
+
+    /**
+     * Create a fasta binary index file which include the gi and the offset 
+     * position using threads. The records are sorted by Gi
+     * 
+     * @param filename the input fasta file (not compressed)
+     * @param fo the output binary file
+     * @param threads the number of threads (0 to use all the processors)
+     * @param verbose 1 to print info
+     * @return the number of elements read
+     */
+    extern int CreateFastaIndexToFileParallel(char *filename, FILE *fo, int threads, int verbose);
+
+    /**
+     * Create a Btree index which include the gi and the offset position 
+     * using threads
+     * 
+     * @param filename the input fasta file (not compressed)
+     * @param threads the number of threads (0 to use all the processors)
+     * @param verbose 1 to print info
+     * @return the Btree index
+     */
+    extern BtreeNode_t * CreateBtreeFromFastaParallel(char *filename, int threads, int verbose);
+
     /**
      * Create a Btree index from a fasta index file
      * 
@@ -0,0 +1,171 @@
+/*
+ * File:   gitaxmap.h
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 11:15 PM
+ */
+
+#ifndef GITAXMAP_H
+#define	GITAXMAP_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+    /*
+     * Read-only Gi to taxId map in a few bytes per Gi. The sorted Gis are
+     * stored with the Elias-Fano encoding: the lowBits low bits of each Gi
+     * in a packed array and the high part as a bit array where the Gi i
+     * sets the bit (gi >> lowBits) + i. A Gi is found by going to the
+     * (gi >> lowBits)-th zero of the bit array (select0, helped by the
+     * position of every GITAXMAP_SAMPLE-th zero) and comparing the low
+     * bits of the few Gis there. The taxIds are packed with taxIdBits bits.
+     *
+     * The keys can also be any 64 bits integers (the *64 functions), like
+     * the encoded accessions of the accession module.
+     *
+     * The file is the GiTaxMapHeader_t followed by the low bits, the high
+     * bits, the zero samples and the taxIds, all in uint64_t words, so it
+     * is mapped and searched with no load step. A map built in memory has
+     * the same layout.
+     */
+#define GITAXMAP_MAGIC "GITAXMP"
+#define GITAXMAP_VERSION 2
+#define GITAXMAP_SAMPLE 128
+
+    typedef struct GiTaxMapHeader_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t lowBits;
+        uint32_t taxIdBits;
+        uint32_t reserved;
+        uint64_t count;
+        uint64_t maxKey;
+        uint64_t upperBits;
+        uint64_t samples;
+        uint64_t size;
+    } GiTaxMapHeader_t;
+
+    /*
+     * mapped is 1 if map is a file mapping, 0 if it was allocated
+     */
+    typedef struct GiTaxMap_t {
+        void *map;
+        size_t size;
+        int mapped;
+        GiTaxMapHeader_t *header;
+        uint64_t *low;
+        uint64_t *upper;
+        uint64_t *samples;
+        uint64_t *taxIds;
+    } GiTaxMap_t;
+
+    /**
+     * Build a map in memory. The negative Gis are not included
+     *
+     * @param gis the Gis sorted and without repetitions
+     * @param taxIds the taxId of each Gi
+     * @param count the number of Gis
+     * @return the map
+     */
+    extern GiTaxMap_t *GiTaxMapCreate(int *gis, int *taxIds, int count);
+
+    /**
+     * Build a map in memory with 64 bits keys
+     *
+     * @param keys the keys sorted and without repetitions
+     * @param taxIds the taxId of each key
+     * @param count the number of keys
+     * @return the map
+     */
+    extern GiTaxMap_t *GiTaxMapCreate64(uint64_t *keys, int *taxIds, uint64_t count);
+
+    /**
+     * Read the gi_taxid_nucl.dmp file (see TaxonomyNuclLoad) into a map
+     *
+     * @param gi_taxid_nucl the gi_taxid_nucl.dmp complete path
+     * @param threads the number of threads (0 to use all the processors)
+     * @param verbose 1 to print a verbose info
+     * @return the map
+     */
+    extern GiTaxMap_t *GiTaxMapLoad(char *gi_taxid_nucl, int threads, int verbose);
+
+    /**
+     * Write the map to a file
+     *
+     * @param map the map
+     * @param name the file name
+     */
+    extern void GiTaxMapWrite(GiTaxMap_t *map, char *name);
+
+    /**
+     * Check if the file is a Gi to taxId map
+     *
+     * @param name the file name
+     * @return 1 if the file starts with the map magic number, 0 otherwise
+     */
+    extern int GiTaxMapCheck(char *name);
+
+    /**
+     * Map a Gi to taxId map file read-only. The program exits if the file
+     * is not a valid map
+     *
+     * @param name the file name
+     * @return the map
+     */
+    extern GiTaxMap_t *GiTaxMapOpen(char *name);
+
+    /**
+     * Find the taxId of a Gi
+     *
+     * @param map the map
+     * @param gi the Gi
+     * @return the taxId or -1 if the Gi is not in the map
+     */
+    extern int GiTaxMapFind(GiTaxMap_t *map, int gi);
+
+    /**
+     * Find the taxId of a 64 bits key
+     *
+     * @param map the map
+     * @param key the key
+     * @return the taxId or -1 if the key is not in the map
+     */
+    extern int GiTaxMapFind64(GiTaxMap_t *map, uint64_t key);
+
+    /**
+     * Find the taxIds of many Gis at once. The Gis are searched in groups
+     * and the memory of each step is prefetched for the whole group, so
+     * the accesses of the different Gis overlap. The results are the same
+     * that GiTaxMapFind returns for each Gi
+     *
+     * @param map the map
+     * @param gis the Gis
+     * @param n the number of Gis
+     * @param taxIds array of n elements with the taxId of each Gi or -1
+     */
+    extern void GiTaxMapFindBatch(GiTaxMap_t *map, int *gis, int n, int *taxIds);
+
+    /**
+     * Find the taxIds of many 64 bits keys at once (see GiTaxMapFindBatch)
+     *
+     * @param map the map
+     * @param keys the keys
+     * @param n the number of keys
+     * @param taxIds array of n elements with the taxId of each key or -1
+     */
+    extern void GiTaxMapFindBatch64(GiTaxMap_t *map, uint64_t *keys, int n, int *taxIds);
+
+    /**
+     * Free the map (unmap the file)
+     *
+     * @param map the map
+     */
+    extern void GiTaxMapFree(GiTaxMap_t *map);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* GITAXMAP_H */
+
@@ -90,6 +90,52 @@ extern "C" {
 
     typedef struct taxonomy_s *taxonomy_l;
 
+    /*
+     * Ranks with a fixed id in the TaxonomyTable. Any other rank found in
+     * the nodes.dmp file gets the next free id (see TaxonomyTableRank)
+     */
+    typedef enum TaxonomyRank_t {
+        TAXONOMY_RANK_NO_RANK,
+        TAXONOMY_RANK_SPECIES,
+        TAXONOMY_RANK_GENUS,
+        TAXONOMY_RANK_FAMILY,
+        TAXONOMY_RANK_ORDER,
+        TAXONOMY_RANK_CLASS,
+        TAXONOMY_RANK_PHYLUM,
+        TAXONOMY_RANK_SUPERKINGDOM,
+        TAXONOMY_RANK_FIXED
+    } TaxonomyRank_t;
+
+    /*
+     * One entry of the TaxonomyTable. parentTaxId is 0 if the taxId is
+     * not in the database and name is the offset of the scientific name
+     * in the table names pool (-1 if the taxonomy has no name)
+     */
+    typedef struct TaxonomyNode_t {
+        int parentTaxId;
+        int name;
+        unsigned char rank;
+    } TaxonomyNode_t;
+
+    /*
+     * NCBI Taxonomy database as a flat array indexed by taxId.
+     * enter, exit and preorder are NULL until TaxonomyTableEulerTour is 
+     * called. The subtree of a taxId is preorder[enter[taxId]] to 
+     * preorder[exit[taxId]] (enter is -1 if the taxId is not in the table)
+     */
+    typedef struct TaxonomyTable_t {
+        TaxonomyNode_t *nodes;
+        int maxTaxId;
+        int count;
+        char *names;
+        size_t names_size;
+        char **ranks;
+        int ranks_number;
+        int *enter;
+        int *exit;
+        int *preorder;
+    } TaxonomyTable_t;
+
     /**
      * Create the Taxonomy object and initialized the pointers to the methods
      * 
@@ -117,15 +163,129 @@ extern "C" {
     extern BtreeNode_t *TaxonomyDBIndex(char *dir, int verbose);
 
     /**
-     * Read the gi_taxid_nucl.dmp.gz file from NCBI Taxonomy and return a Btree 
-     * index of the Gi
+     * Read the gi_taxid_nucl.dmp file from NCBI Taxonomy into two arrays 
+     * sorted by Gi. A plain file is mapped in memory and parsed in parallel,
+     * a gzip file is parsed while a background thread inflates it. If a Gi 
+     * is repeated the first line is kept
      * 
-     * @param filename the gi_taxid_nucl.dmp.gz complete path
+     * @param gi_taxid_nucl the gi_taxid_nucl.dmp complete path
+     * @param threads the number of threads (0 to use all the processors)
+     * @param gis returns the sorted Gis
+     * @param taxIds returns the taxId of each Gi
+     * @param verbose 1 to print a verbose info
+     * @return the number of Gis
+     */
+    extern int TaxonomyNuclLoad(char *gi_taxid_nucl, int threads, int **gis, int **taxIds, int verbose);
+
+    /**
+     * Read the gi_taxid_nucl.dmp file from NCBI Taxonomy and return a Btree 
+     * index over the Gi. The values point into a single array of taxIds so 
+     * the index has to be released with TaxonomyNuclFree
+     * 
+     * @param filename the gi_taxid_nucl.dmp complete path
      * @param verbose 1 to print a verbose info
      * @return 
      */
     extern BtreeNode_t *TaxonomyNuclIndex(char *gi_taxid_nucl, int verbose);
 
+    /**
+     * Free the index returned by TaxonomyNuclIndex
+     * 
+     * @param root the index
+     */
+    extern void TaxonomyNuclFree(BtreeNode_t *root);
+
+    /**
+     * Read the NCBI Taxonomy nodes.dmp and names.dmp files into a table
+     * indexed by taxId. The files are mapped in memory and parsed in 
+     * parallel
+     * 
+     * @param dir the NCBI Taxonomy DB directory
+     * @param threads the number of threads (0 to use all the processors)
+     * @param verbose 1 to print a verbose info
+     * @return the NCBI Taxonomy table
+     */
+    extern TaxonomyTable_t *TaxonomyTableLoad(char *dir, int threads, int verbose);
+
+    /**
+     * Check if the taxId is in the table
+     * 
+     * @param table the NCBI Taxonomy table
+     * @param taxId the taxId
+     * @return 1 if the taxId is in the table
+     */
+    extern int TaxonomyTableContains(TaxonomyTable_t *table, int taxId);
+
+    /**
+     * Return the scientific name of the taxId
+     * 
+     * @param table the NCBI Taxonomy table
+     * @param taxId the taxId (it has to be in the table)
+     * @return the name or NULL if the taxId has no name
+     */
+    extern char *TaxonomyTableName(TaxonomyTable_t *table, int taxId);
+
+    /**
+     * Return the rank name of the taxId
+     * 
+     * @param table the NCBI Taxonomy table
+     * @param taxId the taxId (it has to be in the table)
+     * @return the rank name
+     */
+    extern char *TaxonomyTableRank(TaxonomyTable_t *table, int taxId);
+
+    /**
+     * Append to the lineage array the taxId and its ancestors up to the 
+     * root (the root, taxId 1, is not included). It is the same list 
+     * returned by the getLineage method
+     * 
+     * @param table the NCBI Taxonomy table
+     * @param taxId the taxId
+     * @param lineage the array of TaxIds of the lineage
+     * @param count the number of elements in the lineage array
+     */
+    extern void TaxonomyTableLineage(TaxonomyTable_t *table, int taxId, int **lineage, int *count);
+
+    /**
+     * Number the taxonomies in a depth first walk of the tree (Euler tour)
+     * so the descendants of a taxId are a contiguous interval. The tree 
+     * is the one used by TaxonomyTableLineage: the root (taxId 1) is not 
+     * an ancestor of the other taxonomies
+     * 
+     * @param table the NCBI Taxonomy table
+     */
+    extern void TaxonomyTableEulerTour(TaxonomyTable_t *table);
+
+    /**
+     * Check if the ancestor is in the lineage of the taxId (a taxId is its
+     * own ancestor). TaxonomyTableEulerTour has to be called before
+     * 
+     * @param table the NCBI Taxonomy table
+     * @param taxId the taxId
+     * @param ancestor the ancestor taxId
+     * @return 1 if the ancestor is in the lineage of the taxId
+     */
+    extern int TaxonomyTableIsDescendant(TaxonomyTable_t *table, int taxId, int ancestor);
+
+    /**
+     * Fill the mark array with 1 for the taxonomies that have any of the 
+     * taxIds in their lineage and 0 for the rest. It is a single pass 
+     * over the Euler tour (TaxonomyTableEulerTour has to be called before)
+     * 
+     * @param table the NCBI Taxonomy table
+     * @param taxIds the ancestor taxIds
+     * @param count the number of ancestor taxIds
+     * @param mark an array of maxTaxId + 1 elements
+     */
+    extern void TaxonomyTableDescendants(TaxonomyTable_t *table, int *taxIds, int count, char *mark);
+
+    /**
+     * Free the table
+     * 
+     * @param table the NCBI Taxonomy table
+     */
+    extern void TaxonomyTableFree(TaxonomyTable_t *table);
+
 
 #ifdef	__cplusplus
 }
@@ -35,13 +35,20 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/src/accession.o \
+	${OBJECTDIR}/src/bbitset.o \
 	${OBJECTDIR}/src/berror.o \
 	${OBJECTDIR}/src/bmemory.o \
+	${OBJECTDIR}/src/bsimd.o \
 	${OBJECTDIR}/src/bstring.o \
 	${OBJECTDIR}/src/btime.o \
 	${OBJECTDIR}/src/btree.o \
+	${OBJECTDIR}/src/btreeimage.o \
 	${OBJECTDIR}/src/btreestring.o \
+	${OBJECTDIR}/src/bzindex.o \
+	${OBJECTDIR}/src/bzreader.o \
 	${OBJECTDIR}/src/fasta.o \
+	${OBJECTDIR}/src/gitaxmap.o \
 	${OBJECTDIR}/src/taxonomy.o
 
 # Test Directory
@@ -51,7 +58,14 @@ TESTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}/tests
 TESTFILES= \
 	${TESTDIR}/TestFiles/f1 \
 	${TESTDIR}/TestFiles/f3 \
-	${TESTDIR}/TestFiles/f2
+	${TESTDIR}/TestFiles/f2 \
+	${TESTDIR}/TestFiles/f5 \
+	${TESTDIR}/TestFiles/f6 \
+	${TESTDIR}/TestFiles/f7 \
+	${TESTDIR}/TestFiles/f8 \
+	${TESTDIR}/TestFiles/f9 \
+	${TESTDIR}/TestFiles/f10 \
+	${TESTDIR}/TestFiles/f11
 
 # C Compiler Flags
 CFLAGS=
@@ -77,6 +91,16 @@ ${TESTDIR}/TestFiles/f4: ${OBJECTFILES}
 	${MKDIR} -p ${TESTDIR}/TestFiles
 	${LINK.c} -o ${TESTDIR}/TestFiles/f4 ${OBJECTFILES} ${LDLIBSOPTIONS} -shared -fPIC
 
+${OBJECTDIR}/src/accession.o: src/accession.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/accession.o src/accession.c
+
+${OBJECTDIR}/src/bbitset.o: src/bbitset.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/bbitset.o src/bbitset.c
+
 ${OBJECTDIR}/src/berror.o: src/berror.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -87,6 +111,11 @@ ${OBJECTDIR}/src/bmemory.o: src/bmemory.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/bmemory.o src/bmemory.c
 
+${OBJECTDIR}/src/bsimd.o: src/bsimd.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/bsimd.o src/bsimd.c
+
 ${OBJECTDIR}/src/bstring.o: src/bstring.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -102,16 +131,36 @@ ${OBJECTDIR}/src/btree.o: src/btree.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/btree.o src/btree.c
 
+${OBJECTDIR}/src/btreeimage.o: src/btreeimage.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/btreeimage.o src/btreeimage.c
+
 ${OBJECTDIR}/src/btreestring.o: src/btreestring.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/btreestring.o src/btreestring.c
 
+${OBJECTDIR}/src/bzindex.o: src/bzindex.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/bzindex.o src/bzindex.c
+
+${OBJECTDIR}/src/bzreader.o: src/bzreader.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/bzreader.o src/bzreader.c
+
 ${OBJECTDIR}/src/fasta.o: src/fasta.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/fasta.o src/fasta.c
 
+${OBJECTDIR}/src/gitaxmap.o: src/gitaxmap.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/gitaxmap.o src/gitaxmap.c
+
 ${OBJECTDIR}/src/taxonomy.o: src/taxonomy.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
@@ -128,12 +177,40 @@ ${TESTDIR}/TestFiles/f1: ${TESTDIR}/tests/errortest.o ${OBJECTFILES:%.o=%_nomain
 
 ${TESTDIR}/TestFiles/f3: ${TESTDIR}/tests/fastatest.o ${OBJECTFILES:%.o=%_nomain.o}
 	${MKDIR} -p ${TESTDIR}/TestFiles
-	${LINK.c}   -o ${TESTDIR}/TestFiles/f3 $^ ${LDLIBSOPTIONS} -lcunit -lcunit 
+	${LINK.c}   -o ${TESTDIR}/TestFiles/f3 $^ ${LDLIBSOPTIONS} -lcunit -lcunit -lpthread -lz
 
 ${TESTDIR}/TestFiles/f2: ${TESTDIR}/tests/memorytest.o ${OBJECTFILES:%.o=%_nomain.o}
 	${MKDIR} -p ${TESTDIR}/TestFiles
 	${LINK.c}   -o ${TESTDIR}/TestFiles/f2 $^ ${LDLIBSOPTIONS} -lcunit 
 
+${TESTDIR}/TestFiles/f5: ${TESTDIR}/tests/btreetest.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.c}   -o ${TESTDIR}/TestFiles/f5 $^ ${LDLIBSOPTIONS} -lcunit -lpthread -lz
+
+${TESTDIR}/TestFiles/f6: ${TESTDIR}/tests/taxonomytest.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.c}   -o ${TESTDIR}/TestFiles/f6 $^ ${LDLIBSOPTIONS} -lcunit -lpthread -lz
+
+${TESTDIR}/TestFiles/f7: ${TESTDIR}/tests/bzreadertest.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.c}   -o ${TESTDIR}/TestFiles/f7 $^ ${LDLIBSOPTIONS} -lcunit -lpthread -lz
+
+${TESTDIR}/TestFiles/f8: ${TESTDIR}/tests/bzindextest.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.c}   -o ${TESTDIR}/TestFiles/f8 $^ ${LDLIBSOPTIONS} -lcunit -lpthread -lz
+
+${TESTDIR}/TestFiles/f9: ${TESTDIR}/tests/gitaxmaptest.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.c}   -o ${TESTDIR}/TestFiles/f9 $^ ${LDLIBSOPTIONS} -lcunit -lpthread -lz
+
+${TESTDIR}/TestFiles/f10: ${TESTDIR}/tests/accessiontest.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.c}   -o ${TESTDIR}/TestFiles/f10 $^ ${LDLIBSOPTIONS} -lcunit -lpthread -lz
+
+${TESTDIR}/TestFiles/f11: ${TESTDIR}/tests/bitsettest.o ${OBJECTFILES:%.o=%_nomain.o}
+	${MKDIR} -p ${TESTDIR}/TestFiles
+	${LINK.c}   -o ${TESTDIR}/TestFiles/f11 $^ ${LDLIBSOPTIONS} -lcunit -lpthread -lz
+
 
 ${TESTDIR}/tests/errortest.o: tests/errortest.c 
 	${MKDIR} -p ${TESTDIR}/tests
@@ -153,6 +230,74 @@ ${TESTDIR}/tests/memorytest.o: tests/memorytest.c
 	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/memorytest.o tests/memorytest.c
 
 
+${TESTDIR}/tests/btreetest.o: tests/btreetest.c 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/btreetest.o tests/btreetest.c
+
+
+${TESTDIR}/tests/taxonomytest.o: tests/taxonomytest.c 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/taxonomytest.o tests/taxonomytest.c
+
+
+${TESTDIR}/tests/bzreadertest.o: tests/bzreadertest.c 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/bzreadertest.o tests/bzreadertest.c
+
+
+${TESTDIR}/tests/bzindextest.o: tests/bzindextest.c 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/bzindextest.o tests/bzindextest.c
+
+
+${TESTDIR}/tests/gitaxmaptest.o: tests/gitaxmaptest.c 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/gitaxmaptest.o tests/gitaxmaptest.c
+
+
+${TESTDIR}/tests/accessiontest.o: tests/accessiontest.c 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/accessiontest.o tests/accessiontest.c
+
+
+${TESTDIR}/tests/bitsettest.o: tests/bitsettest.c 
+	${MKDIR} -p ${TESTDIR}/tests
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${TESTDIR}/tests/bitsettest.o tests/bitsettest.c
+
+
+${OBJECTDIR}/src/accession_nomain.o: ${OBJECTDIR}/src/accession.o src/accession.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/accession.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.c) -O2 -fPIC  -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/accession_nomain.o src/accession.c;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/accession.o ${OBJECTDIR}/src/accession_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/bbitset_nomain.o: ${OBJECTDIR}/src/bbitset.o src/bbitset.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/bbitset.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.c) -O2 -fPIC  -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/bbitset_nomain.o src/bbitset.c;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/bbitset.o ${OBJECTDIR}/src/bbitset_nomain.o;\
+	fi
+
 ${OBJECTDIR}/src/berror_nomain.o: ${OBJECTDIR}/src/berror.o src/berror.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/berror.o`; \
@@ -179,6 +324,19 @@ ${OBJECTDIR}/src/bmemory_nomain.o: ${OBJECTDIR}/src/bmemory.o src/bmemory.c
 	    ${CP} ${OBJECTDIR}/src/bmemory.o ${OBJECTDIR}/src/bmemory_nomain.o;\
 	fi
 
+${OBJECTDIR}/src/bsimd_nomain.o: ${OBJECTDIR}/src/bsimd.o src/bsimd.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/bsimd.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.c) -O2 -fPIC  -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/bsimd_nomain.o src/bsimd.c;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/bsimd.o ${OBJECTDIR}/src/bsimd_nomain.o;\
+	fi
+
 ${OBJECTDIR}/src/bstring_nomain.o: ${OBJECTDIR}/src/bstring.o src/bstring.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/bstring.o`; \
@@ -218,6 +376,19 @@ ${OBJECTDIR}/src/btree_nomain.o: ${OBJECTDIR}/src/btree.o src/btree.c
 	    ${CP} ${OBJECTDIR}/src/btree.o ${OBJECTDIR}/src/btree_nomain.o;\
 	fi
 
+${OBJECTDIR}/src/btreeimage_nomain.o: ${OBJECTDIR}/src/btreeimage.o src/btreeimage.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/btreeimage.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.c) -O2 -fPIC  -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/btreeimage_nomain.o src/btreeimage.c;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/btreeimage.o ${OBJECTDIR}/src/btreeimage_nomain.o;\
+	fi
+
 ${OBJECTDIR}/src/btreestring_nomain.o: ${OBJECTDIR}/src/btreestring.o src/btreestring.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/btreestring.o`; \
@@ -231,6 +402,32 @@ ${OBJECTDIR}/src/btreestring_nomain.o: ${OBJECTDIR}/src/btreestring.o src/btrees
 	    ${CP} ${OBJECTDIR}/src/btreestring.o ${OBJECTDIR}/src/btreestring_nomain.o;\
 	fi
 
+${OBJECTDIR}/src/bzindex_nomain.o: ${OBJECTDIR}/src/bzindex.o src/bzindex.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/bzindex.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.c) -O2 -fPIC  -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/bzindex_nomain.o src/bzindex.c;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/bzindex.o ${OBJECTDIR}/src/bzindex_nomain.o;\
+	fi
+
+${OBJECTDIR}/src/bzreader_nomain.o: ${OBJECTDIR}/src/bzreader.o src/bzreader.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/bzreader.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.c) -O2 -fPIC  -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/bzreader_nomain.o src/bzreader.c;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/bzreader.o ${OBJECTDIR}/src/bzreader_nomain.o;\
+	fi
+
 ${OBJECTDIR}/src/fasta_nomain.o: ${OBJECTDIR}/src/fasta.o src/fasta.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/fasta.o`; \
@@ -244,6 +441,19 @@ ${OBJECTDIR}/src/fasta_nomain.o: ${OBJECTDIR}/src/fasta.o src/fasta.c
 	    ${CP} ${OBJECTDIR}/src/fasta.o ${OBJECTDIR}/src/fasta_nomain.o;\
 	fi
 
+${OBJECTDIR}/src/gitaxmap_nomain.o: ${OBJECTDIR}/src/gitaxmap.o src/gitaxmap.c 
+	${MKDIR} -p ${OBJECTDIR}/src
+	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/gitaxmap.o`; \
+	if (echo "$$NMOUTPUT" | ${GREP} '|main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T main$$') || \
+	   (echo "$$NMOUTPUT" | ${GREP} 'T _main$$'); \
+	then  \
+	    ${RM} "$@.d";\
+	    $(COMPILE.c) -O2 -fPIC  -Dmain=__nomain -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/gitaxmap_nomain.o src/gitaxmap.c;\
+	else  \
+	    ${CP} ${OBJECTDIR}/src/gitaxmap.o ${OBJECTDIR}/src/gitaxmap_nomain.o;\
+	fi
+
 ${OBJECTDIR}/src/taxonomy_nomain.o: ${OBJECTDIR}/src/taxonomy.o src/taxonomy.c 
 	${MKDIR} -p ${OBJECTDIR}/src
 	@NMOUTPUT=`${NM} ${OBJECTDIR}/src/taxonomy.o`; \
@@ -264,6 +474,13 @@ ${OBJECTDIR}/src/taxonomy_nomain.o: ${OBJECTDIR}/src/taxonomy.o src/taxonomy.c
 	    ${TESTDIR}/TestFiles/f1 || true; \
 	    ${TESTDIR}/TestFiles/f3 || true; \
 	    ${TESTDIR}/TestFiles/f2 || true; \
+	    ${TESTDIR}/TestFiles/f5 || true; \
+	    ${TESTDIR}/TestFiles/f6 || true; \
+	    ${TESTDIR}/TestFiles/f7 || true; \
+	    ${TESTDIR}/TestFiles/f8 || true; \
+	    ${TESTDIR}/TestFiles/f9 || true; \
+	    ${TESTDIR}/TestFiles/f10 || true; \
+	    ${TESTDIR}/TestFiles/f11 || true; \
 	else  \
 	    ./${TEST} || true; \
 	fi
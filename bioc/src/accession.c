@@ -0,0 +1,603 @@
+/*
+ * File:   accession.c
+ * Author: roberto
+ *
+ * Created on Oct 19, 2026, 12:30 AM
+ */
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "btime.h"
+#include "berror.h"
+#include "bmemory.h"
+#include "bzreader.h"
+#include "gitaxmap.h"
+#include "accession.h"
+
+extern uint64_t packed_words(uint64_t count, unsigned int bits);
+extern uint64_t packed_get(const uint64_t *words, uint64_t i, unsigned int bits);
+extern void packed_set(uint64_t *words, uint64_t i, unsigned int bits, uint64_t value);
+extern void gitaxmap_layout(GiTaxMap_t *map);
+extern uint64_t gitaxmap_size(GiTaxMapHeader_t *header);
+extern int64_t gitaxmap_find_index(GiTaxMap_t *map, uint64_t key);
+extern void gitaxmap_find_batch(GiTaxMap_t *map, const int *gis, const uint64_t *keys, int n, int *taxIds, int64_t *indexes);
+
+/* Bits of the number in the keys of the rows read from the file */
+#define ACCESSION_NUMBER_BITS 40
+#define ACCESSION_GROUPS_MAX (1 << 24)
+
+/*
+ * A line of the accession2taxid file. The key is the position of the
+ * group in the file and the number until the groups are sorted
+ */
+typedef struct acc_row_t {
+    uint64_t key;
+    int taxId;
+    int version;
+} acc_row_t;
+
+/*
+ * The groups of the file in order of appearance and a hash table with
+ * their position + 1 (0 is an empty slot)
+ */
+typedef struct acc_groups_t {
+    AccessionGroup_t *groups;
+    int count;
+    int capacity;
+    int *table;
+    int tableSize;
+} acc_groups_t;
+
+static uint32_t group_hash(const char *prefix, int digits) {
+    uint32_t hash = 2166136261U;
+
+    while (*prefix) hash = (hash ^ (unsigned char) *prefix++) * 16777619U;
+    return (hash ^ digits) * 16777619U;
+}
+
+/*
+ * Return the position of the group of the accession, adding it if it is
+ * new, and extend the group range to the number
+ */
+static int group_id(acc_groups_t *groups, const char *prefix, int digits, uint64_t number) {
+    AccessionGroup_t *group;
+    int i, slot;
+
+    if (2 * (groups->count + 1) > groups->tableSize) {
+        if (groups->count + 1 >= ACCESSION_GROUPS_MAX) {
+            checkPointerError(NULL, "Too many accession groups", __FILE__, __LINE__, -1);
+        }
+        free(groups->table);
+        groups->tableSize = (groups->tableSize == 0) ? 1024 : groups->tableSize * 2;
+        groups->table = checkPointerError(calloc(groups->tableSize, sizeof (int)), "Can't allocate memory", __FILE__, __LINE__, -1);
+        for (i = 0; i < groups->count; i++) {
+            slot = group_hash(groups->groups[i].prefix, groups->groups[i].digits) & (groups->tableSize - 1);
+            while (groups->table[slot] != 0) slot = (slot + 1) & (groups->tableSize - 1);
+            groups->table[slot] = i + 1;
+        }
+    }
+    slot = group_hash(prefix, digits) & (groups->tableSize - 1);
+    while (groups->table[slot] != 0) {
+        group = &groups->groups[groups->table[slot] - 1];
+        if (group->digits == (uint32_t) digits && strcmp(group->prefix, prefix) == 0) {
+            if (number < group->first) group->first = number;
+            if (number > group->last) group->last = number;
+            return groups->table[slot] - 1;
+        }
+        slot = (slot + 1) & (groups->tableSize - 1);
+    }
+    if (groups->count == groups->capacity) {
+        groups->capacity = (groups->capacity == 0) ? 1024 : groups->capacity * 2;
+        groups->groups = reallocate(groups->groups, sizeof (AccessionGroup_t) * groups->capacity, __FILE__, __LINE__);
+    }
+    group = &groups->groups[groups->count];
+    memset(group, 0, sizeof (AccessionGroup_t));
+    strcpy(group->prefix, prefix);
+    group->digits = digits;
+    group->first = group->last = number;
+    groups->table[slot] = ++groups->count;
+    return groups->count - 1;
+}
+
+/*
+ * Order of the groups: by prefix and number of digits
+ */
+static int compare_group(const void *a, const void *b) {
+    const AccessionGroup_t *x = a, *y = b;
+    int cmp = strcmp(x->prefix, y->prefix);
+
+    if (cmp != 0) return cmp;
+    return (x->digits > y->digits) - (x->digits < y->digits);
+}
+
+/*
+ * Order of the rows: by key and the latest version first
+ */
+static int compare_acc_row(const void *a, const void *b) {
+    const acc_row_t *x = a, *y = b;
+
+    if (x->key != y->key) return (x->key < y->key) ? -1 : 1;
+    return (x->version > y->version) ? -1 : (x->version < y->version);
+}
+
+/*
+ * Parse the decimal number at p, up to end. Return -1 if there is not
+ * a number
+ */
+static int parse_int(const char *p, const char *end) {
+    int value = 0;
+
+    if (p >= end || *p < '0' || *p > '9') return -1;
+    while (p < end && *p >= '0' && *p <= '9') value = value * 10 + (*p++ - '0');
+    return value;
+}
+
+/*
+ * Set the array pointers of the index from its header
+ */
+static void acctaxmap_layout(AccTaxMap_t *map) {
+    AccTaxMapHeader_t *header = map->header = (AccTaxMapHeader_t *) map->map;
+
+    map->groups = (AccessionGroup_t *) ((char *) map->map + sizeof (AccTaxMapHeader_t));
+    map->versions = (uint64_t *) (map->groups + header->groups);
+    map->keys.map = map->versions + packed_words(header->count, header->versionBits);
+    map->keys.size = map->size - ((char *) map->keys.map - (char *) map->map);
+    map->keys.mapped = 0;
+    gitaxmap_layout(&map->keys);
+}
+
+/**
+ * Split an accession in its prefix, number and version
+ *
+ * @param accession the accession (it does not need to end with '\0')
+ * @param length the accession length
+ * @param prefix returns the prefix (ACCESSION_PREFIX bytes)
+ * @param number returns the number
+ * @param digits returns the number of digits of the number
+ * @param version returns the version or 0 if the accession has not version
+ * @return 1 if the accession can be encoded (prefix of [A-Z_], up to
+ * ACCESSION_DIGITS digits and an optional version), 0 otherwise
+ */
+int AccessionParse(const char *accession, int length, char *prefix, uint64_t *number, int *digits, int *version) {
+    int i = 0, n = 0;
+
+    while (i < length && ((accession[i] >= 'A' && accession[i] <= 'Z') || accession[i] == '_')) {
+        if (i == ACCESSION_PREFIX - 1) return 0;
+        prefix[i] = accession[i];
+        i++;
+    }
+    if (i == 0) return 0;
+    prefix[i] = '\0';
+    *number = 0;
+    while (i < length && accession[i] >= '0' && accession[i] <= '9') {
+        if (n == ACCESSION_DIGITS) return 0;
+        *number = *number * 10 + (accession[i++] - '0');
+        n++;
+    }
+    if (n == 0) return 0;
+    *digits = n;
+    *version = 0;
+    if (i < length && accession[i] == '.') {
+        i++;
+        for (n = 0; i < length && n < 9 && accession[i] >= '0' && accession[i] <= '9'; n++) {
+            *version = *version * 10 + (accession[i++] - '0');
+        }
+        if (n == 0) return 0;
+    }
+    return i == length;
+}
+
+/**
+ * Return the accession of a fasta header: the first word, the field
+ * after gi|number|db| in the old NCBI headers or the field after
+ * db| in headers like ref|NC_000913.3|
+ *
+ * @param header the header line, with or without the '>'
+ * @param length the header length
+ * @param accession returns the start of the accession in the header
+ * @return the accession length or 0 if there is not accession
+ */
+int AccessionFromHeader(const char *header, int length, const char **accession) {
+    const char *p = header, *end = header + length, *q;
+    int fields = 0;
+
+    if (p < end && *p == '>') p++;
+    for (q = p; q < end && *q != ' ' && *q != '\t' && *q != '\n' && *q != '\r'; q++);
+    end = q;
+    if (end - p > 3 && strncmp(p, "gi|", 3) == 0) {
+        fields = 3;
+    } else if (memchr(p, '|', end - p) != NULL) {
+        fields = 1;
+    }
+    while (fields > 0 && p < end) {
+        if (*p++ == '|') fields--;
+    }
+    for (q = p; q < end && *q != '|'; q++);
+    *accession = p;
+    return q - p;
+}
+
+/**
+ * Encode an accession with the groups of the index
+ *
+ * @param map the index
+ * @param accession the accession
+ * @param length the accession length
+ * @param version returns the version or 0 if the accession has not version
+ * @return the key or 0 if the accession can't be encoded or its group is not in the index
+ */
+uint64_t AccessionEncode(AccTaxMap_t *map, const char *accession, int length, int *version) {
+    AccessionGroup_t key, *group;
+    uint64_t number;
+    int digits;
+
+    *version = 0;
+    if (!AccessionParse(accession, length, key.prefix, &number, &digits, version)) return 0;
+    key.digits = digits;
+    group = bsearch(&key, map->groups, map->header->groups, sizeof (AccessionGroup_t), compare_group);
+    if (group == NULL || number < group->first || number > group->last) return 0;
+    return group->base + number - group->first;
+}
+
+/**
+ * Write the accession of a key
+ *
+ * @param map the index
+ * @param key the key
+ * @param version the version or 0 to write the accession without version
+ * @param accession returns the accession (ACCESSION_LENGTH bytes)
+ * @return the accession length or 0 if the key is not valid
+ */
+int AccessionDecode(AccTaxMap_t *map, uint64_t key, int version, char *accession) {
+    uint64_t low = 0, high = map->header->groups, mid;
+    AccessionGroup_t *group;
+    unsigned long long number;
+
+    accession[0] = '\0';
+    /* The last group with base <= key */
+    while (low < high) {
+        mid = (low + high) / 2;
+        if (map->groups[mid].base <= key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == 0) return 0;
+    group = &map->groups[low - 1];
+    number = key - group->base + group->first;
+    if (number > group->last) return 0;
+    if (version > 0) {
+        return snprintf(accession, ACCESSION_LENGTH, "%s%0*llu.%d", group->prefix, (int) group->digits, number, version);
+    }
+    return snprintf(accession, ACCESSION_LENGTH, "%s%0*llu", group->prefix, (int) group->digits, number);
+}
+
+/**
+ * Read an accession2taxid file from NCBI Taxonomy (plain or gzip
+ * compressed) into an index. The accession.version and taxid columns
+ * are used, the files with only these two columns (like
+ * prot.accession2taxid.FULL) are supported. The accessions that can't be
+ * encoded are skipped
+ *
+ * @param accession2taxid the accession2taxid file
+ * @param verbose 1 to print a verbose info
+ * @return the index
+ */
+AccTaxMap_t *AccTaxMapLoad(char *accession2taxid, int verbose) {
+    struct timespec start, stop;
+    ZReader_t *reader;
+    AccTaxMap_t *map;
+    GiTaxMap_t *keys;
+    AccessionGroup_t *sorted, *group;
+    acc_groups_t groups;
+    acc_row_t *rows = NULL;
+    uint64_t i, n, count = 0, capacity = 0, skipped = 0, number, base, *sortedKeys, *versions;
+    char *block, *line, *end, *nl, *p, *field[4], *accession, *accessionEnd;
+    char prefix[ACCESSION_PREFIX];
+    int f, digits, version, taxId, maxVersion = 0, inOrder = 1, *remap, *taxIds;
+    unsigned int versionBits = 0;
+    size_t size;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    memset(&groups, 0, sizeof (acc_groups_t));
+    reader = zreaderOpen(accession2taxid);
+    while ((block = zreaderLines(reader, &size)) != NULL) {
+        end = block + size;
+        for (line = block; line < end; line = nl + 1) {
+            if ((nl = memchr(line, '\n', end - line)) == NULL) nl = end;
+            /* accession, accession.version, taxid, gi or accession.version, taxid */
+            field[0] = line;
+            for (f = 0, p = line; p < nl && f < 3; p++) {
+                if (*p == '\t') field[++f] = p + 1;
+            }
+            if (f >= 2) {
+                accession = field[1];
+                accessionEnd = field[2] - 1;
+                taxId = parse_int(field[2], nl);
+            } else if (f == 1) {
+                accession = field[0];
+                accessionEnd = field[1] - 1;
+                taxId = parse_int(field[1], nl);
+            } else {
+                continue;
+            }
+            /* The title line */
+            if (taxId < 0) continue;
+            if (!AccessionParse(accession, accessionEnd - accession, prefix, &number, &digits, &version)) {
+                skipped++;
+                continue;
+            }
+            if (count == capacity) {
+                capacity = (capacity == 0) ? (1 << 20) : capacity * 2;
+                rows = reallocate(rows, sizeof (acc_row_t) * capacity, __FILE__, __LINE__);
+            }
+            rows[count].key = ((uint64_t) group_id(&groups, prefix, digits, number) << ACCESSION_NUMBER_BITS) | number;
+            rows[count].taxId = taxId;
+            rows[count].version = version;
+            count++;
+        }
+    }
+    zreaderClose(reader);
+
+    /* The groups are sorted and their bases are the sum of the previous ranges */
+    sorted = allocate(sizeof (AccessionGroup_t) * (groups.count + 1), __FILE__, __LINE__);
+    remap = allocate(sizeof (int) * (groups.count + 1), __FILE__, __LINE__);
+    if (groups.count > 0) memcpy(sorted, groups.groups, sizeof (AccessionGroup_t) * groups.count);
+    qsort(sorted, groups.count, sizeof (AccessionGroup_t), compare_group);
+    for (f = 0, base = 1; f < groups.count; f++) {
+        sorted[f].base = base;
+        base += sorted[f].last - sorted[f].first + 1;
+        if (base >= ((uint64_t) 1 << 63)) {
+            checkPointerError(NULL, "The accession numbers are too sparse", __FILE__, __LINE__, -1);
+        }
+    }
+    for (f = 0; f < groups.count; f++) {
+        remap[f] = (AccessionGroup_t *) bsearch(&groups.groups[f], sorted, groups.count, sizeof (AccessionGroup_t), compare_group) - sorted;
+    }
+    for (i = 0; i < count; i++) {
+        group = &sorted[remap[rows[i].key >> ACCESSION_NUMBER_BITS]];
+        rows[i].key = group->base + (rows[i].key & (((uint64_t) 1 << ACCESSION_NUMBER_BITS) - 1)) - group->first;
+        if (i > 0 && compare_acc_row(&rows[i - 1], &rows[i]) > 0) inOrder = 0;
+    }
+    /* The files from NCBI are sorted by accession */
+    if (!inOrder) qsort(rows, count, sizeof (acc_row_t), compare_acc_row);
+
+    /* The repeated accessions are removed and the keys are moved over the rows */
+    taxIds = allocate(sizeof (int) * (count + 1), __FILE__, __LINE__);
+    for (i = 0, n = 0; i < count; i++) {
+        if (n > 0 && rows[i].key == rows[n - 1].key) continue;
+        rows[n++] = rows[i];
+        if (rows[i].version > maxVersion) maxVersion = rows[i].version;
+    }
+    while (versionBits < 31 && ((int64_t) 1 << versionBits) <= maxVersion) versionBits++;
+    versions = checkPointerError(calloc(packed_words(n, versionBits), sizeof (uint64_t)), "Can't allocate memory", __FILE__, __LINE__, -1);
+    sortedKeys = (uint64_t *) rows;
+    for (i = 0; i < n; i++) {
+        acc_row_t row = rows[i];
+        taxIds[i] = row.taxId;
+        packed_set(versions, i, versionBits, row.version);
+        sortedKeys[i] = row.key;
+    }
+    keys = GiTaxMapCreate64(sortedKeys, taxIds, n);
+    free(rows);
+    free(taxIds);
+
+    /* The index is the header, the groups, the versions and the keys in one block */
+    map = allocate(sizeof (AccTaxMap_t), __FILE__, __LINE__);
+    map->size = sizeof (AccTaxMapHeader_t) + sizeof (AccessionGroup_t) * groups.count
+            + sizeof (uint64_t) * packed_words(n, versionBits) + keys->size;
+    map->mapped = 0;
+    map->map = checkPointerError(calloc(map->size, 1), "Can't allocate memory", __FILE__, __LINE__, -1);
+    map->header = (AccTaxMapHeader_t *) map->map;
+    memcpy(map->header->magic, ACCTAXMAP_MAGIC, sizeof (ACCTAXMAP_MAGIC));
+    map->header->version = ACCTAXMAP_VERSION;
+    map->header->versionBits = versionBits;
+    map->header->groups = groups.count;
+    map->header->count = n;
+    map->header->size = map->size;
+    acctaxmap_layout(map);
+    if (groups.count > 0) memcpy(map->groups, sorted, sizeof (AccessionGroup_t) * groups.count);
+    memcpy(map->versions, versions, sizeof (uint64_t) * packed_words(n, versionBits));
+    memcpy(map->keys.map, keys->map, keys->size);
+    gitaxmap_layout(&map->keys);
+
+    GiTaxMapFree(keys);
+    free(versions);
+    free(sorted);
+    free(remap);
+    if (groups.groups) free(groups.groups);
+    if (groups.table) free(groups.table);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    if (verbose) {
+        printf("\n\tThere are %lu accessions into the index (%.2f bytes per accession), %lu skipped. Elapsed time: %.2f sec\n\n",
+                (unsigned long) n, (n > 0) ? (double) map->size / n : 0.0, (unsigned long) skipped, timespecDiffSec(&stop, &start));
+    }
+    fflush(NULL);
+    return map;
+}
+
+/**
+ * Write the index to a file
+ *
+ * @param map the index
+ * @param name the file name
+ */
+void AccTaxMapWrite(AccTaxMap_t *map, char *name) {
+    FILE *fo = checkPointerError(fopen(name, "wb"), "Can't open the accession index file", __FILE__, __LINE__, -1);
+
+    if (fwrite(map->map, 1, map->size, fo) != map->size || fclose(fo) != 0) {
+        checkPointerError(NULL, "Can't write the accession index file", __FILE__, __LINE__, -1);
+    }
+}
+
+/**
+ * Check if the file is an accession to taxId index
+ *
+ * @param name the file name
+ * @return 1 if the file starts with the index magic number, 0 otherwise
+ */
+int AccTaxMapCheck(char *name) {
+    char magic[sizeof (ACCTAXMAP_MAGIC)];
+    FILE *fd;
+    int isMap = 0;
+
+    if ((fd = fopen(name, "rb")) != NULL) {
+        if (fread(magic, sizeof (magic), 1, fd) == 1) {
+            isMap = (memcmp(magic, ACCTAXMAP_MAGIC, sizeof (magic)) == 0);
+        }
+        fclose(fd);
+    }
+    return isMap;
+}
+
+/**
+ * Check if the file is an accession2taxid text file, plain or gzip 
+ * compressed: its first line is the accession, accession.version header
+ * or its first field is not a number (a gi_taxid file starts with a Gi)
+ *
+ * @param name the file name
+ * @return 1 if the file is an accession2taxid file, 0 otherwise
+ */
+int AccTaxMapCheckText(char *name) {
+    char line[256], *p;
+    gzFile fd;
+    int isText = 0;
+
+    if ((fd = gzopen(name, "rb")) != NULL) {
+        if (gzgets(fd, line, sizeof (line)) != NULL) {
+            if (strncmp(line, "accession\taccession.version", 27) == 0) {
+                isText = 1;
+            } else {
+                for (p = line; *p >= '0' && *p <= '9'; p++);
+                isText = (*p != '\0' && strchr("\t \r\n", *p) == NULL);
+            }
+        }
+        gzclose(fd);
+    }
+    return isText;
+}
+
+/**
+ * Map an index file read-only. The program exits if the file is not a
+ * valid index
+ *
+ * @param name the file name
+ * @return the index
+ */
+AccTaxMap_t *AccTaxMapOpen(char *name) {
+    AccTaxMap_t *map;
+    AccTaxMapHeader_t *header;
+    GiTaxMapHeader_t *keys;
+    uint64_t offset;
+    struct stat st;
+    int fd;
+
+    if ((fd = open(name, O_RDONLY)) == -1 || fstat(fd, &st) == -1) {
+        checkPointerError(NULL, "Can't open the accession index file", __FILE__, __LINE__, -1);
+    }
+    if (st.st_size < (off_t) sizeof (AccTaxMapHeader_t)) {
+        checkPointerError(NULL, "The file is not an accession index", __FILE__, __LINE__, -1);
+    }
+    map = allocate(sizeof (AccTaxMap_t), __FILE__, __LINE__);
+    map->size = st.st_size;
+    map->mapped = 1;
+    map->map = mmap(NULL, map->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map->map == MAP_FAILED) {
+        checkPointerError(NULL, "Can't map the accession index file", __FILE__, __LINE__, -1);
+    }
+    madvise(map->map, map->size, MADV_RANDOM);
+
+    header = (AccTaxMapHeader_t *) map->map;
+    if (memcmp(header->magic, ACCTAXMAP_MAGIC, sizeof (ACCTAXMAP_MAGIC)) != 0
+            || header->version != ACCTAXMAP_VERSION) {
+        checkPointerError(NULL, "The file is not an accession index", __FILE__, __LINE__, -1);
+    }
+    offset = sizeof (AccTaxMapHeader_t) + sizeof (AccessionGroup_t) * header->groups
+            + sizeof (uint64_t) * packed_words(header->count, header->versionBits);
+    keys = (GiTaxMapHeader_t *) ((char *) map->map + offset);
+    if (header->size != map->size || header->versionBits > 31 || offset + sizeof (GiTaxMapHeader_t) > map->size
+            || memcmp(keys->magic, GITAXMAP_MAGIC, sizeof (GITAXMAP_MAGIC)) != 0
+            || keys->count != header->count || offset + gitaxmap_size(keys) != map->size) {
+        checkPointerError(NULL, "The accession index file is truncated or corrupted", __FILE__, __LINE__, -1);
+    }
+    acctaxmap_layout(map);
+    return map;
+}
+
+/**
+ * Find the taxId of an accession. An accession without version matches
+ * any version
+ *
+ * @param map the index
+ * @param accession the accession
+ * @param length the accession length
+ * @return the taxId or -1 if the accession is not in the index
+ */
+int AccTaxMapFind(AccTaxMap_t *map, const char *accession, int length) {
+    uint64_t key;
+    int64_t index;
+    int version;
+
+    key = AccessionEncode(map, accession, length, &version);
+    if (key == 0 || (index = gitaxmap_find_index(&map->keys, key)) < 0) return -1;
+    if (version > 0 && packed_get(map->versions, index, map->header->versionBits) != (uint64_t) version) return -1;
+    return (int) packed_get(map->keys.taxIds, index, map->keys.header->taxIdBits);
+}
+
+/**
+ * Find the taxIds of many accessions at once (see GiTaxMapFindBatch).
+ * The results are the same that AccTaxMapFind returns for each
+ * accession
+ *
+ * @param map the index
+ * @param accessions the accessions
+ * @param lengths the accession lengths
+ * @param n the number of accessions
+ * @param taxIds array of n elements with the taxId of each accession or -1
+ */
+void AccTaxMapFindBatch(AccTaxMap_t *map, char **accessions, int *lengths, int n, int *taxIds) {
+    uint64_t *keys = allocate(sizeof (uint64_t) * (n + 1), __FILE__, __LINE__);
+    int64_t *indexes = allocate(sizeof (int64_t) * (n + 1), __FILE__, __LINE__);
+    int *versions = allocate(sizeof (int) * (n + 1), __FILE__, __LINE__);
+    int i;
+
+    for (i = 0; i < n; i++) keys[i] = AccessionEncode(map, accessions[i], lengths[i], &versions[i]);
+    gitaxmap_find_batch(&map->keys, NULL, keys, n, taxIds, indexes);
+    for (i = 0; i < n; i++) {
+        if (keys[i] == 0 || (indexes[i] >= 0 && versions[i] > 0
+                && packed_get(map->versions, indexes[i], map->header->versionBits) != (uint64_t) versions[i])) {
+            taxIds[i] = -1;
+        }
+    }
+    free(keys);
+    free(indexes);
+    free(versions);
+}
+
+/**
+ * Free the index (unmap the file)
+ *
+ * @param map the index
+ */
+void AccTaxMapFree(AccTaxMap_t *map) {
+    if (map) {
+        if (map->mapped) {
+            munmap(map->map, map->size);
+        } else {
+            free(map->map);
+        }
+        free(map);
+    }
+}
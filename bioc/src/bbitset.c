@@ -0,0 +1,174 @@
+/*
+ * File:   bbitset.c
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 9:40 PM
+ */
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "berror.h"
+#include "bmemory.h"
+#include "bbitset.h"
+
+/* Number of 64 bits words of a set of size integers */
+static size_t bitset_words(int size) {
+    return ((size_t) size + 63) / 64;
+}
+
+/**
+ * Create an empty set
+ *
+ * @param size the number of integers the set can hold, [0, size)
+ * @return the set
+ */
+Bitset_t *bitsetCreate(int size) {
+    Bitset_t *set = allocate(sizeof (Bitset_t), __FILE__, __LINE__);
+
+    if (size < 0) size = 0;
+    set->size = size;
+    set->words = checkPointerError(calloc((size > 0) ? bitset_words(size) : 1, sizeof (uint64_t)), "Can't allocate memory", __FILE__, __LINE__, -1);
+    return set;
+}
+
+/**
+ * Add an integer to the set. Integers out of [0, size) are ignored
+ *
+ * @param set the set
+ * @param bit the integer
+ */
+void bitsetSet(Bitset_t *set, int bit) {
+    if (bit >= 0 && bit < set->size) set->words[bit >> 6] |= (uint64_t) 1 << (bit & 63);
+}
+
+/**
+ * Remove an integer from the set. Integers out of [0, size) are ignored
+ *
+ * @param set the set
+ * @param bit the integer
+ */
+void bitsetClear(Bitset_t *set, int bit) {
+    if (bit >= 0 && bit < set->size) set->words[bit >> 6] &= ~((uint64_t) 1 << (bit & 63));
+}
+
+/**
+ * Check if an integer is in the set
+ *
+ * @param set the set
+ * @param bit the integer
+ * @return 1 if the integer is in the set, 0 otherwise or if it is out of [0, size)
+ */
+int bitsetTest(Bitset_t *set, int bit) {
+    if (bit < 0 || bit >= set->size) return 0;
+    return (set->words[bit >> 6] >> (bit & 63)) & 1;
+}
+
+/**
+ * Add the integers of other to the set. The integers of other out of
+ * the set range are ignored
+ *
+ * @param set the set
+ * @param other the set to add
+ */
+void bitsetUnion(Bitset_t *set, Bitset_t *other) {
+    size_t i, n = bitset_words((other->size < set->size) ? other->size : set->size);
+
+    for (i = 0; i < n; i++) set->words[i] |= other->words[i];
+    /* The bits of the last word beyond size stay clear */
+    if (set->size % 64 != 0 && n == bitset_words(set->size)) {
+        set->words[n - 1] &= ((uint64_t) 1 << (set->size % 64)) - 1;
+    }
+}
+
+/**
+ * Remove the integers of other from the set
+ *
+ * @param set the set
+ * @param other the set to remove
+ */
+void bitsetDifference(Bitset_t *set, Bitset_t *other) {
+    size_t i, n = bitset_words((other->size < set->size) ? other->size : set->size);
+
+    for (i = 0; i < n; i++) set->words[i] &= ~other->words[i];
+}
+
+/**
+ * Count the integers in the set
+ *
+ * @param set the set
+ * @return the number of integers in the set
+ */
+size_t bitsetCount(Bitset_t *set) {
+    size_t i, count = 0, n = bitset_words(set->size);
+
+    for (i = 0; i < n; i++) count += __builtin_popcountll(set->words[i]);
+    return count;
+}
+
+/**
+ * Write the set to a cache file
+ *
+ * @param set the set
+ * @param filename the file name
+ * @param key the key of the set inputs
+ */
+void bitsetWrite(Bitset_t *set, char *filename, uint64_t key) {
+    BitsetHeader_t header;
+    size_t n = bitset_words(set->size);
+    FILE *fo = checkPointerError(fopen(filename, "wb"), "Can't open the bitset file", __FILE__, __LINE__, -1);
+
+    memset(&header, 0, sizeof (BitsetHeader_t));
+    memcpy(header.magic, BITSET_MAGIC, sizeof (BITSET_MAGIC));
+    header.version = BITSET_VERSION;
+    header.key = key;
+    header.size = set->size;
+    fwrite(&header, sizeof (BitsetHeader_t), 1, fo);
+    if (n > 0) fwrite(set->words, sizeof (uint64_t), n, fo);
+    if (fclose(fo) != 0) {
+        checkPointerError(NULL, "Can't write the bitset file", __FILE__, __LINE__, -1);
+    }
+}
+
+/**
+ * Read a set from a cache file
+ *
+ * @param filename the file name
+ * @param key the key of the set inputs
+ * @return the set or NULL if the file can't be read or it has a different key
+ */
+Bitset_t *bitsetRead(char *filename, uint64_t key) {
+    BitsetHeader_t header;
+    Bitset_t *set = NULL;
+    size_t n;
+    FILE *fd;
+
+    if ((fd = fopen(filename, "rb")) == NULL) return NULL;
+    if (fread(&header, sizeof (BitsetHeader_t), 1, fd) == 1
+            && memcmp(header.magic, BITSET_MAGIC, sizeof (BITSET_MAGIC)) == 0
+            && header.version == BITSET_VERSION && header.key == key
+            && header.size >= 0 && header.size <= INT32_MAX) {
+        set = bitsetCreate(header.size);
+        n = bitset_words(set->size);
+        if (fread(set->words, sizeof (uint64_t), n, fd) != n) {
+            bitsetFree(set);
+            set = NULL;
+        }
+    }
+    fclose(fd);
+    return set;
+}
+
+/**
+ * Free the set
+ *
+ * @param set the set
+ */
+void bitsetFree(Bitset_t *set) {
+    if (set) {
+        if (set->words) free(set->words);
+        free(set);
+    }
+}
@@ -5,8 +5,13 @@
  * Created on April 14, 2014, 11:54 AM
  */
 
+#define _FILE_OFFSET_BITS 64
 #include <stdio.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "berror.h"
 
 /**
@@ -33,6 +38,64 @@ void *reallocate(void *self, size_t size, char *file, int line){
     return checkPointerError(realloc(self,size), "Can't reallocate memory", file, line, -1);
 }
 
+/**
+ * The function allocates memory of size bytes aligned to alignment bytes.
+ * The memory is released with free
+ * 
+ * @param alignment the alignment in bytes (a power of two multiple of sizeof(void *))
+ * @param size size in bytes
+ * @param file the source code file (__FILE__) or NULL to not print this info
+ * @param line the source code line (__LINE__) or 0
+ * @return return a pointer to the allocated memory
+ */
+void *allocateAligned(size_t alignment, size_t size, char *file, int line) {
+    void *self = NULL;
+    if (posix_memalign(&self, alignment, size) != 0) self = NULL;
+    return checkPointerError(self, "Can't allocate memory", file, line, -1);
+}
+
+/**
+ * Map a whole file read-only in memory for a sequential scan. The 
+ * program exits if the file can't be mapped
+ * 
+ * @param filename the file to map
+ * @param size returns the size of the file in bytes
+ * @param file the source code file (__FILE__) or NULL to not print this info
+ * @param line the source code line (__LINE__) or 0
+ * @return a pointer to the file content (an empty string for an empty file)
+ */
+char *mapFile(char *filename, size_t *size, char *file, int line) {
+    struct stat st;
+    void *map;
+    int fd;
+
+    if ((fd = open(filename, O_RDONLY)) == -1 || fstat(fd, &st) == -1) {
+        checkPointerError(NULL, "Can't open the file", file, line, -1);
+    }
+    *size = st.st_size;
+    if (*size == 0) {
+        close(fd);
+        return "";
+    }
+    map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        checkPointerError(NULL, "Can't map the file", file, line, -1);
+    }
+    madvise(map, *size, MADV_SEQUENTIAL);
+    return (char *) map;
+}
+
+/**
+ * Unmap a file mapped with mapFile
+ * 
+ * @param map the pointer returned by mapFile
+ * @param size the size of the file
+ */
+void unmapFile(char *map, size_t size) {
+    if (size != 0) munmap(map, size);
+}
+
 /**
  * Free an array of pointers
  * 
@@ -0,0 +1,329 @@
+/*
+ * File:   bsimd.c
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 11:20 AM
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "bsimd.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BSIMD_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Plain C implementations
+ */
+int countLessIntScalar(const int *keys, int n, int key) {
+    int i, count = 0;
+    for (i = 0; i < n; i++) count += (keys[i] < key);
+    return count;
+}
+
+int countLessPrefixScalar(const uint64_t *prefixes, int n, uint64_t key) {
+    int i, count = 0;
+    for (i = 0; i < n; i++) count += (prefixes[i] < key);
+    return count;
+}
+
+size_t findLineStartScalar(const char *data, size_t size, char c, size_t *lines) {
+    size_t i;
+    for (i = 0; i < size; i++) {
+        if (data[i] == '\n') {
+            (*lines)++;
+            if (i + 1 < size && data[i + 1] == c) return i + 1;
+        }
+    }
+    return size;
+}
+
+size_t countBasesScalar(const char *data, size_t size, size_t *acgt) {
+    size_t i, n = 0, b = 0;
+    char c;
+    for (i = 0; i < size; i++) {
+        n += (data[i] == 'N');
+        c = data[i] | 0x20;
+        b += (c == 'a') + (c == 'c') + (c == 'g') + (c == 't');
+    }
+    *acgt += b;
+    return n;
+}
+
+#ifdef BSIMD_X86
+
+/*
+ * SSE4.2 implementations: 4 ints or 2 prefixes per compare. The prefixes
+ * are unsigned so the sign bit is flipped before the signed compare
+ */
+__attribute__((target("sse4.2,popcnt")))
+int countLessIntSse42(const int *keys, int n, int key) {
+    int i, count = 0;
+    __m128i k = _mm_set1_epi32(key);
+    for (i = 0; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (keys + i));
+        count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, k))));
+    }
+    for (; i < n; i++) count += (keys[i] < key);
+    return count;
+}
+
+__attribute__((target("sse4.2,popcnt")))
+int countLessPrefixSse42(const uint64_t *prefixes, int n, uint64_t key) {
+    int i, count = 0;
+    __m128i sign = _mm_set1_epi64x((long long) 0x8000000000000000ULL);
+    __m128i k = _mm_xor_si128(_mm_set1_epi64x((long long) key), sign);
+    for (i = 0; i + 2 <= n; i += 2) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (prefixes + i)), sign);
+        count += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(k, v))));
+    }
+    for (; i < n; i++) count += (prefixes[i] < key);
+    return count;
+}
+
+/*
+ * 16 bytes per step: the newline mask of the block and the mask of the
+ * block shifted by one byte compared against c give the line starts
+ */
+__attribute__((target("sse4.2,popcnt")))
+size_t findLineStartSse42(const char *data, size_t size, char c, size_t *lines) {
+    size_t i;
+    unsigned int nl, hit;
+    __m128i n = _mm_set1_epi8('\n');
+    __m128i k = _mm_set1_epi8(c);
+    for (i = 0; i + 17 <= size; i += 16) {
+        nl = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (data + i)), n));
+        hit = nl & _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (data + i + 1)), k));
+        if (hit) {
+            hit = __builtin_ctz(hit);
+            *lines += __builtin_popcount(nl & ((2U << hit) - 1));
+            return i + hit + 1;
+        }
+        *lines += __builtin_popcount(nl);
+    }
+    return i + findLineStartScalar(data + i, size - i, c, lines);
+}
+
+/*
+ * 16 bytes per step: the bytes are compared with N and then lowercased 
+ * with 0x20 (only the A, C, G and T letters map to a, c, g and t) and 
+ * compared with the bases
+ */
+__attribute__((target("sse4.2,popcnt")))
+size_t countBasesSse42(const char *data, size_t size, size_t *acgt) {
+    size_t i, n = 0, b = 0;
+    __m128i lower = _mm_set1_epi8(0x20);
+    __m128i kn = _mm_set1_epi8('N'), ka = _mm_set1_epi8('a'), kc = _mm_set1_epi8('c');
+    __m128i kg = _mm_set1_epi8('g'), kt = _mm_set1_epi8('t');
+    for (i = 0; i + 16 <= size; i += 16) {
+        __m128i r = _mm_loadu_si128((const __m128i *) (data + i));
+        __m128i v = _mm_or_si128(r, lower);
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, ka), _mm_cmpeq_epi8(v, kc)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, kg), _mm_cmpeq_epi8(v, kt)));
+        n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(r, kn)));
+        b += __builtin_popcount(_mm_movemask_epi8(m));
+    }
+    *acgt += b;
+    return n + countBasesScalar(data + i, size - i, acgt);
+}
+
+/*
+ * AVX2 implementations: 8 ints or 4 prefixes per compare
+ */
+__attribute__((target("avx2,popcnt")))
+int countLessIntAvx2(const int *keys, int n, int key) {
+    int i, count = 0;
+    __m256i k = _mm256_set1_epi32(key);
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (keys + i));
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, v))));
+    }
+    for (; i < n; i++) count += (keys[i] < key);
+    return count;
+}
+
+__attribute__((target("avx2,popcnt")))
+int countLessPrefixAvx2(const uint64_t *prefixes, int n, uint64_t key) {
+    int i, count = 0;
+    __m256i sign = _mm256_set1_epi64x((long long) 0x8000000000000000ULL);
+    __m256i k = _mm256_xor_si256(_mm256_set1_epi64x((long long) key), sign);
+    for (i = 0; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (prefixes + i)), sign);
+        count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v))));
+    }
+    for (; i < n; i++) count += (prefixes[i] < key);
+    return count;
+}
+
+__attribute__((target("avx2,popcnt")))
+size_t findLineStartAvx2(const char *data, size_t size, char c, size_t *lines) {
+    size_t i;
+    uint64_t nl, hit;
+    __m256i n = _mm256_set1_epi8('\n');
+    __m256i k = _mm256_set1_epi8(c);
+    for (i = 0; i + 33 <= size; i += 32) {
+        nl = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (data + i)), n));
+        hit = nl & (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (data + i + 1)), k));
+        if (hit) {
+            hit = __builtin_ctzll(hit);
+            *lines += __builtin_popcountll(nl & ((2ULL << hit) - 1));
+            return i + hit + 1;
+        }
+        *lines += __builtin_popcountll(nl);
+    }
+    return i + findLineStartScalar(data + i, size - i, c, lines);
+}
+
+__attribute__((target("avx2,popcnt")))
+size_t countBasesAvx2(const char *data, size_t size, size_t *acgt) {
+    size_t i, n = 0, b = 0;
+    __m256i lower = _mm256_set1_epi8(0x20);
+    __m256i kn = _mm256_set1_epi8('N'), ka = _mm256_set1_epi8('a'), kc = _mm256_set1_epi8('c');
+    __m256i kg = _mm256_set1_epi8('g'), kt = _mm256_set1_epi8('t');
+    for (i = 0; i + 32 <= size; i += 32) {
+        __m256i r = _mm256_loadu_si256((const __m256i *) (data + i));
+        __m256i v = _mm256_or_si256(r, lower);
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, ka), _mm256_cmpeq_epi8(v, kc)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, kg), _mm256_cmpeq_epi8(v, kt)));
+        n += __builtin_popcount((uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(r, kn)));
+        b += __builtin_popcount((uint32_t) _mm256_movemask_epi8(m));
+    }
+    *acgt += b;
+    return n + countBasesScalar(data + i, size - i, acgt);
+}
+#endif
+
+/* Implementations in use, selected by setSimdLevel */
+int (*count_less_int)(const int *, int, int) = countLessIntScalar;
+int (*count_less_prefix)(const uint64_t *, int, uint64_t) = countLessPrefixScalar;
+size_t(*find_line_start)(const char *, size_t, char, size_t *) = findLineStartScalar;
+size_t(*count_bases)(const char *, size_t, size_t *) = countBasesScalar;
+
+/**
+ * Return the best implementation supported by the CPU
+ *
+ * @return SIMD_SCALAR, SIMD_SSE42 or SIMD_AVX2
+ */
+int getSimdSupported(void) {
+#ifdef BSIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) return SIMD_SSE42;
+#endif
+    return SIMD_SCALAR;
+}
+
+/**
+ * Set the implementation used by the search functions. The level is
+ * capped to the best one supported by the CPU
+ *
+ * @param level SIMD_SCALAR, SIMD_SSE42 or SIMD_AVX2
+ * @return the level in use after the call
+ */
+int setSimdLevel(int level) {
+    int supported = getSimdSupported();
+    if (level > supported) level = supported;
+    count_less_int = countLessIntScalar;
+    count_less_prefix = countLessPrefixScalar;
+    find_line_start = findLineStartScalar;
+    count_bases = countBasesScalar;
+#ifdef BSIMD_X86
+    if (level == SIMD_AVX2) {
+        count_less_int = countLessIntAvx2;
+        count_less_prefix = countLessPrefixAvx2;
+        find_line_start = findLineStartAvx2;
+        count_bases = countBasesAvx2;
+    } else if (level == SIMD_SSE42) {
+        count_less_int = countLessIntSse42;
+        count_less_prefix = countLessPrefixSse42;
+        find_line_start = findLineStartSse42;
+        count_bases = countBasesSse42;
+    }
+#endif
+    return (level < SIMD_SCALAR) ? SIMD_SCALAR : level;
+}
+
+#ifdef __GNUC__
+
+/*
+ * Select the best implementation before main runs
+ */
+__attribute__((constructor))
+void init_simd_level(void) {
+    setSimdLevel(SIMD_AVX2);
+}
+#endif
+
+/**
+ * Count the number of elements lower than key in a sorted int array.
+ * This is the index of the first element greater than or equal to key
+ *
+ * @param keys the sorted array
+ * @param n the number of elements in the array
+ * @param key the key to compare
+ * @return the number of elements lower than key
+ */
+int countLessInt(const int *keys, int n, int key) {
+    return count_less_int(keys, n, key);
+}
+
+/**
+ * Count the number of elements lower than key in a sorted array of
+ * unsigned 64 bits string prefixes (see stringPrefix)
+ *
+ * @param prefixes the sorted array
+ * @param n the number of elements in the array
+ * @param key the prefix to compare
+ * @return the number of elements lower than key
+ */
+int countLessPrefix(const uint64_t *prefixes, int n, uint64_t key) {
+    return count_less_prefix(prefixes, n, key);
+}
+
+/**
+ * Find the first line that starts with the character c. The newlines 
+ * up to that line are added to lines. A line starting at data[0] is not
+ * found because the newline before it is not in the block
+ *
+ * @param data the block of text
+ * @param size the number of bytes in the block
+ * @param c the first character of the line to find
+ * @param lines returns the number of newlines added
+ * @return the offset of the line or size if there is not such line
+ */
+size_t findLineStart(const char *data, size_t size, char c, size_t *lines) {
+    return find_line_start(data, size, c, lines);
+}
+
+/**
+ * Count the N bases of a sequence block, upper case only like the 
+ * NNNNN check of the splitter, and the ACGT bases, upper or lower case
+ *
+ * @param data the sequence block
+ * @param size the number of bases in the block
+ * @param acgt returns the number of ACGT bases added
+ * @return the number of N bases
+ */
+size_t countBases(const char *data, size_t size, size_t *acgt) {
+    return count_bases(data, size, acgt);
+}
+
+/**
+ * Pack the first 8 bytes of the string in big-endian order so the
+ * prefixes compare as unsigned integers in the same order that strcmp
+ * compares the strings. Equal prefixes need a strcmp to break the tie
+ *
+ * @param str the string
+ * @return the prefix
+ */
+uint64_t stringPrefix(const char *str) {
+    uint64_t prefix = 0;
+    int i;
+    for (i = 0; i < 8; i++) {
+        prefix <<= 8;
+        if (*str != '\0') prefix |= (unsigned char) *str++;
+    }
+    return prefix;
+}
@@ -23,8 +23,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
 #include "btree.h"
+#include "bsimd.h"
 #include "berror.h"
 #include "bmemory.h"
 #include "taxonomy.h"
@@ -57,6 +61,20 @@ bool verbose_output = false;
 
 BtreeNode_t * insert_into_parent(BtreeNode_t * root, BtreeNode_t * left, int key, BtreeNode_t * right);
 
+/**
+ * Set the order used by the B+ tree functions. It must be called
+ * before any tree is created, the trees already created keep the
+ * order they were built with and must not be used after the change.
+ * 
+ * @param newOrder the new order (between MIN_ORDER and MAX_ORDER)
+ * @return the order in use after the call
+ */
+int BtreeSetOrder(int newOrder) {
+    if (newOrder >= MIN_ORDER && newOrder <= MAX_ORDER)
+        order = newOrder;
+    return order;
+}
+
 /* Finds the appropriate place to
  * split a node that is too big into two.
  */
@@ -67,6 +85,34 @@ int cut(int length) {
         return length / 2 + 1;
 }
 
+/* Number of keys scanned with the vector compare
+ * once the binary search has narrowed the range.
+ */
+#define SEARCH_WINDOW 64
+
+/* Returns the index of the first key in the sorted
+ * array that is greater than or equal to key.
+ * A binary search narrows big nodes to SEARCH_WINDOW
+ * keys and the rest is counted with vector compares.
+ */
+int lower_bound(int *keys, int num_keys, int key) {
+    int lo = 0, hi = num_keys, mid;
+    while (hi - lo > SEARCH_WINDOW) {
+        mid = (lo + hi) / 2;
+        if (keys[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo + countLessInt(keys + lo, hi - lo, key);
+}
+
+/* Returns the number of keys in the sorted
+ * array that are less than or equal to key.
+ */
+int upper_bound(int *keys, int num_keys, int key) {
+    if (key == INT_MAX) return num_keys;
+    return lower_bound(keys, num_keys, key + 1);
+}
+
 /* Traces the path from the root to a leaf, searching
  * by key.  Displays information about the path
  * if the verbose flag is set.
@@ -87,11 +133,7 @@ BtreeNode_t * find_leaf(BtreeNode_t * root, int key, bool verbose) {
                 printf("%d ", c->keys[i]);
             printf("%d] ", c->keys[i]);
         }
-        i = 0;
-        while (i < c->num_keys) {
-            if (key >= c->keys[i]) i++;
-            else break;
-        }
+        i = upper_bound(c->keys, c->num_keys, key);
         if (verbose)
             printf("%d ->\n", i);
         c = (BtreeNode_t *) c->pointers[i];
@@ -117,12 +159,73 @@ BtreeRecord_t * BTreeFind(BtreeNode_t * root, int key, bool verbose) {
     int i = 0;
     BtreeNode_t * c = find_leaf(root, key, verbose);
     if (c == NULL) return NULL;
-    for (i = 0; i < c->num_keys; i++)
-        if (c->keys[i] == key) break;
-    if (i == c->num_keys)
+    i = lower_bound(c->keys, c->num_keys, key);
+    if (i == c->num_keys || c->keys[i] != key)
         return NULL;
     else
-        return (BtreeRecord_t *) c->pointers[i];
+        return &(c->records[i]);
+}
+
+/* Size of the node header, rounded up to whole cache
+ * lines. The keys start right after it (see make_node).
+ */
+#define NODE_HEADER_SIZE ((sizeof (BtreeNode_t) + BTREE_CACHE_LINE - 1) & ~((size_t) BTREE_CACHE_LINE - 1))
+
+/* Number of keys walked together by BTreeFindBatch. */
+#define FIND_BATCH 16
+
+/* Issues the prefetches for the cache lines of a node
+ * that the search is going to touch: the header and the
+ * keys around the first steps of the binary search.
+ */
+void prefetch_node(BtreeNode_t * n) {
+    char *keys = (char *) n + NODE_HEADER_SIZE;
+    __builtin_prefetch(n, 0, 1);
+    __builtin_prefetch(keys + ((order - 1) / 4) * sizeof (int), 0, 1);
+    __builtin_prefetch(keys + ((order - 1) / 2) * sizeof (int), 0, 1);
+    __builtin_prefetch(keys + (3 * (order - 1) / 4) * sizeof (int), 0, 1);
+}
+
+/**
+ * Finds the records of many keys at once. The keys are walked down
+ * the tree in groups, one level at a time for the whole group, and
+ * the nodes of the next level are prefetched so the memory accesses
+ * of the different keys overlap. The results are the same that
+ * BTreeFind returns for each key.
+ * 
+ * @param root the root node
+ * @param keys the keys to find
+ * @param n the number of keys
+ * @param out array of n elements with the record of each key or NULL
+ */
+void BTreeFindBatch(BtreeNode_t * root, int *keys, int n, BtreeRecord_t **out) {
+    BtreeNode_t * nodes[FIND_BATCH];
+    int i, j, k, m;
+
+    for (i = 0; i < n; i += FIND_BATCH) {
+        m = (n - i < FIND_BATCH) ? n - i : FIND_BATCH;
+        if (root == NULL) {
+            for (j = 0; j < m; j++) out[i + j] = NULL;
+            continue;
+        }
+        for (j = 0; j < m; j++) nodes[j] = root;
+
+        /* All the leaves are at the same depth */
+        while (!nodes[0]->is_leaf) {
+            for (j = 0; j < m; j++) {
+                k = upper_bound(nodes[j]->keys, nodes[j]->num_keys, keys[i + j]);
+                nodes[j] = (BtreeNode_t *) nodes[j]->pointers[k];
+                prefetch_node(nodes[j]);
+            }
+        }
+        for (j = 0; j < m; j++) {
+            k = lower_bound(nodes[j]->keys, nodes[j]->num_keys, keys[i + j]);
+            if (k < nodes[j]->num_keys && nodes[j]->keys[k] == keys[i + j])
+                out[i + j] = &(nodes[j]->records[k]);
+            else
+                out[i + j] = NULL;
+        }
+    }
 }
 
 /* Creates a new record to hold the value
@@ -136,13 +239,25 @@ BtreeRecord_t * make_record(void *value) {
 
 /* Creates a new general node, which can be adapted
  * to serve as either a leaf or an internal node.
+ * The node header takes the first cache lines of the
+ * block, followed by the keys and then the pointers,
+ * so a node is a single aligned allocation.
  */
 BtreeNode_t * make_node(void) {
     BtreeNode_t * new_node;
-    new_node = allocate(sizeof (BtreeNode_t), __FILE__, __LINE__);
-    new_node->keys = allocate((order - 1) * sizeof (int), __FILE__, __LINE__);
-    new_node->pointers = allocate(order * sizeof (void *), __FILE__, __LINE__);
-
+    size_t header_size, keys_size, size;
+    char *block;
+
+    header_size = NODE_HEADER_SIZE;
+    keys_size = ((order - 1) * sizeof (int) + sizeof (void *) - 1) & ~(sizeof (void *) - 1);
+    size = header_size + keys_size + order * sizeof (void *);
+    block = allocateAligned(BTREE_CACHE_LINE, size, __FILE__, __LINE__);
+    memset(block, 0, size);
+
+    new_node = (BtreeNode_t *) block;
+    new_node->keys = (int *) (block + header_size);
+    new_node->pointers = (void **) (block + header_size + keys_size);
+    new_node->records = (BtreeRecord_t *) new_node->pointers;
     new_node->is_leaf = false;
     new_node->num_keys = 0;
     new_node->parent = NULL;
@@ -173,33 +288,31 @@ int get_left_index(BtreeNode_t * parent, BtreeNode_t * left) {
 /* First insertion:
  * start a new tree.
  */
-BtreeNode_t * start_new_tree(int key, BtreeRecord_t * pointer) {
+BtreeNode_t * start_new_tree(int key, void * value) {
     BtreeNode_t * root = make_leaf();
     root->keys[0] = key;
-    root->pointers[0] = pointer;
+    root->records[0].value = value;
     root->pointers[order - 1] = NULL;
     root->parent = NULL;
     root->num_keys++;
     return root;
 }
 
-/* Inserts a new pointer to a record and its corresponding
+/* Inserts a new record value and its corresponding
  * key into a leaf.
  * Returns the altered leaf.
  */
-BtreeNode_t * insert_into_leaf(BtreeNode_t * leaf, int key, BtreeRecord_t * pointer) {
-    int i, insertion_point;
+BtreeNode_t * insert_into_leaf(BtreeNode_t * leaf, int key, void * value) {
+    int insertion_point;
 
-    insertion_point = 0;
-    while (insertion_point < leaf->num_keys && leaf->keys[insertion_point] < key)
-        insertion_point++;
+    insertion_point = lower_bound(leaf->keys, leaf->num_keys, key);
 
-    for (i = leaf->num_keys; i > insertion_point; i--) {
-        leaf->keys[i] = leaf->keys[i - 1];
-        leaf->pointers[i] = leaf->pointers[i - 1];
-    }
+    memmove(leaf->keys + insertion_point + 1, leaf->keys + insertion_point,
+            (leaf->num_keys - insertion_point) * sizeof (int));
+    memmove(leaf->records + insertion_point + 1, leaf->records + insertion_point,
+            (leaf->num_keys - insertion_point) * sizeof (BtreeRecord_t));
     leaf->keys[insertion_point] = key;
-    leaf->pointers[insertion_point] = pointer;
+    leaf->records[insertion_point].value = value;
     leaf->num_keys++;
     return leaf;
 }
@@ -350,63 +463,45 @@ BtreeNode_t * insert_into_parent(BtreeNode_t * root, BtreeNode_t * left, int key
     return insert_into_node_after_splitting(root, parent, left_index, key, right);
 }
 
-/* Inserts a new key and pointer
- * to a new record into a leaf so as to exceed
+/* Inserts a new key and record value
+ * into a leaf so as to exceed
  * the tree's order, causing the leaf to be split
  * in half.
  */
-BtreeNode_t * insert_into_leaf_after_splitting(BtreeNode_t * root, BtreeNode_t * leaf, int key, BtreeRecord_t * pointer) {
+BtreeNode_t * insert_into_leaf_after_splitting(BtreeNode_t * root, BtreeNode_t * leaf, int key, void * value) {
 
     BtreeNode_t * new_leaf;
-    int * temp_keys;
-    void ** temp_pointers;
-    int insertion_index, split, new_key, i, j;
+    int insertion_index, split, new_key, moved;
 
     new_leaf = make_leaf();
 
-    temp_keys = allocate(order * sizeof (int), __FILE__, __LINE__);
-    temp_pointers = allocate(order * sizeof (void *), __FILE__, __LINE__);
-
-    insertion_index = 0;
-    while (insertion_index < order - 1 && leaf->keys[insertion_index] < key)
-        insertion_index++;
-
-    for (i = 0, j = 0; i < leaf->num_keys; i++, j++) {
-        if (j == insertion_index) j++;
-        temp_keys[j] = leaf->keys[i];
-        temp_pointers[j] = leaf->pointers[i];
-    }
-
-    temp_keys[insertion_index] = key;
-    temp_pointers[insertion_index] = pointer;
-
-    leaf->num_keys = 0;
-
+    /* The leaf is full (order - 1 keys) and the new key
+     * makes order keys: the first split stay in the old leaf
+     * and the rest go to the new one.
+     */
+    insertion_index = lower_bound(leaf->keys, leaf->num_keys, key);
     split = cut(order - 1);
 
-    for (i = 0; i < split; i++) {
-        leaf->pointers[i] = temp_pointers[i];
-        leaf->keys[i] = temp_keys[i];
-        leaf->num_keys++;
-    }
-
-    for (i = split, j = 0; i < order; i++, j++) {
-        new_leaf->pointers[j] = temp_pointers[i];
-        new_leaf->keys[j] = temp_keys[i];
-        new_leaf->num_keys++;
+    if (insertion_index < split) {
+        moved = leaf->num_keys - (split - 1);
+        memcpy(new_leaf->keys, leaf->keys + split - 1, moved * sizeof (int));
+        memcpy(new_leaf->records, leaf->records + split - 1, moved * sizeof (BtreeRecord_t));
+        new_leaf->num_keys = moved;
+        leaf->num_keys = split - 1;
+        insert_into_leaf(leaf, key, value);
+    } else {
+        moved = leaf->num_keys - split;
+        memcpy(new_leaf->keys, leaf->keys + split, moved * sizeof (int));
+        memcpy(new_leaf->records, leaf->records + split, moved * sizeof (BtreeRecord_t));
+        new_leaf->num_keys = moved;
+        leaf->num_keys = split;
+        insert_into_leaf(new_leaf, key, value);
     }
-
-    free(temp_pointers);
-    free(temp_keys);
+    memset(leaf->records + leaf->num_keys, 0, (order - 1 - leaf->num_keys) * sizeof (BtreeRecord_t));
 
     new_leaf->pointers[order - 1] = leaf->pointers[order - 1];
     leaf->pointers[order - 1] = new_leaf;
 
-    for (i = leaf->num_keys; i < order - 1; i++)
-        leaf->pointers[i] = NULL;
-    for (i = new_leaf->num_keys; i < order - 1; i++)
-        new_leaf->pointers[i] = NULL;
-
     new_leaf->parent = leaf->parent;
     new_key = new_leaf->keys[0];
 
@@ -427,28 +522,15 @@ BtreeNode_t * insert_into_leaf_after_splitting(BtreeNode_t * root, BtreeNode_t *
  */
 BtreeNode_t * BtreeInsert(BtreeNode_t * root, int key, void *value) {
 
-    BtreeRecord_t * pointer;
     BtreeNode_t * leaf;
-
-    /* The current implementation ignores
-     * duplicates.
-     */
-
-    if (BTreeFind(root, key, false) != NULL)
-        return root;
-
-    /* Create a new record for the
-     * value.
-     */
-    pointer = make_record(value);
-
+    int i;
 
     /* Case: the tree does not exist yet.
      * Start a new tree.
      */
 
     if (root == NULL)
-        return start_new_tree(key, pointer);
+        return start_new_tree(key, value);
 
 
     /* Case: the tree already exists.
@@ -457,11 +539,19 @@ BtreeNode_t * BtreeInsert(BtreeNode_t * root, int key, void *value) {
 
     leaf = find_leaf(root, key, false);
 
-    /* Case: leaf has room for key and pointer.
+    /* The current implementation ignores
+     * duplicates.
+     */
+
+    i = lower_bound(leaf->keys, leaf->num_keys, key);
+    if (i < leaf->num_keys && leaf->keys[i] == key)
+        return root;
+
+    /* Case: leaf has room for key and value.
      */
 
     if (leaf->num_keys < order - 1) {
-        leaf = insert_into_leaf(leaf, key, pointer);
+        leaf = insert_into_leaf(leaf, key, value);
         return root;
     }
 
@@ -469,7 +559,167 @@ BtreeNode_t * BtreeInsert(BtreeNode_t * root, int key, void *value) {
     /* Case:  leaf must be split.
      */
 
-    return insert_into_leaf_after_splitting(root, leaf, key, pointer);
+    return insert_into_leaf_after_splitting(root, leaf, key, value);
+}
+
+/* Pair of key and original position used
+ * to sort the bulk load arrays keeping the
+ * first value of duplicated keys.
+ */
+typedef struct bulk_pair {
+    int key;
+    int pos;
+} bulk_pair_t;
+
+int compare_bulk_pair(const void *a, const void *b) {
+    const bulk_pair_t *x = (const bulk_pair_t *) a;
+    const bulk_pair_t *y = (const bulk_pair_t *) b;
+    if (x->key != y->key)
+        return (x->key < y->key) ? -1 : 1;
+    return (x->pos < y->pos) ? -1 : (x->pos > y->pos);
+}
+
+/* Sorts the keys and the values in place by key.
+ * Equal keys keep their original relative order.
+ */
+void sort_bulk_arrays(int *keys, void **values, int n) {
+    int i;
+    bulk_pair_t *pairs;
+    void **tmp;
+
+    for (i = 1; i < n; i++)
+        if (keys[i - 1] > keys[i]) break;
+    if (i >= n) return;
+
+    pairs = allocate(sizeof (bulk_pair_t) * n, __FILE__, __LINE__);
+    for (i = 0; i < n; i++) {
+        pairs[i].key = keys[i];
+        pairs[i].pos = i;
+    }
+    qsort(pairs, n, sizeof (bulk_pair_t), compare_bulk_pair);
+
+    tmp = allocate(sizeof (void *) * n, __FILE__, __LINE__);
+    for (i = 0; i < n; i++) {
+        keys[i] = pairs[i].key;
+        tmp[i] = values[pairs[i].pos];
+    }
+    memcpy(values, tmp, sizeof (void *) * n);
+    free(tmp);
+    free(pairs);
+}
+
+/* Builds the parent level of the nodes array.
+ * Each parent takes up to order children and
+ * the last two parents are balanced so none of
+ * them ends up with a single child.
+ * The nodes and firsts arrays are overwritten with
+ * the new level and its number of nodes is returned.
+ */
+int build_parent_level(BtreeNode_t **nodes, int *firsts, int n) {
+    int i, j, c, taken, parents;
+    BtreeNode_t *parent;
+
+    parents = 0;
+    for (i = 0; i < n; i += taken) {
+        taken = n - i;
+        if (taken > order) {
+            taken = order;
+            if (n - i - taken == 1) taken--;
+        }
+        parent = make_node();
+        for (j = 0; j < taken; j++) {
+            c = i + j;
+            parent->pointers[j] = nodes[c];
+            nodes[c]->parent = parent;
+            if (j > 0) parent->keys[j - 1] = firsts[c];
+        }
+        parent->num_keys = taken - 1;
+        nodes[parents] = parent;
+        firsts[parents] = firsts[i];
+        parents++;
+    }
+    return parents;
+}
+
+/**
+ * Bulk load function.
+ * Builds the B+ tree bottom-up from an array of keys and
+ * the array of their associated values. The leaves are
+ * fully packed and every internal node is built only once,
+ * so there is no root-to-leaf descent or node split per key.
+ * The arrays are sorted in place by key if they are not
+ * sorted yet. As in BtreeInsert, duplicated keys are ignored
+ * and the first value of the key is kept.
+ *
+ * @param keys the keys array
+ * @param values the values array
+ * @param n the number of elements in the arrays
+ * @return the root node
+ */
+BtreeNode_t * BtreeBulkLoad(int *keys, void **values, int n) {
+    int i, leaves;
+    int *firsts;
+    BtreeNode_t **nodes;
+    BtreeNode_t *leaf, *prev;
+
+    if (n <= 0) return NULL;
+    sort_bulk_arrays(keys, values, n);
+
+    nodes = allocate(sizeof (BtreeNode_t *) * (n / (order - 1) + 1), __FILE__, __LINE__);
+    firsts = allocate(sizeof (int) * (n / (order - 1) + 1), __FILE__, __LINE__);
+
+    /* Fill the leaves from left to right
+     * linking each one to its right sibling.
+     */
+    leaves = 0;
+    leaf = prev = NULL;
+    for (i = 0; i < n; i++) {
+        if (i > 0 && keys[i] == keys[i - 1]) continue;
+        if (leaf == NULL || leaf->num_keys == order - 1) {
+            leaf = make_leaf();
+            if (prev) prev->pointers[order - 1] = leaf;
+            nodes[leaves] = leaf;
+            firsts[leaves] = keys[i];
+            leaves++;
+            prev = leaf;
+        }
+        leaf->keys[leaf->num_keys] = keys[i];
+        leaf->records[leaf->num_keys].value = values[i];
+        leaf->num_keys++;
+    }
+
+    /* Build the internal levels until
+     * only the root is left.
+     */
+    while (leaves > 1)
+        leaves = build_parent_level(nodes, firsts, leaves);
+
+    leaf = nodes[0];
+    free(nodes);
+    free(firsts);
+    return leaf;
+}
+
+/**
+ * Append a key and its value to the arrays used by BtreeBulkLoad,
+ * growing the arrays as needed
+ *
+ * @param keys the keys array
+ * @param values the values array
+ * @param n the number of elements in the arrays
+ * @param capacity the allocated number of elements in the arrays
+ * @param key the key to append
+ * @param value the value to append
+ */
+void BtreeBulkAppend(int **keys, void ***values, int *n, int *capacity, int key, void *value) {
+    if (*n == *capacity) {
+        *capacity = (*capacity == 0) ? 1024 : *capacity * 2;
+        *keys = reallocate(*keys, sizeof (int) * *capacity, __FILE__, __LINE__);
+        *values = reallocate(*values, sizeof (void *) * *capacity, __FILE__, __LINE__);
+    }
+    (*keys)[*n] = key;
+    (*values)[*n] = value;
+    (*n)++;
 }
 
 /* Helper function for printing the
@@ -587,7 +837,7 @@ void BtreeRecordsToArray(void ***index, int *size, BtreeNode_t * root) {
     } else {
         *index = (void **) realloc(*index, sizeof (void**) * (*size + root->num_keys));
         for (i = 0; i < root->num_keys; i++) {
-            (*index)[*size + i] = ((BtreeRecord_t *) root->pointers[i])->value;
+            (*index)[*size + i] = root->records[i].value;
         }
         *size += root->num_keys;
     };
@@ -615,19 +865,16 @@ void destroy_tree_nodes(BtreeNode_t * root, void freeRecord(void *)) {
     int i;
     if (root == NULL) return;
     if (root->is_leaf) {
-        for (i = 0; i < root->num_keys; i++) {
-            if (freeRecord != NULL) {
-                freeRecord(((BtreeRecord_t*) root->pointers[i])->value);
+        if (freeRecord != NULL) {
+            for (i = 0; i < root->num_keys; i++) {
+                freeRecord(root->records[i].value);
             }
-            free(root->pointers[i]);
         }
     } else {
         for (i = 0; i < root->num_keys + 1; i++) {
             destroy_tree_nodes(root->pointers[i], freeRecord);
         }
     }
-    free(root->pointers);
-    free(root->keys);
     free(root);
 }
 
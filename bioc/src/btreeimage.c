@@ -0,0 +1,303 @@
+/*
+ * File:   btreeimage.c
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 10:05 AM
+ */
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "btree.h"
+#include "berror.h"
+#include "bmemory.h"
+#include "btreeimage.h"
+
+extern int order;
+
+extern int lower_bound(int *keys, int num_keys, int key);
+extern int upper_bound(int *keys, int num_keys, int key);
+
+/*
+ * Return the address of the page number in the image
+ */
+BtreeImageNode_t *image_page(BtreeImage_t *image, uint64_t page) {
+    return (BtreeImageNode_t *) ((char *) image->map + page * image->header->pageSize);
+}
+
+/*
+ * Write a page and zero the buffer for the next one
+ */
+void write_image_page(FILE *fo, char *page) {
+    if (fwrite(page, BTREE_IMAGE_PAGE, 1, fo) != 1) {
+        checkPointerError(NULL, "Can't write the B+ tree image", __FILE__, __LINE__, -1);
+    }
+    memset(page, 0, BTREE_IMAGE_PAGE);
+}
+
+/*
+ * State of an image being written: the leaf page being filled and the
+ * first key of each leaf written
+ */
+typedef struct image_writer_t {
+    BtreeImageHeader_t header;
+    FILE *fo;
+    char *page;
+    int *firsts;
+    uint64_t nodes;
+} image_writer_t;
+
+/*
+ * Open the image file and write an empty header page
+ */
+void open_image_writer(image_writer_t *writer, char *name, size_t valueSize) {
+    BtreeImageHeader_t *header = &writer->header;
+
+    memset(header, 0, sizeof (BtreeImageHeader_t));
+    memcpy(header->magic, BTREE_IMAGE_MAGIC, sizeof (BTREE_IMAGE_MAGIC));
+    header->version = BTREE_IMAGE_VERSION;
+    header->pageSize = BTREE_IMAGE_PAGE;
+    header->valueSize = valueSize;
+    /* Even capacities keep the values 8 bytes aligned */
+    header->leafCapacity = ((BTREE_IMAGE_PAGE - sizeof (BtreeImageNode_t)) / (sizeof (int) + valueSize)) & ~1U;
+    header->internalCapacity = ((BTREE_IMAGE_PAGE - sizeof (BtreeImageNode_t) - sizeof (uint32_t)) / (sizeof (int) + sizeof (uint32_t))) & ~1U;
+
+    writer->fo = checkPointerError(fopen(name, "wb"), "Can't open the B+ tree image file", __FILE__, __LINE__, -1);
+    writer->page = allocate(BTREE_IMAGE_PAGE, __FILE__, __LINE__);
+    writer->firsts = NULL;
+    writer->nodes = 0;
+    write_image_page(writer->fo, writer->page);
+}
+
+/*
+ * Add a key to the leaves, pages 1 .. nodes. The keys are added in
+ * increasing order
+ */
+void add_image_key(image_writer_t *writer, int key, void *value) {
+    BtreeImageNode_t *node = (BtreeImageNode_t *) writer->page;
+    int *keys = (int *) (writer->page + sizeof (BtreeImageNode_t));
+    char *values = (char *) (keys + writer->header.leafCapacity);
+
+    if (node->num_keys == writer->header.leafCapacity) {
+        write_image_page(writer->fo, writer->page);
+        writer->nodes++;
+    }
+    if (node->num_keys == 0) {
+        writer->firsts = reallocate(writer->firsts, sizeof (int) * (writer->nodes + 1), __FILE__, __LINE__);
+        writer->firsts[writer->nodes] = key;
+        node->is_leaf = 1;
+    }
+    keys[node->num_keys] = key;
+    memcpy(values + node->num_keys * writer->header.valueSize, value, writer->header.valueSize);
+    node->num_keys++;
+    writer->header.numKeys++;
+}
+
+/*
+ * Write the last leaf, the internal levels and the header and close the
+ * image file
+ */
+void close_image_writer(image_writer_t *writer) {
+    BtreeImageHeader_t *header = &writer->header;
+    BtreeImageNode_t *node = (BtreeImageNode_t *) writer->page;
+    int *keys, *firsts = writer->firsts;
+    uint32_t *children;
+    uint64_t nodes = writer->nodes, level, next, first, i, j;
+
+    if (node->num_keys != 0) {
+        write_image_page(writer->fo, writer->page);
+        nodes++;
+    }
+    header->height = (nodes != 0);
+
+    /* Internal levels, each level is written after the one below it */
+    first = 1;
+    keys = (int *) (writer->page + sizeof (BtreeImageNode_t));
+    children = (uint32_t *) (keys + header->internalCapacity);
+    while (nodes > 1) {
+        level = 0;
+        next = first + nodes;
+        for (i = 0; i < nodes; i += header->internalCapacity + 1) {
+            for (j = i; j < nodes && j <= i + header->internalCapacity; j++) {
+                if (j != i) keys[j - i - 1] = firsts[j];
+                children[j - i] = first + j;
+            }
+            node->is_leaf = 0;
+            node->num_keys = j - i - 1;
+            firsts[level++] = firsts[i];
+            write_image_page(writer->fo, writer->page);
+        }
+        first = next;
+        nodes = level;
+        header->height++;
+    }
+    header->root = (header->height != 0) ? first : 0;
+    header->numPages = first + nodes;
+
+    rewind(writer->fo);
+    memcpy(writer->page, header, sizeof (BtreeImageHeader_t));
+    write_image_page(writer->fo, writer->page);
+    if (fclose(writer->fo) != 0) {
+        checkPointerError(NULL, "Can't write the B+ tree image", __FILE__, __LINE__, -1);
+    }
+    free(writer->page);
+    if (firsts) free(firsts);
+}
+
+/**
+ * Write the B+ tree as an on-disk image. The values are copied from the
+ * records (valueSize bytes from each record value)
+ *
+ * @param name the output file name
+ * @param root the B+ tree root
+ * @param valueSize the size in bytes of each value (sizeof(off_t), sizeof(int), ...)
+ */
+void BtreeImageWrite(char *name, BtreeNode_t *root, size_t valueSize) {
+    image_writer_t writer;
+    BtreeNode_t *leaf = root;
+    int k;
+
+    while (leaf && !leaf->is_leaf) leaf = (BtreeNode_t *) leaf->pointers[0];
+    open_image_writer(&writer, name, valueSize);
+    while (leaf) {
+        for (k = 0; k < leaf->num_keys; k++) {
+            add_image_key(&writer, leaf->keys[k], leaf->records[k].value);
+        }
+        leaf = (BtreeNode_t *) leaf->pointers[order - 1];
+    }
+    close_image_writer(&writer);
+}
+
+/**
+ * Write an on-disk image from sorted arrays of keys and values, without
+ * building the B+ tree in memory. Only the first value of a repeated key
+ * is written
+ *
+ * @param name the output file name
+ * @param keys the keys sorted in increasing order
+ * @param values the n values, valueSize bytes each
+ * @param n the number of keys
+ * @param valueSize the size in bytes of each value (sizeof(off_t), sizeof(int), ...)
+ */
+void BtreeImageWriteArrays(char *name, int *keys, void *values, int n, size_t valueSize) {
+    image_writer_t writer;
+    int i;
+
+    open_image_writer(&writer, name, valueSize);
+    for (i = 0; i < n; i++) {
+        if (i > 0 && keys[i] == keys[i - 1]) continue;
+        if (i > 0 && keys[i] < keys[i - 1]) {
+            checkPointerError(NULL, "The keys of the B+ tree image are not sorted", __FILE__, __LINE__, -1);
+        }
+        add_image_key(&writer, keys[i], (char *) values + (size_t) i * valueSize);
+    }
+    close_image_writer(&writer);
+}
+
+/**
+ * Check if the file is a B+ tree image
+ *
+ * @param name the file name
+ * @return 1 if the file starts with the image magic number, 0 otherwise
+ */
+int BtreeImageCheck(char *name) {
+    char magic[sizeof (BTREE_IMAGE_MAGIC)];
+    FILE *fd;
+    int isImage = 0;
+
+    if ((fd = fopen(name, "rb")) != NULL) {
+        if (fread(magic, sizeof (magic), 1, fd) == 1) {
+            isImage = (memcmp(magic, BTREE_IMAGE_MAGIC, sizeof (magic)) == 0);
+        }
+        fclose(fd);
+    }
+    return isImage;
+}
+
+/**
+ * Map a B+ tree image read-only. The program exits if the file is not a
+ * valid image
+ *
+ * @param name the file name
+ * @param valueSize the expected size of the values or 0 to skip the check
+ * @return the image
+ */
+BtreeImage_t *BtreeImageOpen(char *name, size_t valueSize) {
+    BtreeImage_t *image;
+    BtreeImageHeader_t *header;
+    struct stat st;
+    int fd;
+
+    if ((fd = open(name, O_RDONLY)) == -1 || fstat(fd, &st) == -1) {
+        checkPointerError(NULL, "Can't open the B+ tree image file", __FILE__, __LINE__, -1);
+    }
+    if (st.st_size < BTREE_IMAGE_PAGE) {
+        checkPointerError(NULL, "The file is not a B+ tree image", __FILE__, __LINE__, -1);
+    }
+    image = allocate(sizeof (BtreeImage_t), __FILE__, __LINE__);
+    image->size = st.st_size;
+    image->map = mmap(NULL, image->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (image->map == MAP_FAILED) {
+        checkPointerError(NULL, "Can't map the B+ tree image file", __FILE__, __LINE__, -1);
+    }
+    madvise(image->map, image->size, MADV_RANDOM);
+
+    header = image->header = (BtreeImageHeader_t *) image->map;
+    if (memcmp(header->magic, BTREE_IMAGE_MAGIC, sizeof (BTREE_IMAGE_MAGIC)) != 0
+            || header->version != BTREE_IMAGE_VERSION) {
+        checkPointerError(NULL, "The file is not a B+ tree image", __FILE__, __LINE__, -1);
+    }
+    if (header->pageSize != BTREE_IMAGE_PAGE || header->numPages * header->pageSize != image->size) {
+        checkPointerError(NULL, "The B+ tree image file is truncated or corrupted", __FILE__, __LINE__, -1);
+    }
+    if (valueSize != 0 && header->valueSize != valueSize) {
+        checkPointerError(NULL, "The B+ tree image has a different value size", __FILE__, __LINE__, -1);
+    }
+    return image;
+}
+
+/**
+ * Find a key in the image
+ *
+ * @param image the image
+ * @param key the key to search
+ * @return a pointer to the value inside the mapping or NULL if the key
+ * is not in the image
+ */
+void *BtreeImageFind(BtreeImage_t *image, int key) {
+    BtreeImageHeader_t *header = image->header;
+    BtreeImageNode_t *node;
+    int *keys;
+    int i;
+
+    if (header->height == 0) return NULL;
+    node = image_page(image, header->root);
+    while (!node->is_leaf) {
+        keys = (int *) (node + 1);
+        i = upper_bound(keys, node->num_keys, key);
+        node = image_page(image, ((uint32_t *) (keys + header->internalCapacity))[i]);
+    }
+    keys = (int *) (node + 1);
+    i = lower_bound(keys, node->num_keys, key);
+    if (i == node->num_keys || keys[i] != key) return NULL;
+    return (char *) (keys + header->leafCapacity) + (size_t) i * header->valueSize;
+}
+
+/**
+ * Unmap and free the image
+ *
+ * @param image the image
+ */
+void BtreeImageClose(BtreeImage_t *image) {
+    if (image) {
+        munmap(image->map, image->size);
+        free(image);
+    }
+}
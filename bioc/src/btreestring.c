@@ -8,7 +8,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "btree.h"
+#include "bsimd.h"
 #include "berror.h"
 #include "bmemory.h"
 #include "btreestring.h"
@@ -21,9 +23,10 @@
  * and every internal node has one more pointer
  * to a subtree than the number of keys.
  * This global variable is initialized to the
- * default value.
+ * default value. The string tree keeps its own
+ * order because its nodes are searched with strcmp.
  */
-extern int order;
+int order_string = DEFAULT_ORDER_STRING;
 
 /* The queue is used to print the tree in
  * level order, starting from the root
@@ -53,8 +56,9 @@ BtreeNodeString_t * insert_into_node_after_splitting_string(BtreeNodeString_t *
 BtreeNodeString_t * make_node_string(void) {
     BtreeNodeString_t * new_node;
     new_node = allocate(sizeof (BtreeNodeString_t), __FILE__, __LINE__);
-    new_node->keys = allocate((order - 1) * sizeof (char **), __FILE__, __LINE__);    
-    new_node->pointers = allocate(order * sizeof (void *), __FILE__, __LINE__);
+    new_node->keys = allocate((order_string - 1) * sizeof (char **), __FILE__, __LINE__);    
+    new_node->pointers = allocate(order_string * sizeof (void *), __FILE__, __LINE__);
+    new_node->prefixes = allocate((order_string - 1) * sizeof (uint64_t), __FILE__, __LINE__);
     
     new_node->is_leaf = false;
     new_node->num_keys = 0;
@@ -72,14 +76,46 @@ BtreeNodeString_t * make_leaf_string(void) {
     return leaf;
 }
 
+/* Recomputes the key prefixes of a node
+ * after its keys were rearranged.
+ */
+void set_prefixes_string(BtreeNodeString_t * n) {
+    int i;
+    for (i = 0; i < n->num_keys; i++)
+        n->prefixes[i] = stringPrefix(n->keys[i]);
+}
+
+/* Returns the index of the first key of the
+ * node that is greater than or equal to key.
+ * The prefixes select the candidates and strcmp
+ * is only called for keys with the same prefix.
+ */
+int lower_bound_string(BtreeNodeString_t * n, char *key, uint64_t prefix) {
+    int i = countLessPrefix(n->prefixes, n->num_keys, prefix);
+    while (i < n->num_keys && n->prefixes[i] == prefix && strcmp(n->keys[i], key) < 0)
+        i++;
+    return i;
+}
+
+/* Returns the number of keys of the node
+ * that are less than or equal to key.
+ */
+int upper_bound_string(BtreeNodeString_t * n, char *key, uint64_t prefix) {
+    int i = countLessPrefix(n->prefixes, n->num_keys, prefix);
+    while (i < n->num_keys && n->prefixes[i] == prefix && strcmp(key, n->keys[i]) >= 0)
+        i++;
+    return i;
+}
+
 /* First insertion:
  * start a new tree.
  */
 BtreeNodeString_t * start_new_tree_string(char * key, BtreeRecord_t * pointer) {
     BtreeNodeString_t * root = make_leaf_string();
     root->keys[0] = key;
+    root->prefixes[0] = stringPrefix(key);
     root->pointers[0] = pointer;
-    root->pointers[order - 1] = NULL;
+    root->pointers[order_string - 1] = NULL;
     root->parent = NULL;
     root->num_keys++;
     return root;
@@ -92,12 +128,14 @@ BtreeNodeString_t * start_new_tree_string(char * key, BtreeRecord_t * pointer) {
  */
 BtreeNodeString_t * find_leaf_string(BtreeNodeString_t * root, char *key, bool verbose) {
     int i = 0;
+    uint64_t prefix;
     BtreeNodeString_t * c = root;
     if (c == NULL) {
         if (verbose)
             printf("Empty tree.\n");
         return c;
     }
+    prefix = stringPrefix(key);
     while (!c->is_leaf) {
         if (verbose) {
             printf("[");
@@ -105,11 +143,7 @@ BtreeNodeString_t * find_leaf_string(BtreeNodeString_t * root, char *key, bool v
                 printf("%s ", c->keys[i]);
             printf("%s] ", c->keys[i]);
         }
-        i = 0;
-        while (i < c->num_keys) {
-            if (strcmp(key,c->keys[i]) >= 0) i++;
-            else break;
-        }
+        i = upper_bound_string(c, key, prefix);
         if (verbose)
             printf("%d ->\n", i);
         c = (BtreeNodeString_t *) c->pointers[i];
@@ -130,15 +164,15 @@ BtreeNodeString_t * find_leaf_string(BtreeNodeString_t * root, char *key, bool v
 BtreeNodeString_t * insert_into_leaf_string(BtreeNodeString_t * leaf, char * key, BtreeRecord_t * pointer) {
     int i, insertion_point;
 
-    insertion_point = 0;
-    while (insertion_point < leaf->num_keys && strcmp(leaf->keys[insertion_point],key) < 0)
-        insertion_point++;
+    insertion_point = lower_bound_string(leaf, key, stringPrefix(key));
 
     for (i = leaf->num_keys; i > insertion_point; i--) {
         leaf->keys[i] = leaf->keys[i - 1];
+        leaf->prefixes[i] = leaf->prefixes[i - 1];
         leaf->pointers[i] = leaf->pointers[i - 1];
     }
     leaf->keys[insertion_point] = key;
+    leaf->prefixes[insertion_point] = stringPrefix(key);
     leaf->pointers[insertion_point] = pointer;
     leaf->num_keys++;
     return leaf;
@@ -151,6 +185,7 @@ BtreeNodeString_t * insert_into_leaf_string(BtreeNodeString_t * leaf, char * key
 BtreeNodeString_t * insert_into_new_root_string(BtreeNodeString_t * left, char * key, BtreeNodeString_t * right) {
     BtreeNodeString_t * root = make_node_string();
     root->keys[0] = key;
+    root->prefixes[0] = stringPrefix(key);
     root->pointers[0] = left;
     root->pointers[1] = right;
     root->num_keys++;
@@ -182,9 +217,11 @@ BtreeNodeString_t * insert_into_node_string(BtreeNodeString_t * root, BtreeNodeS
     for (i = n->num_keys; i > left_index; i--) {
         n->pointers[i + 1] = n->pointers[i];
         n->keys[i] = n->keys[i - 1];
+        n->prefixes[i] = n->prefixes[i - 1];
     }
     n->pointers[left_index + 1] = right;
     n->keys[left_index] = key;
+    n->prefixes[left_index] = stringPrefix(key);
     n->num_keys++;
     return root;
 }
@@ -204,12 +241,10 @@ BtreeNodeString_t * insert_into_leaf_after_splitting_string(BtreeNodeString_t *
 
     new_leaf = make_leaf_string();
 
-    temp_keys = allocate(order * sizeof (char **), __FILE__, __LINE__);
-    temp_pointers = allocate(order * sizeof (void *), __FILE__, __LINE__);
+    temp_keys = allocate(order_string * sizeof (char **), __FILE__, __LINE__);
+    temp_pointers = allocate(order_string * sizeof (void *), __FILE__, __LINE__);
 
-    insertion_index = 0;
-    while (insertion_index < order - 1 && strcmp(leaf->keys[insertion_index],key) < 0)
-        insertion_index++;
+    insertion_index = lower_bound_string(leaf, key, stringPrefix(key));
 
     for (i = 0, j = 0; i < leaf->num_keys; i++, j++) {
         if (j == insertion_index) j++;
@@ -222,7 +257,7 @@ BtreeNodeString_t * insert_into_leaf_after_splitting_string(BtreeNodeString_t *
 
     leaf->num_keys = 0;
 
-    split = cut(order - 1);
+    split = cut(order_string - 1);
 
     for (i = 0; i < split; i++) {
         leaf->pointers[i] = temp_pointers[i];
@@ -230,7 +265,7 @@ BtreeNodeString_t * insert_into_leaf_after_splitting_string(BtreeNodeString_t *
         leaf->num_keys++;
     }
 
-    for (i = split, j = 0; i < order; i++, j++) {
+    for (i = split, j = 0; i < order_string; i++, j++) {
         new_leaf->pointers[j] = temp_pointers[i];
         new_leaf->keys[j] = temp_keys[i];
         new_leaf->num_keys++;
@@ -238,13 +273,15 @@ BtreeNodeString_t * insert_into_leaf_after_splitting_string(BtreeNodeString_t *
 
     free(temp_pointers);
     free(temp_keys);
+    set_prefixes_string(leaf);
+    set_prefixes_string(new_leaf);
 
-    new_leaf->pointers[order - 1] = leaf->pointers[order - 1];
-    leaf->pointers[order - 1] = new_leaf;
+    new_leaf->pointers[order_string - 1] = leaf->pointers[order_string - 1];
+    leaf->pointers[order_string - 1] = new_leaf;
 
-    for (i = leaf->num_keys; i < order - 1; i++)
+    for (i = leaf->num_keys; i < order_string - 1; i++)
         leaf->pointers[i] = NULL;
-    for (i = new_leaf->num_keys; i < order - 1; i++)
+    for (i = new_leaf->num_keys; i < order_string - 1; i++)
         new_leaf->pointers[i] = NULL;
 
     new_leaf->parent = leaf->parent;
@@ -282,7 +319,7 @@ BtreeNodeString_t * insert_into_parent_string(BtreeNodeString_t * root, BtreeNod
     /* Simple case: the new key fits into the node. 
      */
 
-    if (parent->num_keys < order - 1)
+    if (parent->num_keys < order_string - 1)
         return insert_into_node_string(root, parent, left_index, key, right);
 
     /* Harder case:  split a node in order 
@@ -313,8 +350,8 @@ BtreeNodeString_t * insert_into_node_after_splitting_string(BtreeNodeString_t *
      * the other half to the new.
      */
 
-    temp_pointers = allocate((order + 1) * sizeof (BtreeNodeString_t *), __FILE__, __LINE__);
-    temp_keys = allocate(order * sizeof (char **), __FILE__, __LINE__);
+    temp_pointers = allocate((order_string + 1) * sizeof (BtreeNodeString_t *), __FILE__, __LINE__);
+    temp_keys = allocate(order_string * sizeof (char **), __FILE__, __LINE__);
 
     for (i = 0, j = 0; i < old_node->num_keys + 1; i++, j++) {
         if (j == left_index + 1) j++;
@@ -333,7 +370,7 @@ BtreeNodeString_t * insert_into_node_after_splitting_string(BtreeNodeString_t *
      * half the keys and pointers to the
      * old and half to the new.
      */
-    split = cut(order);
+    split = cut(order_string);
     new_node = make_node_string();
     old_node->num_keys = 0;
     for (i = 0; i < split - 1; i++) {
@@ -343,7 +380,7 @@ BtreeNodeString_t * insert_into_node_after_splitting_string(BtreeNodeString_t *
     }
     old_node->pointers[i] = temp_pointers[i];
     k_prime = temp_keys[split - 1];
-    for (++i, j = 0; i < order; i++, j++) {
+    for (++i, j = 0; i < order_string; i++, j++) {
         new_node->pointers[j] = temp_pointers[i];
         new_node->keys[j] = temp_keys[i];
         new_node->num_keys++;
@@ -351,6 +388,8 @@ BtreeNodeString_t * insert_into_node_after_splitting_string(BtreeNodeString_t *
     new_node->pointers[j] = temp_pointers[i];
     free(temp_pointers);
     free(temp_keys);
+    set_prefixes_string(old_node);
+    set_prefixes_string(new_node);
     new_node->parent = old_node->parent;
     for (i = 0; i <= new_node->num_keys; i++) {
         child = new_node->pointers[i];
@@ -377,9 +416,8 @@ BtreeRecord_t * BTreeFindString(BtreeNodeString_t * root, char *key, bool verbos
     int i = 0;
     BtreeNodeString_t * c = find_leaf_string(root, key, verbose);
     if (c == NULL) return NULL;
-    for (i = 0; i < c->num_keys; i++)
-        if (strcmp(c->keys[i], key) == 0) break;
-    if (i == c->num_keys)
+    i = lower_bound_string(c, key, stringPrefix(key));
+    if (i == c->num_keys || strcmp(c->keys[i], key) != 0)
         return NULL;
     else
         return (BtreeRecord_t *) c->pointers[i];
@@ -432,7 +470,7 @@ BtreeNodeString_t * BtreeInsertString(BtreeNodeString_t * root, char *key, void
     /* Case: leaf has room for key and pointer.
      */
 
-    if (leaf->num_keys < order - 1) {
+    if (leaf->num_keys < order_string - 1) {
         leaf = insert_into_leaf_string(leaf, key, pointer);
         return root;
     }
@@ -530,7 +568,7 @@ void BtreeStringPrintTree(BtreeNodeString_t * root) {
                 enqueue_string(n->pointers[i]);
         if (verbose_output) {
             if (n->is_leaf)
-                printf("%lx ", (unsigned long) n->pointers[order - 1]);
+                printf("%lx ", (unsigned long) n->pointers[order_string - 1]);
             else
                 printf("%lx ", (unsigned long) n->pointers[n->num_keys]);
         }
@@ -575,6 +613,7 @@ void destroy_tree_nodes_string(BtreeNodeString_t * root, void freeRecord(void *)
     }
     free(root->pointers);
     free(root->keys);
+    free(root->prefixes);
     free(root);
 }
 
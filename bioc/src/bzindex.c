@@ -0,0 +1,412 @@
+/*
+ * File:   bzindex.c
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 6:10 PM
+ */
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <zlib.h>
+#include "berror.h"
+#include "bmemory.h"
+#include "bzindex.h"
+
+/*
+ * State of a FILE opened with zindexOpen. out holds the uncompressed
+ * bytes from outStart, up to 2 * ZINDEX_CHUNK. When it is full the first
+ * half is dropped, so short seeks backward do not restart the inflate
+ */
+typedef struct zindex_stream_t {
+    ZIndex_t *index;
+    FILE *in;
+    z_stream strm;
+    int active;
+    int raw;
+    int eof;
+    off_t inRead;
+    unsigned char *input;
+    unsigned char *out;
+    size_t outSize;
+    off_t outStart;
+    off_t pos;
+} zindex_stream_t;
+
+/*
+ * Append an access point at the current position of the inflate if it
+ * is at least span bytes after the last one
+ */
+void zindex_add_point(zindex_stream_t *s, int bits) {
+    ZIndex_t *index = s->index;
+    ZIndexPoint_t *point;
+    unsigned char window[ZINDEX_WINDOW];
+    unsigned int length = 0;
+    uLongf size;
+    off_t out = s->outStart + s->outSize;
+
+    if (index->count > 0 && out < index->points[index->count - 1].out + index->span) return;
+    if (index->count == index->capacity) {
+        index->capacity = (index->capacity == 0) ? 64 : index->capacity * 2;
+        index->points = reallocate(index->points, sizeof (ZIndexPoint_t) * index->capacity, __FILE__, __LINE__);
+    }
+    point = &index->points[index->count];
+    point->out = out;
+    point->in = s->inRead - s->strm.avail_in;
+    point->bits = bits;
+    point->windowSize = 0;
+    point->window = NULL;
+    if (bits >= 0 && inflateGetDictionary(&s->strm, window, &length) == Z_OK && length > 0) {
+        size = compressBound(length);
+        point->window = allocate(size, __FILE__, __LINE__);
+        if (compress2(point->window, &size, window, length, 1) != Z_OK) {
+            checkPointerError(NULL, "Can't deflate the inflate window", __FILE__, __LINE__, -1);
+        }
+        point->window = reallocate(point->window, size, __FILE__, __LINE__);
+        point->windowSize = size;
+    }
+    index->count++;
+}
+
+/*
+ * Read more compressed data if the input is empty. Returns 0 at the end
+ * of the file
+ */
+int zindex_fill_input(zindex_stream_t *s) {
+    size_t n;
+
+    if (s->strm.avail_in > 0) return 1;
+    n = fread(s->input, 1, ZINDEX_CHUNK, s->in);
+    s->inRead += n;
+    s->strm.next_in = s->input;
+    s->strm.avail_in = n;
+    return n > 0;
+}
+
+/*
+ * Restart the inflate at an access point
+ */
+void zindex_start(zindex_stream_t *s, ZIndexPoint_t *point) {
+    unsigned char window[ZINDEX_WINDOW];
+    uLongf length = ZINDEX_WINDOW;
+    int c, ret;
+
+    if (s->active) inflateEnd(&s->strm);
+    memset(&s->strm, 0, sizeof (z_stream));
+    s->raw = (point->bits >= 0);
+    ret = inflateInit2(&s->strm, s->raw ? -15 : 47);
+    if (ret != Z_OK) {
+        checkPointerError(NULL, "Can't initialize the inflate", __FILE__, __LINE__, -1);
+    }
+    s->active = 1;
+    fseeko(s->in, (point->bits > 0) ? point->in - 1 : point->in, SEEK_SET);
+    if (point->bits > 0) {
+        if ((c = fgetc(s->in)) == EOF) {
+            checkPointerError(NULL, "The gzip file is shorter than its index", __FILE__, __LINE__, -1);
+        }
+        inflatePrime(&s->strm, point->bits, c >> (8 - point->bits));
+    }
+    if (point->windowSize > 0) {
+        if (uncompress(window, &length, point->window, point->windowSize) != Z_OK
+                || inflateSetDictionary(&s->strm, window, length) != Z_OK) {
+            checkPointerError(NULL, "Bad window in the gzip index", __FILE__, __LINE__, -1);
+        }
+    }
+    s->inRead = point->in;
+    s->outStart = point->out;
+    s->outSize = 0;
+    s->eof = 0;
+}
+
+/*
+ * Inflate more data into the output buffer. Returns 0 at the end of the
+ * uncompressed data
+ */
+int zindex_inflate(zindex_stream_t *s) {
+    size_t before;
+    int ret, skip;
+
+    if (s->eof) return 0;
+    if (s->outSize == 2 * ZINDEX_CHUNK) {
+        memmove(s->out, s->out + ZINDEX_CHUNK, ZINDEX_CHUNK);
+        s->outStart += ZINDEX_CHUNK;
+        s->outSize = ZINDEX_CHUNK;
+    }
+    before = s->outSize;
+    while (s->outSize == before) {
+        if (!zindex_fill_input(s)) {
+            /* Truncated file: what was inflated is kept */
+            s->eof = 1;
+            break;
+        }
+        s->strm.next_out = s->out + s->outSize;
+        s->strm.avail_out = 2 * ZINDEX_CHUNK - s->outSize;
+        ret = inflate(&s->strm, Z_BLOCK);
+        s->outSize = 2 * ZINDEX_CHUNK - s->strm.avail_out;
+        if (ret == Z_DATA_ERROR && !s->raw && s->strm.total_out == 0 && s->outStart + s->outSize > 0) {
+            /* Garbage after the last gzip member is ignored like gzread does */
+            s->eof = 1;
+            break;
+        }
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            checkPointerError(NULL, "Can't inflate the gzip file", __FILE__, __LINE__, -1);
+        }
+        if (ret == Z_STREAM_END) {
+            if (s->raw) {
+                /* Skip the gzip trailer of the member (CRC32 and ISIZE) */
+                for (skip = 8; skip > 0 && zindex_fill_input(s);) {
+                    ret = (s->strm.avail_in < (unsigned) skip) ? (int) s->strm.avail_in : skip;
+                    s->strm.next_in += ret;
+                    s->strm.avail_in -= ret;
+                    skip -= ret;
+                }
+            }
+            if (!zindex_fill_input(s)) {
+                s->eof = 1;
+                break;
+            }
+            /* Next gzip member */
+            inflateReset2(&s->strm, 47);
+            s->raw = 0;
+            zindex_add_point(s, -1);
+        } else if ((s->strm.data_type & 128) && !(s->strm.data_type & 64)) {
+            zindex_add_point(s, s->strm.data_type & 7);
+        }
+    }
+    if (s->eof && s->index->size < 0) {
+        s->index->size = s->outStart + s->outSize;
+    }
+    return s->outSize > before;
+}
+
+/*
+ * Make pos a position of the output buffer, restarting from the access
+ * point before it if the current inflate is not. Returns 0 if pos is
+ * after the end of the file
+ */
+int zindex_position(zindex_stream_t *s) {
+    ZIndex_t *index = s->index;
+    int low = 0, high = index->count - 1, mid;
+
+    if (index->size >= 0 && s->pos >= index->size) return 0;
+    if (s->pos >= s->outStart && s->pos < s->outStart + (off_t) s->outSize) return 1;
+
+    /* Last access point before pos */
+    while (low < high) {
+        mid = (low + high + 1) / 2;
+        if (index->points[mid].out <= s->pos) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    if (!s->active || s->pos < s->outStart || index->points[low].out > s->outStart + (off_t) s->outSize) {
+        zindex_start(s, &index->points[low]);
+    }
+    while (s->pos >= s->outStart + (off_t) s->outSize) {
+        if (!zindex_inflate(s)) return 0;
+    }
+    return 1;
+}
+
+/*
+ * FILE functions (fopencookie)
+ */
+ssize_t zindex_read(void *cookie, char *buf, size_t size) {
+    zindex_stream_t *s = (zindex_stream_t *) cookie;
+    size_t n;
+
+    if (!zindex_position(s)) return 0;
+    n = s->outStart + s->outSize - s->pos;
+    if (n > size) n = size;
+    memcpy(buf, s->out + (s->pos - s->outStart), n);
+    s->pos += n;
+    return n;
+}
+
+int zindex_seek(void *cookie, off64_t *offset, int whence) {
+    zindex_stream_t *s = (zindex_stream_t *) cookie;
+    off_t target;
+
+    if (whence == SEEK_SET) {
+        target = *offset;
+    } else if (whence == SEEK_CUR) {
+        target = s->pos + *offset;
+    } else {
+        /* The size is known once the end of the file is inflated */
+        if (s->index->size < 0) {
+            s->pos = s->index->points[s->index->count - 1].out;
+            if (zindex_position(s)) {
+                while (zindex_inflate(s));
+            }
+        }
+        target = s->index->size + *offset;
+    }
+    if (target < 0) return -1;
+    s->pos = target;
+    *offset = target;
+    return 0;
+}
+
+int zindex_close(void *cookie) {
+    zindex_stream_t *s = (zindex_stream_t *) cookie;
+
+    if (s->active) inflateEnd(&s->strm);
+    fclose(s->in);
+    free(s->input);
+    free(s->out);
+    free(s);
+    return 0;
+}
+
+/**
+ * Create an empty index. The access points are added while the file is
+ * read with zindexOpen
+ *
+ * @param span the minimum number of uncompressed bytes between access points
+ * @return the index
+ */
+ZIndex_t *zindexCreate(off_t span) {
+    ZIndex_t *index = allocate(sizeof (ZIndex_t), __FILE__, __LINE__);
+
+    index->span = (span > 0) ? span : ZINDEX_SPAN;
+    index->size = -1;
+    index->count = 0;
+    index->capacity = 64;
+    index->points = allocate(sizeof (ZIndexPoint_t) * index->capacity, __FILE__, __LINE__);
+    /* The start of the file */
+    memset(&index->points[0], 0, sizeof (ZIndexPoint_t));
+    index->points[0].bits = -1;
+    index->count = 1;
+    return index;
+}
+
+/**
+ * Read an index file
+ *
+ * @param filename the index file name
+ * @return the index or NULL if the file can't be opened
+ */
+ZIndex_t *zindexRead(char *filename) {
+    ZIndexHeader_t header;
+    ZIndex_t *index;
+    ZIndexPoint_t *point;
+    int64_t offsets[2];
+    int32_t bits;
+    uint32_t i, size;
+    FILE *fd;
+
+    if ((fd = fopen(filename, "rb")) == NULL) return NULL;
+    if (fread(&header, sizeof (ZIndexHeader_t), 1, fd) != 1
+            || memcmp(header.magic, ZINDEX_MAGIC, sizeof (ZINDEX_MAGIC)) != 0
+            || header.version != ZINDEX_VERSION || header.count == 0) {
+        checkPointerError(NULL, "The file is not a gzip index", __FILE__, __LINE__, -1);
+    }
+    index = allocate(sizeof (ZIndex_t), __FILE__, __LINE__);
+    index->span = header.span;
+    index->size = header.size;
+    index->count = index->capacity = header.count;
+    index->points = allocate(sizeof (ZIndexPoint_t) * index->capacity, __FILE__, __LINE__);
+    for (i = 0; i < header.count; i++) {
+        point = &index->points[i];
+        if (fread(offsets, sizeof (int64_t), 2, fd) != 2
+                || fread(&bits, sizeof (int32_t), 1, fd) != 1
+                || fread(&size, sizeof (uint32_t), 1, fd) != 1) {
+            checkPointerError(NULL, "The gzip index is truncated", __FILE__, __LINE__, -1);
+        }
+        point->out = offsets[0];
+        point->in = offsets[1];
+        point->bits = bits;
+        point->windowSize = size;
+        point->window = NULL;
+        if (size > 0) {
+            point->window = allocate(size, __FILE__, __LINE__);
+            if (fread(point->window, 1, size, fd) != size) {
+                checkPointerError(NULL, "The gzip index is truncated", __FILE__, __LINE__, -1);
+            }
+        }
+    }
+    fclose(fd);
+    return index;
+}
+
+/**
+ * Write the index to a file
+ *
+ * @param index the index
+ * @param filename the index file name
+ */
+void zindexWrite(ZIndex_t *index, char *filename) {
+    ZIndexHeader_t header;
+    ZIndexPoint_t *point;
+    int64_t offsets[2];
+    int32_t bits;
+    uint32_t size;
+    int i;
+    FILE *fo = checkPointerError(fopen(filename, "wb"), "Can't open the gzip index file", __FILE__, __LINE__, -1);
+
+    memset(&header, 0, sizeof (ZIndexHeader_t));
+    memcpy(header.magic, ZINDEX_MAGIC, sizeof (ZINDEX_MAGIC));
+    header.version = ZINDEX_VERSION;
+    header.count = index->count;
+    header.span = index->span;
+    header.size = index->size;
+    fwrite(&header, sizeof (ZIndexHeader_t), 1, fo);
+    for (i = 0; i < index->count; i++) {
+        point = &index->points[i];
+        offsets[0] = point->out;
+        offsets[1] = point->in;
+        bits = point->bits;
+        size = point->windowSize;
+        fwrite(offsets, sizeof (int64_t), 2, fo);
+        fwrite(&bits, sizeof (int32_t), 1, fo);
+        fwrite(&size, sizeof (uint32_t), 1, fo);
+        if (size > 0) fwrite(point->window, 1, size, fo);
+    }
+    if (fclose(fo) != 0) {
+        checkPointerError(NULL, "Can't write the gzip index file", __FILE__, __LINE__, -1);
+    }
+}
+
+/**
+ * Free the index
+ *
+ * @param index the index
+ */
+void zindexFree(ZIndex_t *index) {
+    int i;
+
+    if (index) {
+        for (i = 0; i < index->count; i++) {
+            if (index->points[i].window) free(index->points[i].window);
+        }
+        free(index->points);
+        free(index);
+    }
+}
+
+/**
+ * Open a gzip file as a seekable read-only FILE over its uncompressed
+ * data. fseeko and ftello use uncompressed offsets. The index is
+ * completed with the access points of the parts of the file that are
+ * read, it has to be kept until the FILE is closed. The program exits
+ * if the file can't be opened
+ *
+ * @param filename the gzip file name
+ * @param index the index of the file
+ * @return the FILE (close it with fclose)
+ */
+FILE *zindexOpen(char *filename, ZIndex_t *index) {
+    cookie_io_functions_t functions = {zindex_read, NULL, zindex_seek, zindex_close};
+    zindex_stream_t *s = allocate(sizeof (zindex_stream_t), __FILE__, __LINE__);
+
+    memset(s, 0, sizeof (zindex_stream_t));
+    s->index = index;
+    s->in = checkPointerError(fopen(filename, "rb"), "Can't open the gzip file", __FILE__, __LINE__, -1);
+    s->input = allocate(ZINDEX_CHUNK, __FILE__, __LINE__);
+    s->out = allocate(2 * ZINDEX_CHUNK, __FILE__, __LINE__);
+    return checkPointerError(fopencookie(s, "r", functions), "Can't open the gzip file", __FILE__, __LINE__, -1);
+}
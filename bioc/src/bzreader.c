@@ -0,0 +1,253 @@
+/*
+ * File:   bzreader.c
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 4:30 PM
+ */
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <zlib.h>
+#include "berror.h"
+#include "bmemory.h"
+#include "bzreader.h"
+
+/*
+ * Inflate thread: fill the free slots of the ring in order until the end
+ * of the file
+ */
+void *zreader_inflate(void *arg) {
+    ZReader_t *reader = (ZReader_t *) arg;
+    int slot, n;
+
+    while (1) {
+        pthread_mutex_lock(&reader->mutex);
+        while (reader->count == ZREADER_SLOTS && !reader->closing) {
+            pthread_cond_wait(&reader->emptied, &reader->mutex);
+        }
+        if (reader->closing) {
+            pthread_mutex_unlock(&reader->mutex);
+            break;
+        }
+        slot = (reader->head + reader->count) % ZREADER_SLOTS;
+        pthread_mutex_unlock(&reader->mutex);
+
+        n = gzread(reader->file, reader->blocks[slot], ZREADER_BLOCK);
+
+        pthread_mutex_lock(&reader->mutex);
+        if (n > 0) {
+            reader->sizes[slot] = n;
+            reader->count++;
+        } else {
+            if (n < 0) reader->error = 1;
+            reader->eof = 1;
+        }
+        pthread_cond_signal(&reader->filled);
+        pthread_mutex_unlock(&reader->mutex);
+        if (n <= 0) break;
+    }
+    return NULL;
+}
+
+/*
+ * Give the slot in use back to the inflate thread and wait for the next
+ * one. Returns 0 at the end of the file
+ */
+int zreader_next_slot(ZReader_t *reader) {
+    int error;
+
+    pthread_mutex_lock(&reader->mutex);
+    if (reader->current != -1) {
+        reader->head = (reader->head + 1) % ZREADER_SLOTS;
+        reader->count--;
+        reader->current = -1;
+        pthread_cond_signal(&reader->emptied);
+    }
+    while (reader->count == 0 && !reader->eof) {
+        pthread_cond_wait(&reader->filled, &reader->mutex);
+    }
+    if (reader->count != 0) {
+        reader->current = reader->head;
+        reader->pos = 0;
+    }
+    error = reader->error;
+    pthread_mutex_unlock(&reader->mutex);
+    if (error) {
+        checkPointerError(NULL, "Can't inflate the input file", __FILE__, __LINE__, -1);
+    }
+    return reader->current != -1;
+}
+
+/*
+ * Append bytes to the carry buffer, the line split between two slots
+ */
+void zreader_carry(ZReader_t *reader, char *data, size_t size) {
+    if (size == 0) return;
+    if (reader->carrySize + size > reader->carryCapacity) {
+        reader->carryCapacity = 2 * (reader->carrySize + size);
+        reader->carry = reallocate(reader->carry, reader->carryCapacity, __FILE__, __LINE__);
+    }
+    memcpy(reader->carry + reader->carrySize, data, size);
+    reader->carrySize += size;
+}
+
+/**
+ * Check if the file starts with the gzip magic number
+ * 
+ * @param filename the file name
+ * @return 1 if the file is gzip compressed
+ */
+int isGzipFile(char *filename) {
+    unsigned char magic[2];
+    FILE *fd;
+    int gzip = 0;
+
+    if ((fd = fopen(filename, "rb")) != NULL) {
+        gzip = fread(magic, 1, 2, fd) == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+        fclose(fd);
+    }
+    return gzip;
+}
+
+/**
+ * Open a plain or gzip compressed file and start the inflate thread.
+ * The program exits if the file can't be opened
+ * 
+ * @param filename the file name
+ * @return the reader
+ */
+ZReader_t *zreaderOpen(char *filename) {
+    ZReader_t *reader;
+    int i;
+
+    reader = allocate(sizeof (ZReader_t), __FILE__, __LINE__);
+    memset(reader, 0, sizeof (ZReader_t));
+    reader->file = checkPointerError(gzopen(filename, "rb"), "Can't open the input file", __FILE__, __LINE__, -1);
+    gzbuffer(reader->file, 1 << 17);
+    for (i = 0; i < ZREADER_SLOTS; i++) {
+        reader->blocks[i] = allocate(ZREADER_BLOCK, __FILE__, __LINE__);
+    }
+    reader->current = -1;
+    pthread_mutex_init(&reader->mutex, NULL);
+    pthread_cond_init(&reader->filled, NULL);
+    pthread_cond_init(&reader->emptied, NULL);
+    if (pthread_create(&reader->thread, NULL, zreader_inflate, reader) != 0) {
+        checkPointerError(NULL, "Can't create the inflate thread", __FILE__, __LINE__, -1);
+    }
+    return reader;
+}
+
+/**
+ * Return the next block of complete lines of the file. The block is 
+ * owned by the reader and it is valid until the next call. The last
+ * line of the file may have no '\n'
+ * 
+ * @param reader the reader
+ * @param size returns the size of the block in bytes
+ * @return the block or NULL at the end of the file
+ */
+char *zreaderLines(ZReader_t *reader, size_t *size) {
+    char *data, *nl;
+    size_t avail;
+
+    if (reader->carryReturned) {
+        reader->carrySize = 0;
+        reader->carryReturned = 0;
+    }
+    while (1) {
+        if (reader->current == -1 || reader->pos == reader->sizes[reader->current]) {
+            if (!zreader_next_slot(reader)) {
+                if (reader->carrySize == 0) return NULL;
+                reader->carryReturned = 1;
+                *size = reader->carrySize;
+                return reader->carry;
+            }
+        }
+        data = reader->blocks[reader->current] + reader->pos;
+        avail = reader->sizes[reader->current] - reader->pos;
+        if (reader->carrySize != 0) {
+            /* Complete the split line with the beginning of this slot */
+            if ((nl = memchr(data, '\n', avail)) == NULL) {
+                zreader_carry(reader, data, avail);
+                reader->pos += avail;
+                continue;
+            }
+            zreader_carry(reader, data, nl + 1 - data);
+            reader->pos += nl + 1 - data;
+            reader->carryReturned = 1;
+            *size = reader->carrySize;
+            return reader->carry;
+        }
+        if ((nl = memrchr(data, '\n', avail)) == NULL) {
+            zreader_carry(reader, data, avail);
+            reader->pos += avail;
+            continue;
+        }
+        zreader_carry(reader, nl + 1, data + avail - (nl + 1));
+        reader->pos += avail;
+        *size = nl + 1 - data;
+        return data;
+    }
+}
+
+/**
+ * Read a line like getline does
+ * 
+ * @param line the line buffer (allocated or grown as needed)
+ * @param len the size of the line buffer
+ * @param reader the reader
+ * @return the number of characters read or -1 at the end of the file
+ */
+ssize_t zreaderGetline(char **line, size_t *len, ZReader_t *reader) {
+    char *start, *nl;
+    size_t size;
+
+    if (reader->lines == NULL || reader->linesPos == reader->linesSize) {
+        if ((reader->lines = zreaderLines(reader, &reader->linesSize)) == NULL) return -1;
+        reader->linesPos = 0;
+    }
+    start = reader->lines + reader->linesPos;
+    if ((nl = memchr(start, '\n', reader->linesSize - reader->linesPos)) != NULL) {
+        size = nl + 1 - start;
+    } else {
+        size = reader->linesSize - reader->linesPos;
+    }
+    if (*line == NULL || *len < size + 1) {
+        *len = size + 1;
+        *line = reallocate(*line, *len, __FILE__, __LINE__);
+    }
+    memcpy(*line, start, size);
+    (*line)[size] = '\0';
+    reader->linesPos += size;
+    return size;
+}
+
+/**
+ * Stop the inflate thread, close the file and free the reader
+ * 
+ * @param reader the reader
+ */
+void zreaderClose(ZReader_t *reader) {
+    int i;
+
+    if (reader) {
+        pthread_mutex_lock(&reader->mutex);
+        reader->closing = 1;
+        pthread_cond_signal(&reader->emptied);
+        pthread_mutex_unlock(&reader->mutex);
+        pthread_join(reader->thread, NULL);
+        gzclose(reader->file);
+        pthread_mutex_destroy(&reader->mutex);
+        pthread_cond_destroy(&reader->filled);
+        pthread_cond_destroy(&reader->emptied);
+        for (i = 0; i < ZREADER_SLOTS; i++) {
+            free(reader->blocks[i]);
+        }
+        if (reader->carry) free(reader->carry);
+        free(reader);
+    }
+}
@@ -10,33 +10,241 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <zlib.h>
 #include "bmemory.h"
 #include "bstring.h"
 #include "berror.h"
 #include "btree.h"
 #include "btime.h"
+#include "bsimd.h"
 #include "fasta.h"
 
 #define SIZE 3072
+/* Entries between progress lines when building an index */
+#define FASTA_INDEX_PROGRESS 100000
+/* Minimum size of the fasta file ranges indexed by a thread */
+#define FASTA_INDEX_CHUNK_MIN (16 << 20)
 
-typedef struct thread_param {
-    int number;
-    void * self;
-    char *out;
-    char *parser;
-    int start;
-    int end;
-    int length;
-    int offset;
-    int lineLength;
-    void **res;
-    int resNumber;
-} thread_param_t;
+/*
+ * A Gi and the offset of its fasta entry
+ */
+typedef struct fasta_index_pair_t {
+    int gi;
+    off_t offset;
+} fasta_index_pair_t;
+
+/*
+ * Byte range of the fasta file indexed by one thread. It owns the 
+ * entries whose header starts in [start, end)
+ */
+typedef struct fasta_index_chunk_t {
+    char *filename;
+    char *giPattern;
+    off_t start;
+    off_t end;
+    fasta_index_pair_t *pairs;
+    int count;
+    int capacity;
+} fasta_index_chunk_t;
+
+/* Output bytes of the segments of a splitter task */
+#define FASTA_SPLIT_TASK (1 << 20)
+/* Tasks per thread waiting to be written before a new one is queued */
+#define FASTA_SPLIT_AHEAD 4
+
+/*
+ * Formatted segments of a splitter task
+ */
+typedef struct segment_buffer_t {
+    char *data;
+    size_t size;
+    size_t capacity;
+} segment_buffer_t;
+
+/* 2-bit code + 1 of the ACGT bases (0 for the rest of characters) */
+unsigned char pack_code[256] = {
+    ['A'] = 1, ['C'] = 2, ['G'] = 3, ['T'] = 4,
+    ['a'] = 1, ['c'] = 2, ['g'] = 3, ['t'] = 4
+};
+
+/* The 4 bases of each packed byte, the base j of byte i is bits 2j of i */
+#define UNPACK_BASE(i, j) ((((i) >> (2 * (j))) & 3) == 0 ? 'A' : (((i) >> (2 * (j))) & 3) == 1 ? 'C' : \
+        (((i) >> (2 * (j))) & 3) == 2 ? 'G' : 'T')
+#define UNPACK_BYTE(i) {UNPACK_BASE(i, 0), UNPACK_BASE(i, 1), UNPACK_BASE(i, 2), UNPACK_BASE(i, 3)}
+#define UNPACK_4(i) UNPACK_BYTE(i), UNPACK_BYTE(i + 1), UNPACK_BYTE(i + 2), UNPACK_BYTE(i + 3)
+#define UNPACK_16(i) UNPACK_4(i), UNPACK_4(i + 4), UNPACK_4(i + 8), UNPACK_4(i + 12)
+#define UNPACK_64(i) UNPACK_16(i), UNPACK_16(i + 16), UNPACK_16(i + 32), UNPACK_16(i + 48)
+
+const char unpack_table[256][4] = {
+    UNPACK_64(0), UNPACK_64(64), UNPACK_64(128), UNPACK_64(192)
+};
+
+/*
+ * Append a position to a list of runs, extending the last run if the 
+ * position follows it with the same base
+ */
+void add_packed_run(PackedRun_t **runs, int *number, int *capacity, int pos, char base) {
+    PackedRun_t *last = (*number > 0) ? &(*runs)[*number - 1] : NULL;
+
+    if (last && last->start + last->length == pos && last->base == base) {
+        last->length++;
+        return;
+    }
+    if (*number == *capacity) {
+        *capacity = (*capacity == 0) ? 16 : *capacity * 2;
+        *runs = reallocate(*runs, sizeof (PackedRun_t) * *capacity, __FILE__, __LINE__);
+    }
+    (*runs)[*number].start = pos;
+    (*runs)[*number].length = 1;
+    (*runs)[*number].base = base;
+    (*number)++;
+}
+
+/*
+ * Index of the first run that ends after pos
+ */
+int find_packed_run(PackedRun_t *runs, int number, int pos) {
+    int low = 0, high = number, mid;
+    while (low < high) {
+        mid = (low + high) / 2;
+        if (runs[mid].start + runs[mid].length <= pos) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * Pack a sequence with 2 bits per base
+ * 
+ * @param seq the sequence
+ * @param len the length of the sequence
+ * @return the packed sequence
+ */
+PackedSeq_t *PackSequence(char *seq, int len) {
+    PackedSeq_t *packed = allocate(sizeof (PackedSeq_t), __FILE__, __LINE__);
+    unsigned char *p = (unsigned char *) seq;
+    unsigned char code, byte;
+    int i, j, exceptionsCapacity = 0, masksCapacity = 0;
+
+    packed->len = len;
+    packed->bases = allocate(sizeof (unsigned char) * (len / 4 + 1), __FILE__, __LINE__);
+    packed->exceptions = packed->masks = NULL;
+    packed->exceptions_number = packed->masks_number = 0;
+    for (i = 0; i < len; i += 4) {
+        byte = 0;
+        for (j = 0; j < 4 && i + j < len; j++) {
+            if ((code = pack_code[p[i + j]]) == 0 || p[i + j] >= 'a') {
+                /* Slow path: IUPAC codes and soft-masked bases */
+                if (code == 0) {
+                    add_packed_run(&packed->exceptions, &packed->exceptions_number, &exceptionsCapacity, i + j, toupper(p[i + j]));
+                    code = 1;
+                }
+                if (islower(p[i + j])) {
+                    add_packed_run(&packed->masks, &packed->masks_number, &masksCapacity, i + j, 0);
+                }
+            }
+            byte |= (code - 1) << (2 * j);
+        }
+        packed->bases[i / 4] = byte;
+    }
+    return packed;
+}
+
+/**
+ * Unpack a segment of a packed sequence
+ * 
+ * @param packed the packed sequence
+ * @param start the start position
+ * @param length the segment length (it has to be inside the sequence)
+ * @param out the output buffer of at least length characters (no '\0' is added)
+ */
+void UnpackSequence(PackedSeq_t *packed, int start, int length, char *out) {
+    int i = start, end = start + length, k, from, to;
+    char *o = out;
+
+    while (i < end && (i & 3)) {
+        *o++ = unpack_table[packed->bases[i / 4]][i & 3];
+        i++;
+    }
+    for (; i + 4 <= end; i += 4, o += 4) {
+        memcpy(o, unpack_table[packed->bases[i / 4]], 4);
+    }
+    for (; i < end; i++) {
+        *o++ = unpack_table[packed->bases[i / 4]][i & 3];
+    }
+
+    for (k = find_packed_run(packed->exceptions, packed->exceptions_number, start); k < packed->exceptions_number && packed->exceptions[k].start < end; k++) {
+        from = (packed->exceptions[k].start > start) ? packed->exceptions[k].start : start;
+        to = packed->exceptions[k].start + packed->exceptions[k].length;
+        if (to > end) to = end;
+        memset(out + from - start, packed->exceptions[k].base, to - from);
+    }
+    for (k = find_packed_run(packed->masks, packed->masks_number, start); k < packed->masks_number && packed->masks[k].start < end; k++) {
+        from = (packed->masks[k].start > start) ? packed->masks[k].start : start;
+        to = packed->masks[k].start + packed->masks[k].length;
+        if (to > end) to = end;
+        for (i = from; i < to; i++) out[i - start] = tolower(out[i - start]);
+    }
+}
+
+/**
+ * Free the packed sequence
+ * 
+ * @param packed the packed sequence
+ */
+void FreePackedSequence(PackedSeq_t *packed) {
+    if (packed) {
+        if (packed->bases) free(packed->bases);
+        if (packed->exceptions) free(packed->exceptions);
+        if (packed->masks) free(packed->masks);
+        free(packed);
+    }
+}
+
+/*
+ * Copy size characters of the sequence from start, unpacking them if
+ * the sequence is packed
+ */
+void copy_sequence(fasta_l self, int start, int size, char *out) {
+    if (self->packed) {
+        UnpackSequence(self->packed, start, size, out);
+    } else {
+        memcpy(out, self->seq + start, size);
+    }
+}
+
+/*
+ * Print size characters of the sequence from start in lines of lineLength.
+ * Packed sequences are unpacked by pieces in a local buffer
+ */
+void file_write_sequence(fasta_l self, FILE *out, int start, int size, int lineLength) {
+    char tmp[SIZE];
+    int i, j, line, piece;
+
+    for (i = 0; i < size; i += lineLength) {
+        line = (i + lineLength < size) ? lineLength : size - i;
+        if (self->packed) {
+            for (j = 0; j < line; j += piece) {
+                piece = (line - j < SIZE) ? line - j : SIZE;
+                UnpackSequence(self->packed, start + i + j, piece, tmp);
+                fwrite(tmp, 1, piece, out);
+            }
+        } else {
+            fwrite(self->seq + start + i, 1, line, out);
+        }
+        putc('\n', out);
+    }
+}
 
 /**
  * Print in fasta format with a line length of lineLength 
@@ -47,19 +255,8 @@ typedef struct thread_param {
  */
 void toFileFasta(void * self, FILE *out, int lineLength) {
     _CHECK_SELF_P(self);
-    int i = 0;
-    char *tmp = allocate(sizeof (char) * (lineLength + 1), __FILE__, __LINE__);
     fprintf(out, ">%s\n", ((fasta_l) self)->header);
-    for (i = 0; i < ((fasta_l) self)->len; i += lineLength) {
-        memset(tmp, 0, sizeof (char) * (lineLength + 1));
-        if (i + lineLength < ((fasta_l) self)->len) {
-            strncpy(tmp, (((fasta_l) self)->seq + i), lineLength);
-        } else {
-            strncpy(tmp, (((fasta_l) self)->seq + i), ((fasta_l) self)->len - i);
-        }
-        fprintf(out, "%s\n", tmp);
-    }
-    free(tmp);
+    file_write_sequence(self, out, 0, ((fasta_l) self)->len, lineLength);
 }
 
 /**
@@ -81,6 +278,7 @@ void toStringFasta(void * self, int lineLength) {
  */
 int length(void *self) {
     _CHECK_SELF_P(self);
+    if (((fasta_l) self)->packed) return ((fasta_l) self)->packed->len;
     return strlen(((fasta_l) self)->seq);
 }
 
@@ -96,6 +294,37 @@ void setHeader(void *self, char *string) {
     ((fasta_l) self)->header = strdup(string);
 }
 
+/*
+ * Parse the Gi from a fasta header without copying it. The fields are 
+ * separated by '|' and the Gi is the field after the first "gi" field.
+ * Returns -1 if there is not Gi field
+ */
+int header_gi(char *header) {
+    char *p = header, *field, *next;
+    int gi = -1;
+
+    while (*p != '\0') {
+        while (*p == '|') p++;
+        field = p;
+        while (*p != '\0' && *p != '|') p++;
+        if (p - field == 2 && field[0] == 'g' && field[1] == 'i') {
+            next = p;
+            while (*next == '|') next++;
+            if (*next == '\0') break;
+            gi = atoi(next);
+            if (gi <= 0) {
+                fprintf(stderr, "gi Trying to do atoi in:  %.*s\n", (int) strcspn(next, "|"), next);
+                fprintf(stderr, "Can't find Gi %d on: %s\nThe format have to be gi|ginumber: >gi|12345\n", gi, header);
+            }
+            break;
+        }
+    }
+    if (gi <= 0) {
+        fprintf(stderr, "\nCan't find Gi %d on: %s\nThe format have to be gi|ginumber: >gi|12345\n", gi, header);
+    }
+    return gi;
+}
+
 /**
  * Get the Gi parsing the fasta header
  * 
@@ -103,25 +332,18 @@ void setHeader(void *self, char *string) {
  * @param gi the return gi, -1 if not Gi is present
  */
 void getGi(void *self, int *gi) {
-    char **ids;
-    int i, ids_number;
-
-    *gi = -1;
-    ids_number = splitString(&ids, ((fasta_l) self)->header, "|");
-    for (i = 0; i < ids_number; i++) {
-        if (strcmp(ids[i], "gi") == 0 && i < ids_number - 1) {
-            *gi = atoi(ids[i + 1]);
-            if (*gi <= 0) {
-                fprintf(stderr, "%s Trying to do atoi in:  %s\n", ids[i], ids[i + 1]);
-                fprintf(stderr, "Can't find Gi %d on: %s\nThe format have to be gi|ginumber: >gi|12345\n", *gi, ((fasta_l) self)->header);
-            }
-            break;
-        }
-    }
-    freeArrayofPointers((void **) ids, ids_number);
-    if (*gi <= 0) {
-        fprintf(stderr, "\nCan't find Gi %d on: %s\nThe format have to be gi|ginumber: >gi|12345\n", *gi, ((fasta_l) self)->header);
-    }
+    *gi = header_gi(((fasta_l) self)->header);
+}
+
+/*
+ * Gi of a fasta header using the sscanf pattern or the default header
+ * format if the pattern is NULL. Returns -1 if the pattern does not match
+ */
+int pattern_gi(char *header, char *giPattern) {
+    int gi;
+    if (giPattern == NULL) return header_gi(header);
+    if (sscanf(header, giPattern, &gi) != 1) return -1;
+    return gi;
 }
 
 /**
@@ -133,6 +355,8 @@ void getGi(void *self, int *gi) {
 void setSeq(void *self, char *string) {
 
     _CHECK_SELF_P(self);
+    FreePackedSequence(((fasta_l) self)->packed);
+    ((fasta_l) self)->packed = NULL;
     ((fasta_l) self)->seq = strdup(string);
     ((fasta_l) self)->len = strlen(string);
 }
@@ -147,9 +371,25 @@ void freeFasta(void *self) {
     if (((fasta_l) self)->header) free(((fasta_l) self)->header);
 
     if (((fasta_l) self)->seq) free(((fasta_l) self)->seq);
+    FreePackedSequence(((fasta_l) self)->packed);
     free(((fasta_l) self));
 }
 
+/**
+ * Pack the sequence with 2 bits per base and free the text 
+ * sequence. The segment and print methods unpack it as needed
+ * 
+ * @param self the container object
+ */
+void packFasta(void *self) {
+    _CHECK_SELF_P(self);
+    if (((fasta_l) self)->seq && !((fasta_l) self)->packed) {
+        ((fasta_l) self)->packed = PackSequence(((fasta_l) self)->seq, ((fasta_l) self)->len);
+        free(((fasta_l) self)->seq);
+        ((fasta_l) self)->seq = NULL;
+    }
+}
+
 /**
  * Extract and print a segments from the start position with length
  * 
@@ -176,8 +416,8 @@ void getSegment(void **outvoid, void * self, char *header, int start, int length
         }
         out->header = strdup(header);
         out->seq = allocate(sizeof (char) * (size + 1), __FILE__, __LINE__);
-        memset(out->seq, 0, sizeof (char) * (size + 1));
-        strncpy(out->seq, (((fasta_l) self)->seq + start), size);
+        copy_sequence(self, start, size, out->seq);
+        out->seq[size] = '\0';
         out->len = size;
         *outvoid = out;
     }
@@ -195,7 +435,6 @@ void getSegment(void **outvoid, void * self, char *header, int start, int length
  */
 void printSegment(void * self, FILE *out, char *header, int start, int length, int lineLength) {
     _CHECK_SELF_P(self);
-    fasta_l outf;
     int size;
 
     if (start < ((fasta_l) self)->len) {
@@ -204,164 +443,605 @@ void printSegment(void * self, FILE *out, char *header, int start, int length, i
         } else {
             size = ((fasta_l) self)->len - start;
         }
-        outf = CreateFasta();
-        outf->setHeader(outf, header);
-        outf->seq = allocate(sizeof (char) * (size + 1), __FILE__, __LINE__);
-        memset(outf->seq, 0, sizeof (char) * (size + 1));
-        strncpy(outf->seq, (((fasta_l) self)->seq + start), size);
-        outf->len = size;
-        outf->toFile(outf, out, lineLength);
-        outf->free(outf);
+        fprintf(out, ">%s\n", header);
+        file_write_sequence(self, out, start, size, lineLength);
+    }
+}
+
+/*
+ * Number of segments from start to end
+ */
+int count_segments(int len, int start, int end, int length, int offset) {
+    int i, n = 0;
+    for (i = start; i < end; i += offset) {
+        n++;
+        if (i + length >= len) break;
     }
+    return n;
 }
 
-void *pthreadSplitInSegments(void *arg) {
-    thread_param_t *parms = ((thread_param_t*) arg);
-    void * self = parms->self;
-    int i, gi;
-    size_t size = (strlen(((fasta_l) self)->header)) + 1000;
-    char *header = allocate(sizeof (char) * size, __FILE__, __LINE__);
-    FILE *fd = checkPointerError(fopen(parms->out, "w"), "Can't open temporal file", __FILE__, __LINE__, -1);
+/*
+ * Format the segment [start, start + length) as a fasta entry at the end 
+ * of the buffer. The segment is a view into the sequence: the header is
+ * printed from the Gi and the positions and the size characters of seq
+ * are copied in lines
+ */
+void append_segment(segment_buffer_t *buf, int gi, int start, int length, char *seq, int size, int lineLength) {
+    int i, line;
+    size_t need;
 
-    for (i = parms->start; i < parms->end; i += parms->offset) {
-        ((fasta_l) self)->getGi(self, &gi);
-        sprintf(header, "%d|%d-%d", gi, i, i + parms->length);
-        printSegment(self, fd, header, i, parms->length, parms->lineLength);
-        if (i + parms->length >= ((fasta_l) self)->len) break;
+    need = 64 + size + size / lineLength + 1;
+    if (buf->size + need > buf->capacity) {
+        buf->capacity = 2 * (buf->size + need);
+        buf->data = reallocate(buf->data, sizeof (char) * buf->capacity, __FILE__, __LINE__);
+    }
+    buf->size += sprintf(buf->data + buf->size, ">%d|%d-%d\n", gi, start, start + length);
+    for (i = 0; i < size; i += lineLength) {
+        line = (i + lineLength < size) ? lineLength : size - i;
+        memcpy(buf->data + buf->size, seq + i, line);
+        buf->size += line;
+        buf->data[buf->size++] = '\n';
     }
+}
 
-    free(header);
-    fclose(fd);
+/*
+ * State of the segment filter over the windows of a task, moved from 
+ * one window to the next. [start, end) is the current window, n and acgt
+ * its N and ACGT counts, triplets the counts of its ACGT triplets and 
+ * repeats the sum of c(c-1)/2 over them. runs are the N runs longer than
+ * maxNRun in the task, run the first one that may overlap the window
+ */
+typedef struct segment_filter_state_t {
+    int start;
+    int end;
+    size_t n;
+    size_t acgt;
+    int triplets[64];
+    long long int repeats;
+    PackedRun_t *runs;
+    int runs_number;
+    int runs_capacity;
+    int run;
+} segment_filter_state_t;
+
+/*
+ * Code of the triplet at text[p] or -1 if it has a base that is not ACGT
+ */
+int segment_triplet(char *text, int p) {
+    int a = pack_code[(unsigned char) text[p]];
+    int b = pack_code[(unsigned char) text[p + 1]];
+    int c = pack_code[(unsigned char) text[p + 2]];
+
+    if (a == 0 || b == 0 || c == 0) return -1;
+    return ((a - 1) << 4) | ((b - 1) << 2) | (c - 1);
+}
+
+/*
+ * Find the N runs longer than maxNRun in [start, end). Blocks without N
+ * are skipped with the vectorized count
+ */
+void find_n_runs(segment_filter_state_t *state, char *text, int origin, int start, int end, int maxNRun) {
+    int p, q, step, runStart = -1;
+    size_t acgt;
+
+    state->runs_number = state->run = 0;
+    for (p = start; p < end; p += step) {
+        step = (end - p < 64) ? end - p : 64;
+        acgt = 0;
+        if (runStart < 0 && countBases(text + p - origin, step, &acgt) == 0) continue;
+        for (q = p; q < p + step; q++) {
+            if (text[q - origin] == 'N') {
+                if (runStart < 0) runStart = q;
+            } else if (runStart >= 0) {
+                if (q - runStart > maxNRun) {
+                    add_packed_run(&state->runs, &state->runs_number, &state->runs_capacity, runStart, 'N');
+                    state->runs[state->runs_number - 1].length = q - runStart;
+                }
+                runStart = -1;
+            }
+        }
+    }
+    if (runStart >= 0 && end - runStart > maxNRun) {
+        add_packed_run(&state->runs, &state->runs_number, &state->runs_capacity, runStart, 'N');
+        state->runs[state->runs_number - 1].length = end - runStart;
+    }
+}
+
+/*
+ * Move the filter to the window [start, end) and check it. The character
+ * at the position p is text[p - origin]
+ */
+int keep_segment(FastaSegmentFilter_t *filter, segment_filter_state_t *state, char *text, int origin, int start, int end) {
+    int p, t, from, to, oldEnd, newEnd, size = end - start;
+    size_t acgt;
+    PackedRun_t *run;
+
+    if (start >= state->end) {
+        /* No overlap with the previous window */
+        state->start = state->end = start;
+        state->n = state->acgt = 0;
+        state->repeats = 0;
+        memset(state->triplets, 0, sizeof (state->triplets));
+    }
+
+    if (filter->maxN >= 0 || filter->minACGT >= 0) {
+        acgt = 0;
+        state->n -= countBases(text + state->start - origin, start - state->start, &acgt);
+        state->acgt -= acgt;
+        state->n += countBases(text + state->end - origin, end - state->end, &state->acgt);
+    }
+
+    if (filter->maxDust >= 0) {
+        /* Triplets start from start to end - 2 */
+        oldEnd = (state->end - 2 > state->start) ? state->end - 2 : state->start;
+        newEnd = (end - 2 > start) ? end - 2 : start;
+        to = (start < oldEnd) ? start : oldEnd;
+        for (p = state->start; p < to; p++) {
+            if ((t = segment_triplet(text, p - origin)) >= 0) state->repeats -= --state->triplets[t];
+        }
+        from = (start > oldEnd) ? start : oldEnd;
+        for (p = from; p < newEnd; p++) {
+            if ((t = segment_triplet(text, p - origin)) >= 0) state->repeats += state->triplets[t]++;
+        }
+    }
+    state->start = start;
+    state->end = end;
+
+    if (filter->maxN >= 0 && state->n > (size_t) filter->maxN) return 0;
+    if (filter->minACGT >= 0 && size > 0 && state->acgt < filter->minACGT * size) return 0;
+    if (filter->maxDust >= 0 && size > 3 && state->repeats > filter->maxDust * (size - 2)) return 0;
+    if (filter->maxNRun >= 0) {
+        while (state->run < state->runs_number && state->runs[state->run].start + state->runs[state->run].length <= start) state->run++;
+        for (t = state->run; t < state->runs_number && state->runs[t].start < end; t++) {
+            run = &state->runs[t];
+            from = (run->start > start) ? run->start : start;
+            to = (run->start + run->length < end) ? run->start + run->length : end;
+            if (to - from > filter->maxNRun) return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * A record queued in a splitter. If own is set it is freed when its last
+ * task is written
+ */
+typedef struct split_record_t {
+    fasta_l fasta;
+    int gi;
+    int own;
+} split_record_t;
+
+/*
+ * The segments [first, last) of a record, segment k starts at k * offset
+ */
+typedef struct split_task_t {
+    split_record_t *record;
+    int first;
+    int last;
+    int isLast;
+    int done;
+    segment_buffer_t res;
+    struct split_task_t *next;
+} split_task_t;
+
+/*
+ * Task deque of a worker. The owner takes the tasks from the front and 
+ * the idle workers steal them from the back
+ */
+typedef struct split_deque_t {
+    split_task_t **tasks;
+    int capacity;
+    int front;
+    int count;
+    pthread_mutex_t lock;
+} split_deque_t;
+
+typedef struct split_worker_t {
+    FastaSplitter_t *splitter;
+    int number;
+} split_worker_t;
+
+/*
+ * head and tail are the ordered queue of the tasks not written yet, 
+ * outstanding its size and queued the tasks in the deques not taken by 
+ * a worker. The writer thread writes the head when it is done
+ */
+struct FastaSplitter_s {
+    FILE *out;
+    char *headerParser;
+    int length;
+    int offset;
+    int lineLength;
+    FastaSegmentFilter_t filter;
+    int filtered;
+    int threads_number;
+    pthread_t *threads;
+    pthread_t writer;
+    split_worker_t *workers;
+    split_deque_t *deques;
+    int nextDeque;
+    split_task_t *head;
+    split_task_t *tail;
+    int outstanding;
+    int queued;
+    int shutdown;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    pthread_cond_t space;
+};
+
+void split_deque_push(split_deque_t *deque, split_task_t *task) {
+    split_task_t **tasks;
+    int i;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity) {
+        tasks = allocate(sizeof (split_task_t *) * (2 * deque->capacity + 16), __FILE__, __LINE__);
+        for (i = 0; i < deque->count; i++) tasks[i] = deque->tasks[(deque->front + i) % deque->capacity];
+        if (deque->tasks) free(deque->tasks);
+        deque->tasks = tasks;
+        deque->capacity = 2 * deque->capacity + 16;
+        deque->front = 0;
+    }
+    deque->tasks[(deque->front + deque->count) % deque->capacity] = task;
+    deque->count++;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+split_task_t *split_deque_pop(split_deque_t *deque, int steal) {
+    split_task_t *task = NULL;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        if (steal) {
+            task = deque->tasks[(deque->front + deque->count - 1) % deque->capacity];
+        } else {
+            task = deque->tasks[deque->front];
+            deque->front = (deque->front + 1) % deque->capacity;
+        }
+        deque->count--;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+/*
+ * Format the segments of a task. The task range of a packed sequence is
+ * unpacked once in text
+ */
+void run_split_task(FastaSplitter_t *splitter, split_task_t *task, segment_filter_state_t *state, char **text, size_t *textCapacity) {
+    fasta_l fasta = task->record->fasta;
+    int i, start, end, spanStart, spanEnd, origin = 0;
+    char *seq = fasta->seq;
+
+    task->res.capacity = (size_t) (task->last - task->first) * (64 + splitter->length + splitter->length / splitter->lineLength + 1) + 1;
+    task->res.data = allocate(sizeof (char) * task->res.capacity, __FILE__, __LINE__);
+    if (task->first == task->last) return;
+
+    spanStart = task->first * splitter->offset;
+    spanEnd = (task->last - 1) * splitter->offset + splitter->length;
+    if (spanEnd > fasta->len) spanEnd = fasta->len;
+    if (fasta->packed) {
+        if ((size_t) (spanEnd - spanStart) > *textCapacity) {
+            *textCapacity = spanEnd - spanStart;
+            *text = reallocate(*text, sizeof (char) * *textCapacity, __FILE__, __LINE__);
+        }
+        UnpackSequence(fasta->packed, spanStart, spanEnd - spanStart, *text);
+        seq = *text;
+        origin = spanStart;
+    }
+
+    if (splitter->filtered) {
+        state->start = state->end = spanStart;
+        state->n = state->acgt = 0;
+        state->repeats = 0;
+        memset(state->triplets, 0, sizeof (state->triplets));
+        state->runs_number = state->run = 0;
+        if (splitter->filter.maxNRun >= 0) find_n_runs(state, seq, origin, spanStart, spanEnd, splitter->filter.maxNRun);
+    }
+    for (i = task->first; i < task->last; i++) {
+        start = i * splitter->offset;
+        if (start >= fasta->len) break;
+        end = (start + splitter->length < fasta->len) ? start + splitter->length : fasta->len;
+        /* Rejected windows are never copied */
+        if (splitter->filtered && !keep_segment(&splitter->filter, state, seq, origin, start, end)) continue;
+        append_segment(&task->res, task->record->gi, start, splitter->length, seq + start - origin, end - start, splitter->lineLength);
+    }
+}
+
+void *split_worker(void *arg) {
+    split_worker_t *worker = (split_worker_t *) arg;
+    FastaSplitter_t *splitter = worker->splitter;
+    segment_filter_state_t state;
+    char *text = NULL;
+    size_t textCapacity = 0;
+    split_task_t *task;
+    int i;
+
+    state.runs = NULL;
+    state.runs_capacity = 0;
+    while (1) {
+        pthread_mutex_lock(&splitter->lock);
+        while (splitter->queued == 0 && !splitter->shutdown) {
+            pthread_cond_wait(&splitter->work, &splitter->lock);
+        }
+        if (splitter->queued == 0) {
+            pthread_mutex_unlock(&splitter->lock);
+            break;
+        }
+        /* One of the queued tasks is for this worker */
+        splitter->queued--;
+        pthread_mutex_unlock(&splitter->lock);
+
+        task = split_deque_pop(&splitter->deques[worker->number], 0);
+        for (i = 1; task == NULL; i++) {
+            task = split_deque_pop(&splitter->deques[(worker->number + i) % splitter->threads_number], 1);
+        }
+
+        run_split_task(splitter, task, &state, &text, &textCapacity);
+
+        pthread_mutex_lock(&splitter->lock);
+        task->done = 1;
+        if (task == splitter->head) pthread_cond_signal(&splitter->done);
+        pthread_mutex_unlock(&splitter->lock);
+    }
+    if (text) free(text);
+    if (state.runs) free(state.runs);
     return NULL;
 }
 
-void *pthreadSplitInSegmentsInMem(void *arg) {
-    thread_param_t *parms = ((thread_param_t*) arg);
-    void * self = parms->self;
-    int i, gi;
-    size_t size = (strlen(((fasta_l) self)->header)) + 1000;
-    char *header = allocate(sizeof (char) * size, __FILE__, __LINE__);
-    void **res = NULL;
-    int resNumber = 0;
-
-    memset(header, 0, size);
-    for (i = parms->start; i < parms->end; i += parms->offset) {
-        sscanf(((fasta_l) self)->header, parms->parser, &gi);
-        if (gi <= 0) {
-            fprintf(stderr, "Bad GI %d on header: %s\n", gi, ((fasta_l) self)->header);
-            exit(-1);
-        }
-        sprintf(header, "%d|%d-%d", gi, i, i + parms->length);
-        res = realloc(res, sizeof (void **) * (resNumber + 1));
-        checkPointerError(res, "Can't allocate memory", __FILE__, __LINE__, -1);
-        getSegment((void **) &(res[resNumber]), self, header, i, parms->length);
-        resNumber++;
-        if (i + parms->length >= ((fasta_l) self)->len) break;
-    }
-
-    parms->res = res;
-    parms->resNumber = resNumber;
-    free(header);
+/*
+ * Write the tasks in order as they are done
+ */
+void *split_writer(void *arg) {
+    FastaSplitter_t *splitter = (FastaSplitter_t *) arg;
+    split_task_t *task;
+
+    pthread_mutex_lock(&splitter->lock);
+    while (1) {
+        while ((splitter->head == NULL || !splitter->head->done) && !(splitter->shutdown && splitter->head == NULL)) {
+            pthread_cond_wait(&splitter->done, &splitter->lock);
+        }
+        if (splitter->head == NULL) break;
+        task = splitter->head;
+        splitter->head = task->next;
+        if (splitter->head == NULL) splitter->tail = NULL;
+        pthread_mutex_unlock(&splitter->lock);
+
+        if (task->res.size > 0 && fwrite(task->res.data, 1, task->res.size, splitter->out) != task->res.size) {
+            checkPointerError(NULL, "Can't write the segments", __FILE__, __LINE__, -1);
+        }
+        if (task->res.data) free(task->res.data);
+        if (task->isLast) {
+            if (task->record->own) task->record->fasta->free(task->record->fasta);
+            free(task->record);
+        }
+        free(task);
+
+        pthread_mutex_lock(&splitter->lock);
+        splitter->outstanding--;
+        pthread_cond_broadcast(&splitter->space);
+    }
+    pthread_mutex_unlock(&splitter->lock);
     return NULL;
 }
 
+/*
+ * Queue the segments of a fasta entry in tasks. It waits while the 
+ * ordered queue is full
+ */
+void split_add(FastaSplitter_t *splitter, fasta_l fasta, int own) {
+    split_record_t *record = allocate(sizeof (split_record_t), __FILE__, __LINE__);
+    split_task_t *task;
+    int number, perTask, first = 0;
+
+    number = count_segments(fasta->len, 0, fasta->len, splitter->length, splitter->offset);
+    record->fasta = fasta;
+    record->gi = 0;
+    record->own = own;
+    if (number > 0) {
+        if (splitter->headerParser) {
+            sscanf(fasta->header, splitter->headerParser, &record->gi);
+            if (record->gi <= 0) {
+                fprintf(stderr, "Bad GI %d on header: %s\n", record->gi, fasta->header);
+                exit(-1);
+            }
+        } else {
+            fasta->getGi(fasta, &record->gi);
+        }
+    }
+
+    perTask = FASTA_SPLIT_TASK / (((splitter->length > splitter->offset) ? splitter->length : splitter->offset) + 64);
+    if (perTask < 1) perTask = 1;
+    do {
+        task = allocate(sizeof (split_task_t), __FILE__, __LINE__);
+        task->record = record;
+        task->first = first;
+        task->last = (number - first > perTask) ? first + perTask : number;
+        task->isLast = (task->last == number);
+        task->done = 0;
+        task->res.data = NULL;
+        task->res.size = task->res.capacity = 0;
+        task->next = NULL;
+        first = task->last;
+
+        pthread_mutex_lock(&splitter->lock);
+        while (splitter->outstanding >= splitter->threads_number * FASTA_SPLIT_AHEAD) {
+            pthread_cond_wait(&splitter->space, &splitter->lock);
+        }
+        if (splitter->tail) {
+            splitter->tail->next = task;
+        } else {
+            splitter->head = task;
+        }
+        splitter->tail = task;
+        splitter->outstanding++;
+        pthread_mutex_unlock(&splitter->lock);
+
+        split_deque_push(&splitter->deques[splitter->nextDeque], task);
+        splitter->nextDeque = (splitter->nextDeque + 1) % splitter->threads_number;
+
+        pthread_mutex_lock(&splitter->lock);
+        splitter->queued++;
+        pthread_cond_signal(&splitter->work);
+        pthread_mutex_unlock(&splitter->lock);
+    } while (first < number);
+}
+
 /**
- * Creates segments of length with an overlap of offset
+ * Create a splitter that generates the segments of length with an 
+ * overlap of offset of the sequences using a pool of threads
  * 
- * @param self the container object
  * @param out the output file 
- * @param headerParser sscanf format to parse the fasta header
+ * @param headerParser sscanf format to parse the Gi from the fasta header. If null use default fasta header
  * @param length the length of the segments
  * @param offset the offset of the segments
  * @param lineLength the length of the fasta line
  * @param threads_number Number of threads
- * @param inMem du the generation in memory
+ * @param filter the segments filter (copied) or NULL to keep all the segments
+ * @return the splitter
  */
-void splitInSegments(void * self, FILE *out, char *headerParser, int length, int offset, int lineLength, int threads_number, int inMem) {
-    _CHECK_SELF_P(self);
-    int i, j, reads, numPerThread, thread_cr_res, thread_join_res;
-    pthread_t *threads = allocate(sizeof (pthread_t) * threads_number, __FILE__, __LINE__);
-    thread_param_t *tp = allocate(sizeof (thread_param_t) * threads_number, __FILE__, __LINE__);
-    char **tFiles = NULL;
-    pid_t pid = getpid();
-    size_t bytes;
-    char buffer[SIZE];
-    FILE *fd;
+FastaSplitter_t *CreateFastaSplitter(FILE *out, char *headerParser, int length, int offset, int lineLength, int threads_number, FastaSegmentFilter_t *filter) {
+    FastaSplitter_t *splitter = allocate(sizeof (FastaSplitter_t), __FILE__, __LINE__);
+    int i;
 
-    if (inMem == 0) {
-        tFiles = allocate(sizeof (char **) * threads_number, __FILE__, __LINE__);
+    if (length <= 0 || offset <= 0 || lineLength <= 0 || threads_number <= 0) {
+        checkPointerError(NULL, "The segment length, offset, line length and threads have to be positive", __FILE__, __LINE__, -1);
     }
-
-    reads = ((fasta_l) self)->len / offset;
-    numPerThread = reads / threads_number;
-
+    splitter->out = out;
+    splitter->headerParser = headerParser;
+    splitter->length = length;
+    splitter->offset = offset;
+    splitter->lineLength = lineLength;
+    splitter->filtered = (filter != NULL);
+    if (filter) {
+        splitter->filter = *filter;
+    } else {
+        splitter->filter.maxN = splitter->filter.maxNRun = -1;
+        splitter->filter.minACGT = splitter->filter.maxDust = -1;
+    }
+    splitter->threads_number = threads_number;
+    splitter->nextDeque = 0;
+    splitter->head = splitter->tail = NULL;
+    splitter->outstanding = splitter->queued = splitter->shutdown = 0;
+    pthread_mutex_init(&splitter->lock, NULL);
+    pthread_cond_init(&splitter->work, NULL);
+    pthread_cond_init(&splitter->done, NULL);
+    pthread_cond_init(&splitter->space, NULL);
+    splitter->deques = allocate(sizeof (split_deque_t) * threads_number, __FILE__, __LINE__);
+    splitter->workers = allocate(sizeof (split_worker_t) * threads_number, __FILE__, __LINE__);
+    splitter->threads = allocate(sizeof (pthread_t) * threads_number, __FILE__, __LINE__);
     for (i = 0; i < threads_number; i++) {
-        fflush(NULL);
-        if (inMem == 0) {
-            tFiles[i] = allocate(sizeof (char *) * 150, __FILE__, __LINE__);
-            sprintf(tFiles[i], "%d_%d.fna", pid, i);
-            tp[i].out = tFiles[i];
-        }
-
-        tp[i].parser = headerParser;
-        tp[i].number = i;
-        tp[i].length = length;
-        tp[i].lineLength = lineLength;
-        tp[i].offset = offset;
-        tp[i].self = self;
-        tp[i].start = i * numPerThread * offset;
-        tp[i].res = NULL;
-        tp[i].resNumber = 0;
-        if (i < threads_number - 1) {
-            tp[i].end = (i + 1) * numPerThread * offset;
-        } else {
-            tp[i].end = ((fasta_l) self)->len;
-        }
-
-        if (inMem == 0) {
-            thread_cr_res = pthread_create(&threads[i],
-                    NULL,
-                    pthreadSplitInSegments,
-                    (void*) &(tp[i]));
-        } else {
-            thread_cr_res = pthread_create(&threads[i],
-                    NULL,
-                    pthreadSplitInSegmentsInMem,
-                    (void*) &(tp[i]));
-        }
-        if (thread_cr_res != 0) {
+        splitter->deques[i].tasks = NULL;
+        splitter->deques[i].capacity = splitter->deques[i].front = splitter->deques[i].count = 0;
+        pthread_mutex_init(&splitter->deques[i].lock, NULL);
+    }
+    for (i = 0; i < threads_number; i++) {
+        splitter->workers[i].splitter = splitter;
+        splitter->workers[i].number = i;
+        if (pthread_create(&splitter->threads[i], NULL, split_worker, &splitter->workers[i]) != 0) {
             checkPointerError(NULL, "THREAD CREATE ERROR", __FILE__, __LINE__, -1);
         }
     }
+    if (pthread_create(&splitter->writer, NULL, split_writer, splitter) != 0) {
+        checkPointerError(NULL, "THREAD CREATE ERROR", __FILE__, __LINE__, -1);
+    }
+    return splitter;
+}
 
-    for (i = 0; i < threads_number; i++) {
-        fflush(NULL);
-        thread_join_res = pthread_join(threads[i], NULL);
-        if (thread_join_res != 0) {
-            checkPointerError(NULL, "JOIN ERROR", __FILE__, __LINE__, -1);
-        }
-        if (inMem == 0) {
-            fd = checkPointerError(fopen(tFiles[i], "r"), "Can't open temporal file", __FILE__, __LINE__, -1);
+/**
+ * Queue the segments of a fasta entry. The splitter frees the entry 
+ * when its segments are written
+ * 
+ * @param splitter the splitter
+ * @param fasta the fasta entry
+ */
+void FastaSplitterAdd(FastaSplitter_t *splitter, fasta_l fasta) {
+    split_add(splitter, fasta, 1);
+}
 
-            while (0 < (bytes = fread(buffer, 1, sizeof (buffer), fd))) {
-                fwrite(buffer, 1, bytes, out);
-            }
-            fclose(fd);
-            remove(tFiles[i]);
-            if (tFiles[i]) free(tFiles[i]);
-        } else {
-            for (j = 0; j < tp[i].resNumber; j++) {
-                if (strstr(((fasta_l) tp[i].res[j])->seq, "NNNNN") == NULL) {
-                    ((fasta_l) tp[i].res[j])->toFile(tp[i].res[j], out, lineLength);
-                }
-                ((fasta_l) tp[i].res[j])->free(tp[i].res[j]);
+/**
+ * Wait until the segments of the queued entries are written
+ * 
+ * @param splitter the splitter
+ */
+void FastaSplitterFlush(FastaSplitter_t *splitter) {
+    pthread_mutex_lock(&splitter->lock);
+    while (splitter->outstanding > 0) {
+        pthread_cond_wait(&splitter->space, &splitter->lock);
+    }
+    pthread_mutex_unlock(&splitter->lock);
+}
+
+/**
+ * Write the queued segments and change the output file
+ * 
+ * @param splitter the splitter
+ * @param out the new output file
+ */
+void FastaSplitterSetOutput(FastaSplitter_t *splitter, FILE *out) {
+    FastaSplitterFlush(splitter);
+    splitter->out = out;
+}
+
+/**
+ * Write the queued segments, stop the threads and free the splitter.
+ * The output file is not closed
+ * 
+ * @param splitter the splitter
+ */
+void FreeFastaSplitter(FastaSplitter_t *splitter) {
+    int i;
+
+    if (splitter) {
+        FastaSplitterFlush(splitter);
+        pthread_mutex_lock(&splitter->lock);
+        splitter->shutdown = 1;
+        pthread_cond_broadcast(&splitter->work);
+        pthread_cond_broadcast(&splitter->done);
+        pthread_mutex_unlock(&splitter->lock);
+        for (i = 0; i < splitter->threads_number; i++) {
+            if (pthread_join(splitter->threads[i], NULL) != 0) {
+                checkPointerError(NULL, "JOIN ERROR", __FILE__, __LINE__, -1);
             }
-            free(tp[i].res);
+            if (splitter->deques[i].tasks) free(splitter->deques[i].tasks);
+            pthread_mutex_destroy(&splitter->deques[i].lock);
         }
+        if (pthread_join(splitter->writer, NULL) != 0) {
+            checkPointerError(NULL, "JOIN ERROR", __FILE__, __LINE__, -1);
+        }
+        pthread_mutex_destroy(&splitter->lock);
+        pthread_cond_destroy(&splitter->work);
+        pthread_cond_destroy(&splitter->done);
+        pthread_cond_destroy(&splitter->space);
+        free(splitter->deques);
+        free(splitter->workers);
+        free(splitter->threads);
+        free(splitter);
     }
-    if (tp) free(tp);
-    if (tFiles)free(tFiles);
-    if (threads)free(threads);
+}
+
+/**
+ * Creates segments of length with an overlap of offset using threads
+ * 
+ * @param self the container object
+ * @param out the output file 
+ * @param headerParser sscanf format to parse the fasta header
+ * @param length the length of the segments
+ * @param offset the offset of the segments
+ * @param lineLength the length of the fasta line
+ * @param threads_number Number of threads
+ * @param inMem 1 to skip the segments with a run of more than FASTA_FILTER_N_RUN N and parse the Gi with headerParser
+ */
+void splitInSegments(void * self, FILE *out, char *headerParser, int length, int offset, int lineLength, int threads_number, int inMem) {
+    _CHECK_SELF_P(self);
+    FastaSegmentFilter_t filter = {-1, FASTA_FILTER_N_RUN, -1, -1};
+    FastaSplitter_t *splitter = CreateFastaSplitter(out, inMem ? headerParser : NULL, length, offset, lineLength, threads_number, inMem ? &filter : NULL);
+
+    split_add(splitter, self, 0);
+    FreeFastaSplitter(splitter);
 }
 
 /**
@@ -375,6 +1055,7 @@ fasta_l CreateFasta() {
     self->header = NULL;
     self->seq = NULL;
     self->len = 0;
+    self->packed = NULL;
     self->toString = &toStringFasta;
     self->length = &length;
     self->free = &freeFasta;
@@ -385,78 +1066,389 @@ fasta_l CreateFasta() {
     self->toFile = &toFileFasta;
     self->getSegment = &getSegment;
     self->getGi = &getGi;
+    self->pack = &packFasta;
 
     return self;
 }
 
+/*
+ * Create a reader with an initial buffer of bufferSize bytes
+ */
+FastaReader_t *make_fasta_reader(FILE *fp, size_t bufferSize) {
+    FastaReader_t *reader = allocate(sizeof (FastaReader_t), __FILE__, __LINE__);
+
+    reader->fp = fp;
+    reader->capacity = bufferSize;
+    reader->buffer = allocate(sizeof (char) * reader->capacity, __FILE__, __LINE__);
+    reader->size = reader->pos = 0;
+    reader->offset = ftello(fp);
+    reader->eof = 0;
+    reader->seq = NULL;
+    reader->seqCapacity = 0;
+    return reader;
+}
+
+/*
+ * Move the unread bytes to the beginning of the buffer and read more.
+ * The buffer grows if it is full. Returns 0 if there is nothing else to read
+ */
+int fill_fasta_reader(FastaReader_t *reader) {
+    size_t n;
+
+    if (reader->eof) return 0;
+    if (reader->pos > 0) {
+        memmove(reader->buffer, reader->buffer + reader->pos, reader->size - reader->pos);
+        reader->offset += reader->pos;
+        reader->size -= reader->pos;
+        reader->pos = 0;
+    }
+    if (reader->size == reader->capacity) {
+        reader->capacity *= 2;
+        reader->buffer = reallocate(reader->buffer, sizeof (char) * reader->capacity, __FILE__, __LINE__);
+    }
+    n = fread(reader->buffer + reader->size, sizeof (char), reader->capacity - reader->size, reader->fp);
+    if (n == 0) reader->eof = 1;
+    reader->size += n;
+    return n != 0;
+}
+
+/*
+ * Move the reader to the next line starting with '>'. The current
+ * position is not taken as a line start. Returns 0 if there is no other
+ * entry in the file
+ */
+int sync_fasta_reader(FastaReader_t *reader) {
+    size_t avail, found, lines = 0;
+
+    if (reader->pos == reader->size && !fill_fasta_reader(reader)) return 0;
+    while (1) {
+        avail = reader->size - reader->pos;
+        found = findLineStart(reader->buffer + reader->pos, avail, '>', &lines);
+        reader->pos += found;
+        if (found < avail) return 1;
+        /* The last newline of the block is kept for the next search */
+        reader->pos--;
+        if (!fill_fasta_reader(reader)) return 0;
+    }
+}
+
+/*
+ * Append bytes to the sequence buffer of the reader
+ */
+void append_fasta_reader(FastaReader_t *reader, size_t *len, char *data, size_t size) {
+    if (*len + size + 1 > reader->seqCapacity) {
+        reader->seqCapacity = 2 * (*len + size + 1);
+        reader->seq = reallocate(reader->seq, sizeof (char) * reader->seqCapacity, __FILE__, __LINE__);
+    }
+    memcpy(reader->seq + *len, data, size);
+    *len += size;
+}
+
 /**
- * Read the fasta entry using a buffer of characters
+ * Create a sequential fasta reader that starts at the current position 
+ * of the file
  * 
  * @param fp the input file
- * @param bufferSize the number of characters in the buffer
- * @param excludeSeq 1 if you want to exclude the sequence and read only the header 
- * @return the fasta entry
+ * @return the reader
  */
-fasta_l ReadFastaBuffer(FILE *fp, int bufferSize, int excludeSeq) {
+FastaReader_t *CreateFastaReader(FILE *fp) {
+    return make_fasta_reader(fp, FASTA_READER_BUFFER);
+}
+
+/*
+ * Read the next fasta entry. The sequence is copied from the reader 
+ * buffer as text or packed
+ */
+fasta_l read_fasta_entry(FastaReader_t *reader, int excludeSeq, int pack) {
     fasta_l self = NULL;
+    char *nl, *start;
+    size_t len = 0, avail;
+    int lineStart = 1;
 
-    size_t buf_size, seq_size;
-    char *buffer, *seq, *line, *str;
-    off_t pos;
-    int numLines, readTotal, out;
+    /* Header line: the blank lines before it are skipped */
+    while (self == NULL) {
+        if (reader->pos == reader->size && !fill_fasta_reader(reader)) return NULL;
+        start = reader->buffer + reader->pos;
+        if (*start == '\n') {
+            reader->pos++;
+            continue;
+        }
+        if (*start != '>') {
+            checkPointerError(NULL, "The fasta file does not start with the header (>)", __FILE__, __LINE__, -1);
+        }
+        nl = memchr(start, '\n', reader->size - reader->pos);
+        if (nl == NULL && fill_fasta_reader(reader)) continue;
+        if (nl == NULL) nl = reader->buffer + reader->size;
+        start = reader->buffer + reader->pos;
+        self = CreateFasta();
+        self->header = strndup(start + 1, nl - start - 1);
+        reader->pos = (nl - reader->buffer) + (nl < reader->buffer + reader->size);
+    }
+
+    /* Sequence lines up to the next header */
+    while (1) {
+        if (reader->pos == reader->size && !fill_fasta_reader(reader)) break;
+        start = reader->buffer + reader->pos;
+        if (lineStart && *start == '>') break;
+        avail = reader->size - reader->pos;
+        nl = memchr(start, '\n', avail);
+        if (!excludeSeq) {
+            append_fasta_reader(reader, &len, start, (nl != NULL) ? (size_t) (nl - start) : avail);
+        }
+        reader->pos += (nl != NULL) ? (size_t) (nl - start + 1) : avail;
+        lineStart = (nl != NULL);
+    }
+    if (pack) {
+        self->packed = PackSequence(reader->seq, len);
+        self->len = len;
+    } else if (!excludeSeq) {
+        self->seq = allocate(sizeof (char) * (len + 1), __FILE__, __LINE__);
+        if (len > 0) memcpy(self->seq, reader->seq, len);
+        self->seq[len] = '\0';
+        self->len = len;
+    }
+    return self;
+}
+
+/**
+ * Read the next fasta entry
+ * 
+ * @param reader the reader
+ * @param excludeSeq 1 if you want to exclude the sequence and read only the header 
+ * @return the fasta entry or NULL at the end of the file
+ */
+fasta_l FastaReaderNext(FastaReader_t *reader, int excludeSeq) {
+    return read_fasta_entry(reader, excludeSeq, 0);
+}
+
+/**
+ * Read the next fasta entry with the sequence packed with 2 bits per
+ * base. The text sequence is only kept in the reader buffer
+ * 
+ * @param reader the reader
+ * @return the fasta entry or NULL at the end of the file
+ */
+fasta_l FastaReaderNextPacked(FastaReader_t *reader) {
+    return read_fasta_entry(reader, 0, 1);
+}
+
+/**
+ * Find the next fasta entry without reading its sequence. Only the 
+ * header is parsed, the sequence is skipped looking for the next 
+ * line starting with '>' 
+ * 
+ * @param reader the reader
+ * @param entry returns the position of the entry
+ * @return 1 if an entry was found, 0 at the end of the file
+ */
+int FastaReaderNextIndex(FastaReader_t *reader, FastaIndexEntry_t *entry) {
+    char *nl, *start;
+    size_t len, avail, found, bytes = 0, lines = 0;
+    int lineStart = 1;
+
+    /* Header line: the blank lines before it are skipped */
+    while (1) {
+        if (reader->pos == reader->size && !fill_fasta_reader(reader)) return 0;
+        start = reader->buffer + reader->pos;
+        if (*start == '\n') {
+            reader->pos++;
+            continue;
+        }
+        if (*start != '>') {
+            checkPointerError(NULL, "The fasta file does not start with the header (>)", __FILE__, __LINE__, -1);
+        }
+        nl = memchr(start, '\n', reader->size - reader->pos);
+        if (nl == NULL && fill_fasta_reader(reader)) continue;
+        break;
+    }
+    if (nl == NULL) nl = reader->buffer + reader->size;
+    start = reader->buffer + reader->pos;
+    len = nl - start - 1;
+    if (len + 1 > reader->seqCapacity) {
+        reader->seqCapacity = 2 * (len + 1);
+        reader->seq = reallocate(reader->seq, sizeof (char) * reader->seqCapacity, __FILE__, __LINE__);
+    }
+    memcpy(reader->seq, start + 1, len);
+    reader->seq[len] = '\0';
+    entry->header = reader->seq;
+    entry->offset = FastaReaderTell(reader);
+    reader->pos = (nl - reader->buffer) + (nl < reader->buffer + reader->size);
+    entry->seqOffset = FastaReaderTell(reader);
+
+    /* Geometry of the first sequence line */
+    entry->lineBases = entry->lineWidth = 0;
+    while (1) {
+        if (reader->pos == reader->size && !fill_fasta_reader(reader)) break;
+        start = reader->buffer + reader->pos;
+        if (*start == '>') break;
+        nl = memchr(start, '\n', reader->size - reader->pos);
+        if (nl == NULL && fill_fasta_reader(reader)) continue;
+        start = reader->buffer + reader->pos;
+        if (nl == NULL) nl = reader->buffer + reader->size;
+        entry->lineBases = nl - start;
+        entry->lineWidth = entry->lineBases + (nl < reader->buffer + reader->size);
+        break;
+    }
+
+    /* Skip the sequence counting its bytes and newlines */
+    while (1) {
+        if (reader->pos == reader->size && !fill_fasta_reader(reader)) break;
+        start = reader->buffer + reader->pos;
+        if (lineStart && *start == '>') break;
+        avail = reader->size - reader->pos;
+        found = findLineStart(start, avail, '>', &lines);
+        bytes += found;
+        reader->pos += found;
+        if (found < avail) break;
+        lineStart = (start[avail - 1] == '\n');
+    }
+    entry->length = bytes - lines;
+    return 1;
+}
+
+/**
+ * Return the file offset of the next fasta entry
+ * 
+ * @param reader the reader
+ * @return the offset
+ */
+off_t FastaReaderTell(FastaReader_t *reader) {
+    return reader->offset + reader->pos;
+}
+
+/**
+ * Free the reader. The file is not closed
+ * 
+ * @param reader the reader
+ */
+void FreeFastaReader(FastaReader_t *reader) {
+    if (reader) {
+        if (reader->buffer) free(reader->buffer);
+        if (reader->seq) free(reader->seq);
+        free(reader);
+    }
+}
+
+/**
+ * Create a buffered fasta writer. Nothing else should write to the 
+ * file until the writer is flushed
+ * 
+ * @param fp the output file
+ * @param lineLength the length of the fasta line
+ * @return the writer
+ */
+FastaWriter_t *CreateFastaWriter(FILE *fp, int lineLength) {
+    FastaWriter_t *writer = allocate(sizeof (FastaWriter_t), __FILE__, __LINE__);
+
+    if (lineLength <= 0) {
+        checkPointerError(NULL, "The fasta line length has to be positive", __FILE__, __LINE__, -1);
+    }
+    writer->fp = fp;
+    writer->fd = fileno(fp);
+    writer->capacity = FASTA_WRITER_BUFFER;
+    writer->buffer = allocate(sizeof (char) * writer->capacity, __FILE__, __LINE__);
+    writer->size = 0;
+    writer->lineLength = lineLength;
+    return writer;
+}
+
+/**
+ * Write the buffer to the file
+ * 
+ * @param writer the writer
+ */
+void FastaWriterFlush(FastaWriter_t *writer) {
+    size_t done = 0;
+    ssize_t bytes;
 
-    seq_size = buf_size = sizeof (char) * bufferSize;
-    buffer = allocate(sizeof (char) * (bufferSize + 1), __FILE__, __LINE__);
-    if (!excludeSeq) {
-        seq = allocate(sizeof (char) * (bufferSize + 1), __FILE__, __LINE__);
-        seq[0] = '\0';
+    if (writer->size == 0) return;
+    if (writer->fd < 0) {
+        if (fwrite(writer->buffer, 1, writer->size, writer->fp) != writer->size) {
+            checkPointerError(NULL, "Can't write to the fasta file", __FILE__, __LINE__, -1);
+        }
     } else {
-        seq = NULL;
-    }
-    pos = ftello(fp);
-    readTotal = out = 0;
-    numLines = 0;
-    while (!feof(fp)) {
-        memset(buffer, 0, buf_size);
-        if (fread(buffer, buf_size, 1, fp) == 1) buffer[bufferSize] = '\0';
-        str = buffer;
-        while (1) {
-            line = strchr(str, '\n');
-            if (line) *line = '\0';
-            if (*str != '\0' && *str != '\n') {
-                if (*str == '>') {
-                    if (self == NULL) {
-                        readTotal += strlen(str);
-                        self = CreateFasta();
-                        self->header = strndup(str + 1, strlen(str) - 1);
-                    } else {
-                        if (!excludeSeq) self->setSeq(self, seq);
-                        pos = pos + sizeof (char) * (readTotal + numLines);
-                        fseeko(fp, pos, SEEK_SET);
-                        break;
-                    }
-                } else {
-                    checkPointerError(self, "The fasta file does not start with the header (>)", __FILE__, __LINE__, -1);
-                    readTotal += strlen(str);
-                    if (!excludeSeq) {
-                        if (readTotal >= seq_size) {
-                            seq_size += seq_size;
-                            seq = reallocate(seq, seq_size, __FILE__, __LINE__);
-                        }
-                        strcat(seq, str);
-                    }
-                }
+        /* Whatever was written to the FILE before goes first */
+        fflush(writer->fp);
+        while (done < writer->size) {
+            bytes = write(writer->fd, writer->buffer + done, writer->size - done);
+            if (bytes < 0) {
+                checkPointerError(NULL, "Can't write to the fasta file", __FILE__, __LINE__, -1);
             }
-            if (!line) break;
-            str = line + 1;
-            numLines++;
+            done += bytes;
+        }
+    }
+    writer->size = 0;
+}
+
+/*
+ * Make room for size bytes in the writer buffer
+ */
+void reserve_fasta_writer(FastaWriter_t *writer, size_t size) {
+    if (writer->size + size > writer->capacity) {
+        FastaWriterFlush(writer);
+        if (size > writer->capacity) {
+            writer->capacity = size;
+            writer->buffer = reallocate(writer->buffer, sizeof (char) * writer->capacity, __FILE__, __LINE__);
         }
-        if (*str == '>') break;
     }
-    if (feof(fp) && self && !self->seq && !excludeSeq) self->setSeq(self, seq);
+}
+
+/**
+ * Write a fasta object. Packed sequences are unpacked in the buffer
+ * 
+ * @param writer the writer
+ * @param fasta the fasta object
+ */
+void FastaWriterWriteFasta(FastaWriter_t *writer, fasta_l fasta) {
+    size_t headerLen = strlen(fasta->header);
+    int i, line;
+
+    reserve_fasta_writer(writer, headerLen + 2);
+    writer->buffer[writer->size++] = '>';
+    memcpy(writer->buffer + writer->size, fasta->header, headerLen);
+    writer->size += headerLen;
+    writer->buffer[writer->size++] = '\n';
+    for (i = 0; i < fasta->len; i += line) {
+        line = (i + writer->lineLength < fasta->len) ? writer->lineLength : fasta->len - i;
+        reserve_fasta_writer(writer, line + 1);
+        if (fasta->packed) {
+            UnpackSequence(fasta->packed, i, line, writer->buffer + writer->size);
+        } else {
+            memcpy(writer->buffer + writer->size, fasta->seq + i, line);
+        }
+        writer->size += line;
+        writer->buffer[writer->size++] = '\n';
+    }
+}
+
+/**
+ * Flush and free the writer. The file is not closed
+ * 
+ * @param writer the writer
+ */
+void FreeFastaWriter(FastaWriter_t *writer) {
+    if (writer) {
+        FastaWriterFlush(writer);
+        if (writer->buffer) free(writer->buffer);
+        free(writer);
+    }
+}
 
-    if (!excludeSeq) free(seq);
-    free(buffer);
+/**
+ * Read the fasta entry using a buffer of characters
+ * 
+ * @param fp the input file
+ * @param bufferSize the number of characters in the buffer
+ * @param excludeSeq 1 if you want to exclude the sequence and read only the header 
+ * @return the fasta entry
+ */
+fasta_l ReadFastaBuffer(FILE *fp, int bufferSize, int excludeSeq) {
+    FastaReader_t *reader = make_fasta_reader(fp, bufferSize);
+    fasta_l self = FastaReaderNext(reader, excludeSeq);
+
+    /* Leave the file at the next entry */
+    fseeko(fp, FastaReaderTell(reader), SEEK_SET);
+    FreeFastaReader(reader);
     return self;
 }
 
@@ -468,10 +1460,7 @@ fasta_l ReadFastaBuffer(FILE *fp, int bufferSize, int excludeSeq) {
  * @return the fasta entry
  */
 fasta_l ReadFasta(FILE *fp, int excludeSeq) {
-    if (!excludeSeq)
-        return ReadFastaBuffer(fp, 7000000, excludeSeq);
-    else
-        return ReadFastaBuffer(fp, 7000, excludeSeq);
+    return ReadFastaBuffer(fp, 65536, excludeSeq);
 }
 
 /**
@@ -539,27 +1528,27 @@ fasta_l ReadFastaGzip(gzFile fp, int excludeSeq) {
  * @return the number of elements read
  */
 int CreateFastaIndexToFile(FILE *fd, FILE *fo, int verbose) {
-    fasta_l fasta;
+    FastaReader_t *reader;
+    FastaIndexEntry_t entry;
     int count, gi;
     count = 0;
-    off_t pos = 0;
 
     if (verbose) {
         printf("Creating the fasta index\n");
         fflush(stdout);
     }
-    while ((fasta = ReadFasta(fd, 1)) != NULL) {
-        fasta->getGi(fasta, &gi);
-        if (verbose) {
+    reader = CreateFastaReader(fd);
+    while (FastaReaderNextIndex(reader, &entry)) {
+        gi = header_gi(entry.header);
+        if (verbose && count % FASTA_INDEX_PROGRESS == 0) {
             printf("Total: %10d \r", count);
             fflush(stdout);
         }
         fwrite(&gi, sizeof (int), 1, fo);
-        fwrite(&(pos), sizeof (off_t), 1, fo);
-        fasta->free(fasta);
-        pos = ftello(fd);
+        fwrite(&(entry.offset), sizeof (off_t), 1, fo);
         count++;
     }
+    FreeFastaReader(reader);
     if (verbose) {
         printf("Total: %10d \n", count);
         fflush(stdout);
@@ -568,42 +1557,50 @@ int CreateFastaIndexToFile(FILE *fd, FILE *fo, int verbose) {
 }
 
 /**
- * Create a Btree index which include the gi and the offset position
+ * Create a samtools like .fai text file with the name, sequence length,
+ * sequence offset, line bases and line width of each entry
  * 
  * @param fd the input fasta file
+ * @param fo the output text file
  * @param verbose 1 to print info
- * @return the Btree index
+ * @return the number of elements read
  */
-BtreeNode_t * CreateBtreeFromFasta(FILE *fd, int verbose) {
-    fasta_l fasta;
-    BtreeNode_t *root = NULL;
-    off_t *value;
-    int count, gi;
-    count = 0;
-    off_t pos = 0;
+int CreateFastaFaiToFile(FILE *fd, FILE *fo, int verbose) {
+    FastaReader_t *reader;
+    FastaIndexEntry_t entry;
+    int count = 0;
 
     if (verbose) {
         printf("Creating the fasta index\n");
         fflush(stdout);
     }
-    while ((fasta = ReadFasta(fd, 1)) != NULL) {
-        value = malloc(sizeof (off_t));
-        fasta->getGi(fasta, &gi);
-        if (verbose) {
+    reader = CreateFastaReader(fd);
+    while (FastaReaderNextIndex(reader, &entry)) {
+        if (verbose && count % FASTA_INDEX_PROGRESS == 0) {
             printf("Total: %10d \r", count);
             fflush(stdout);
         }
-        *value = pos;
-        root = BtreeInsert(root, gi, value);
-        fasta->free(fasta);
-        pos = ftello(fd);
+        fprintf(fo, "%.*s\t%lld\t%lld\t%d\t%d\n", (int) strcspn(entry.header, " \t"), entry.header,
+                entry.length, (long long int) entry.seqOffset, entry.lineBases, entry.lineWidth);
         count++;
     }
+    FreeFastaReader(reader);
     if (verbose) {
         printf("Total: %10d \n", count);
         fflush(stdout);
     }
-    return root;
+    return count;
+}
+
+/**
+ * Create a Btree index which include the gi and the offset position
+ * 
+ * @param fd the input fasta file
+ * @param verbose 1 to print info
+ * @return the Btree index
+ */
+BtreeNode_t * CreateBtreeFromFasta(FILE *fd, int verbose) {
+    return CreateBtreeFromFastawithPattern(fd, NULL, verbose);
 }
 
 /**
@@ -645,8 +1642,10 @@ BtreeNode_t * CreateBtreeFromFastaGzip(gzFile fd, int verbose) {
     fasta_l fasta;
     BtreeNode_t *root = NULL;
     off_t *value;
-    int count, gi;
-    count = 0;
+    int count, gi, capacity;
+    int *keys = NULL;
+    void **values = NULL;
+    count = capacity = 0;
     off_t pos = 0;
 
     if (verbose) {
@@ -661,11 +1660,13 @@ BtreeNode_t * CreateBtreeFromFastaGzip(gzFile fd, int verbose) {
             fflush(stdout);
         }
         *value = pos;
-        root = BtreeInsert(root, gi, value);
+        BtreeBulkAppend(&keys, &values, &count, &capacity, gi, value);
         fasta->free(fasta);
         pos = gztell(fd);
-        count++;
     }
+    root = BtreeBulkLoad(keys, values, count);
+    if (keys) free(keys);
+    if (values) free(values);
     if (verbose) {
         printf("Total: %10d \n", count);
         fflush(stdout);
@@ -687,7 +1688,9 @@ BtreeNode_t *CreateBtreeFromIndex(FILE *fi, int verbose) {
     off_t pos;
     off_t *value;
     int gi;
-    int count = 0;
+    int count = 0, capacity = 0;
+    int *keys = NULL;
+    void **values = NULL;
 
     clock_gettime(CLOCK_MONOTONIC, &start);
     fseeko(fi, 0, SEEK_END);
@@ -700,10 +1703,12 @@ BtreeNode_t *CreateBtreeFromIndex(FILE *fi, int verbose) {
         fread(&gi, sizeof (int), 1, fi);
         fread(value, sizeof (off_t), 1, fi);
 
-        root = BtreeInsert(root, gi, value);
-        pos = ftell(fi);
-        count++;
+        BtreeBulkAppend(&keys, &values, &count, &capacity, gi, value);
+        pos = ftello(fi);
     }
+    root = BtreeBulkLoad(keys, values, count);
+    if (keys) free(keys);
+    if (values) free(values);
     clock_gettime(CLOCK_MONOTONIC, &stop);
     if (verbose)
         printf("\n\tThere are %d GIs into the B+Tree. Elapsed time: %.2f sec\n\n", count, timespecDiffSec(&stop, &start));
@@ -720,34 +1725,34 @@ BtreeNode_t *CreateBtreeFromIndex(FILE *fi, int verbose) {
  * @return the Btree index
  */
 BtreeNode_t * CreateBtreeFromFastawithPattern(FILE *fd, char *giPattern, int verbose) {
-    fasta_l fasta;
+    FastaReader_t *reader;
+    FastaIndexEntry_t entry;
     BtreeNode_t *root = NULL;
     off_t *value;
-    int count, gi;
-    count = 0;
-    off_t pos = 0;
+    int count, gi, capacity;
+    int *keys = NULL;
+    void **values = NULL;
+    count = capacity = 0;
 
     if (verbose) {
         printf("Creating the fasta index\n");
         fflush(stdout);
     }
-    while ((fasta = ReadFasta(fd, 1)) != NULL) {
+    reader = CreateFastaReader(fd);
+    while (FastaReaderNextIndex(reader, &entry)) {
         value = malloc(sizeof (off_t));
-        if (giPattern){
-            sscanf(fasta->header, giPattern, &gi);
-        }else{
-            fasta->getGi(fasta, &gi);
-        }
-        if (verbose) {
+        gi = pattern_gi(entry.header, giPattern);
+        if (verbose && count % FASTA_INDEX_PROGRESS == 0) {
             printf("Total: %10d \r", count);
             fflush(stdout);
         }
-        *value = pos;
-        root = BtreeInsert(root, gi, value);
-        fasta->free(fasta);
-        pos = ftello(fd);
-        count++;
+        *value = entry.offset;
+        BtreeBulkAppend(&keys, &values, &count, &capacity, gi, value);
     }
+    FreeFastaReader(reader);
+    root = BtreeBulkLoad(keys, values, count);
+    if (keys) free(keys);
+    if (values) free(values);
     if (verbose) {
         printf("Total: %10d \n", count);
         fflush(stdout);
@@ -755,3 +1760,214 @@ BtreeNode_t * CreateBtreeFromFastawithPattern(FILE *fd, char *giPattern, int ver
     return root;
 }
 
+/*
+ * Order of the pairs by Gi and then by offset, so duplicated Gis keep 
+ * the file order
+ */
+int compare_fasta_index_pair(const void *a, const void *b) {
+    const fasta_index_pair_t *x = (const fasta_index_pair_t *) a, *y = (const fasta_index_pair_t *) b;
+    if (x->gi != y->gi) return (x->gi < y->gi) ? -1 : 1;
+    return (x->offset < y->offset) ? -1 : (x->offset > y->offset);
+}
+
+/*
+ * Thread function: index the entries of a range of the fasta file and 
+ * sort them by Gi
+ */
+void *index_fasta_chunk(void *arg) {
+    fasta_index_chunk_t *chunk = (fasta_index_chunk_t *) arg;
+    FastaReader_t *reader;
+    FastaIndexEntry_t entry;
+    FILE *fd = checkPointerError(fopen(chunk->filename, "r"), "Can't open input file", __FILE__, __LINE__, -1);
+
+    /* The range starts at the first header after start */
+    fseeko(fd, (chunk->start > 0) ? chunk->start - 1 : 0, SEEK_SET);
+    reader = CreateFastaReader(fd);
+    if (chunk->start == 0 || sync_fasta_reader(reader)) {
+        while (FastaReaderTell(reader) < chunk->end && FastaReaderNextIndex(reader, &entry)) {
+            if (entry.offset >= chunk->end) break;
+            if (chunk->count == chunk->capacity) {
+                chunk->capacity = (chunk->capacity == 0) ? 1 << 16 : chunk->capacity * 2;
+                chunk->pairs = reallocate(chunk->pairs, sizeof (fasta_index_pair_t) * chunk->capacity, __FILE__, __LINE__);
+            }
+            chunk->pairs[chunk->count].gi = pattern_gi(entry.header, chunk->giPattern);
+            chunk->pairs[chunk->count].offset = entry.offset;
+            chunk->count++;
+        }
+    }
+    FreeFastaReader(reader);
+    fclose(fd);
+    qsort(chunk->pairs, chunk->count, sizeof (fasta_index_pair_t), compare_fasta_index_pair);
+    return NULL;
+}
+
+/*
+ * Order of the ranges in the merge heap by their next Gi and then by the
+ * range number, so on ties the first range wins
+ */
+int fasta_index_heap_less(fasta_index_chunk_t *chunks, int *pos, int a, int b) {
+    int x = chunks[a].pairs[pos[a]].gi, y = chunks[b].pairs[pos[b]].gi;
+    return x < y || (x == y && a < b);
+}
+
+/*
+ * Move down the range at position i of the merge heap
+ */
+void fasta_index_heap_down(fasta_index_chunk_t *chunks, int *pos, int *heap, int size, int i) {
+    int child, tmp;
+
+    while ((child = 2 * i + 1) < size) {
+        if (child + 1 < size && fasta_index_heap_less(chunks, pos, heap[child + 1], heap[child])) child++;
+        if (!fasta_index_heap_less(chunks, pos, heap[child], heap[i])) break;
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
+
+/**
+ * Index a fasta file with threads. The file is split in byte ranges, each
+ * range starts at its first header and is indexed by a thread, and the 
+ * sorted ranges are merged. The Gis are returned sorted, duplicated Gis 
+ * are kept in file order
+ * 
+ * @param filename the input fasta file (not compressed)
+ * @param giPattern pattern to extract the gi from the fasta header. If null use default fasta header
+ * @param threads the number of threads (0 to use all the processors)
+ * @param rangeMin minimum size in bytes of the range of a thread (0 for FASTA_INDEX_CHUNK_MIN)
+ * @param gis returns the sorted Gis
+ * @param offsets returns the offset of the fasta entry of each Gi
+ * @param verbose 1 to print info
+ * @return the number of entries
+ */
+int FastaIndexParallel(char *filename, char *giPattern, int threads, off_t rangeMin, int **gis, off_t **offsets, int verbose) {
+    struct timespec start, stop;
+    fasta_index_chunk_t *chunks;
+    pthread_t *tids;
+    struct stat st;
+    size_t total;
+    int i, n, best, size, *pos, *heap;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (stat(filename, &st) != 0) {
+        checkPointerError(NULL, "Can't open input file", __FILE__, __LINE__, -1);
+    }
+    if (threads <= 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    if (rangeMin <= 0) rangeMin = FASTA_INDEX_CHUNK_MIN;
+    if (threads > st.st_size / rangeMin + 1) threads = st.st_size / rangeMin + 1;
+
+    chunks = allocate(sizeof (fasta_index_chunk_t) * threads, __FILE__, __LINE__);
+    tids = allocate(sizeof (pthread_t) * threads, __FILE__, __LINE__);
+    memset(chunks, 0, sizeof (fasta_index_chunk_t) * threads);
+    for (i = 0; i < threads; i++) {
+        chunks[i].filename = filename;
+        chunks[i].giPattern = giPattern;
+        chunks[i].start = (st.st_size / threads) * i;
+        chunks[i].end = (i == threads - 1) ? st.st_size : (st.st_size / threads) * (i + 1);
+        if (pthread_create(&tids[i], NULL, index_fasta_chunk, &chunks[i]) != 0) {
+            checkPointerError(NULL, "Can't create the index thread", __FILE__, __LINE__, -1);
+        }
+    }
+    total = 0;
+    for (i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        total += chunks[i].count;
+    }
+    free(tids);
+    if (total > INT32_MAX) {
+        checkPointerError(NULL, "Too many entries in the fasta file", __FILE__, __LINE__, -1);
+    }
+
+    /* Merge the sorted ranges, on ties the first range wins */
+    *gis = allocate(sizeof (int) * (total + 1), __FILE__, __LINE__);
+    *offsets = allocate(sizeof (off_t) * (total + 1), __FILE__, __LINE__);
+    pos = allocate(sizeof (int) * threads, __FILE__, __LINE__);
+    heap = allocate(sizeof (int) * threads, __FILE__, __LINE__);
+    memset(pos, 0, sizeof (int) * threads);
+    size = 0;
+    for (i = 0; i < threads; i++) {
+        if (chunks[i].count > 0) heap[size++] = i;
+    }
+    for (i = size / 2 - 1; i >= 0; i--) {
+        fasta_index_heap_down(chunks, pos, heap, size, i);
+    }
+    n = 0;
+    while (size > 0) {
+        best = heap[0];
+        (*gis)[n] = chunks[best].pairs[pos[best]].gi;
+        (*offsets)[n++] = chunks[best].pairs[pos[best]].offset;
+        if (++pos[best] == chunks[best].count) heap[0] = heap[--size];
+        fasta_index_heap_down(chunks, pos, heap, size, 0);
+    }
+    free(heap);
+    free(pos);
+    for (i = 0; i < threads; i++) {
+        if (chunks[i].pairs) free(chunks[i].pairs);
+    }
+    free(chunks);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    if (verbose) {
+        printf("Total: %10d entries indexed by %d threads in %.2f sec\n", n, threads, timespecDiffSec(&stop, &start));
+        fflush(stdout);
+    }
+    return n;
+}
+
+/**
+ * Create a fasta binary index file which include the gi and the offset 
+ * position using threads. The records are sorted by Gi
+ * 
+ * @param filename the input fasta file (not compressed)
+ * @param fo the output binary file
+ * @param threads the number of threads (0 to use all the processors)
+ * @param verbose 1 to print info
+ * @return the number of elements read
+ */
+int CreateFastaIndexToFileParallel(char *filename, FILE *fo, int threads, int verbose) {
+    int i, count;
+    int *gis;
+    off_t *offsets;
+
+    count = FastaIndexParallel(filename, NULL, threads, 0, &gis, &offsets, verbose);
+    for (i = 0; i < count; i++) {
+        fwrite(&(gis[i]), sizeof (int), 1, fo);
+        fwrite(&(offsets[i]), sizeof (off_t), 1, fo);
+    }
+    free(gis);
+    free(offsets);
+    return count;
+}
+
+/**
+ * Create a Btree index which include the gi and the offset position 
+ * using threads
+ * 
+ * @param filename the input fasta file (not compressed)
+ * @param threads the number of threads (0 to use all the processors)
+ * @param verbose 1 to print info
+ * @return the Btree index
+ */
+BtreeNode_t * CreateBtreeFromFastaParallel(char *filename, int threads, int verbose) {
+    BtreeNode_t *root;
+    int i, n, count;
+    int *gis;
+    off_t *offsets;
+    void **values;
+
+    count = FastaIndexParallel(filename, NULL, threads, 0, &gis, &offsets, verbose);
+    values = allocate(sizeof (void *) * (count + 1), __FILE__, __LINE__);
+    /* Only the first entry of a duplicated Gi goes to the tree */
+    for (i = n = 0; i < count; i++) {
+        if (n > 0 && gis[n - 1] == gis[i]) continue;
+        gis[n] = gis[i];
+        values[n] = allocate(sizeof (off_t), __FILE__, __LINE__);
+        *((off_t *) values[n++]) = offsets[i];
+    }
+    root = BtreeBulkLoad(gis, values, n);
+    free(gis);
+    free(offsets);
+    free(values);
+    return root;
+}
@@ -0,0 +1,457 @@
+/*
+ * File:   gitaxmap.c
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 11:15 PM
+ */
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "btree.h"
+#include "btime.h"
+#include "berror.h"
+#include "bmemory.h"
+#include "taxonomy.h"
+#include "gitaxmap.h"
+
+/* Number of Gis searched together by GiTaxMapFindBatch */
+#define GITAXMAP_BATCH 16
+
+/*
+ * Number of words of an array of count packed values of bits bits. There
+ * is an extra word so a value can always be read from two words
+ */
+uint64_t packed_words(uint64_t count, unsigned int bits) {
+    return (count * bits + 63) / 64 + 1;
+}
+
+uint64_t packed_get(const uint64_t *words, uint64_t i, unsigned int bits) {
+    uint64_t pos, value;
+    unsigned int shift;
+
+    if (bits == 0) return 0;
+    pos = i * bits;
+    shift = pos & 63;
+    value = words[pos >> 6] >> shift;
+    if (shift + bits > 64) value |= words[(pos >> 6) + 1] << (64 - shift);
+    return value & (((uint64_t) 1 << bits) - 1);
+}
+
+/*
+ * The words have to be zero before the first set
+ */
+void packed_set(uint64_t *words, uint64_t i, unsigned int bits, uint64_t value) {
+    uint64_t pos;
+    unsigned int shift;
+
+    if (bits == 0) return;
+    pos = i * bits;
+    shift = pos & 63;
+    words[pos >> 6] |= value << shift;
+    if (shift + bits > 64) words[(pos >> 6) + 1] |= value >> (64 - shift);
+}
+
+/*
+ * Position of the k-th (from 0) set bit of the word
+ */
+static int select_in_word(uint64_t x, int k) {
+    int shift = 0, c;
+
+    while ((c = __builtin_popcountll(x & 0xFF)) <= k) {
+        k -= c;
+        x >>= 8;
+        shift += 8;
+    }
+    while (k-- > 0) x &= x - 1;
+    return shift + __builtin_ctzll(x);
+}
+
+/*
+ * Set the array pointers of the map from its header
+ */
+void gitaxmap_layout(GiTaxMap_t *map) {
+    GiTaxMapHeader_t *header = map->header = (GiTaxMapHeader_t *) map->map;
+
+    map->low = (uint64_t *) ((char *) map->map + sizeof (GiTaxMapHeader_t));
+    map->upper = map->low + packed_words(header->count, header->lowBits);
+    map->samples = map->upper + packed_words(header->upperBits, 1);
+    map->taxIds = map->samples + header->samples;
+}
+
+/*
+ * Size in bytes of a map with the header values
+ */
+uint64_t gitaxmap_size(GiTaxMapHeader_t *header) {
+    return sizeof (GiTaxMapHeader_t) + sizeof (uint64_t) * (packed_words(header->count, header->lowBits)
+            + packed_words(header->upperBits, 1) + header->samples
+            + packed_words(header->count, header->taxIdBits));
+}
+
+/*
+ * Position in the high bits of the zero number rank (from 0)
+ */
+static uint64_t gitaxmap_select0(GiTaxMap_t *map, uint64_t rank) {
+    uint64_t j = rank / GITAXMAP_SAMPLE, pos = map->samples[j], w = pos >> 6, x;
+    int k = rank - j * GITAXMAP_SAMPLE, c;
+
+    x = ~map->upper[w] & (~(uint64_t) 0 << (pos & 63));
+    while ((c = __builtin_popcountll(x)) <= k) {
+        k -= c;
+        x = ~map->upper[++w];
+    }
+    return w * 64 + select_in_word(x, k);
+}
+
+/*
+ * Position in the high bits of the first Gi with the high part
+ */
+static uint64_t gitaxmap_bucket(GiTaxMap_t *map, uint64_t high) {
+    return (high == 0) ? 0 : gitaxmap_select0(map, high - 1) + 1;
+}
+
+/*
+ * Search the low part in the keys of the bucket that starts at pos and
+ * return the index of the key or -1
+ */
+static int64_t gitaxmap_scan(GiTaxMap_t *map, uint64_t pos, uint64_t high, uint64_t low) {
+    uint64_t i = pos - high, value;
+    unsigned int lowBits = map->header->lowBits;
+
+    while ((map->upper[pos >> 6] >> (pos & 63)) & 1) {
+        value = packed_get(map->low, i, lowBits);
+        if (value == low) return i;
+        if (value > low) break;
+        pos++;
+        i++;
+    }
+    return -1;
+}
+
+/*
+ * The key i, from the Gis or from the 64 bits keys
+ */
+static uint64_t gitaxmap_key(const int *gis, const uint64_t *keys, uint64_t i) {
+    return (gis != NULL) ? (uint64_t) gis[i] : keys[i];
+}
+
+/*
+ * Build the map of the count keys from first (see GiTaxMapCreate64)
+ */
+static GiTaxMap_t *gitaxmap_create(const int *gis, const uint64_t *keys, int *taxIds, uint64_t first, uint64_t count) {
+    GiTaxMap_t *map = allocate(sizeof (GiTaxMap_t), __FILE__, __LINE__);
+    GiTaxMapHeader_t header;
+    uint64_t i, n, w, x, key, words, zeros, next, high;
+    int maxTaxId = 0, c;
+
+    n = count - first;
+    memset(&header, 0, sizeof (GiTaxMapHeader_t));
+    memcpy(header.magic, GITAXMAP_MAGIC, sizeof (GITAXMAP_MAGIC));
+    header.version = GITAXMAP_VERSION;
+    header.count = n;
+    header.maxKey = (n > 0) ? gitaxmap_key(gis, keys, count - 1) : 0;
+    /* About 2 high bits per key */
+    while (n > 0 && header.lowBits < 63 && (header.maxKey >> (header.lowBits + 1)) >= n) header.lowBits++;
+    for (i = first; i < count; i++) {
+        if (taxIds[i] > maxTaxId) maxTaxId = taxIds[i];
+    }
+    while (header.taxIdBits < 31 && ((int64_t) 1 << header.taxIdBits) <= maxTaxId) header.taxIdBits++;
+    zeros = (n > 0) ? (header.maxKey >> header.lowBits) + 1 : 0;
+    header.upperBits = n + zeros;
+    header.samples = (zeros + GITAXMAP_SAMPLE - 1) / GITAXMAP_SAMPLE;
+    header.size = gitaxmap_size(&header);
+
+    map->size = header.size;
+    map->mapped = 0;
+    map->map = checkPointerError(calloc(map->size, 1), "Can't allocate memory", __FILE__, __LINE__, -1);
+    memcpy(map->map, &header, sizeof (GiTaxMapHeader_t));
+    gitaxmap_layout(map);
+
+    for (i = 0; i < n; i++) {
+        key = gitaxmap_key(gis, keys, first + i);
+        high = key >> header.lowBits;
+        packed_set(map->low, i, header.lowBits, key & (((uint64_t) 1 << header.lowBits) - 1));
+        map->upper[(high + i) >> 6] |= (uint64_t) 1 << ((high + i) & 63);
+        packed_set(map->taxIds, i, header.taxIdBits, (taxIds[first + i] > 0) ? taxIds[first + i] : 0);
+    }
+
+    /* The position of every GITAXMAP_SAMPLE-th zero of the high bits */
+    words = (header.upperBits + 63) / 64;
+    for (w = 0, zeros = 0, next = 0; w < words && next < header.samples; w++) {
+        x = ~map->upper[w];
+        if (w == words - 1 && header.upperBits % 64 != 0) x &= ((uint64_t) 1 << (header.upperBits % 64)) - 1;
+        c = __builtin_popcountll(x);
+        while (next < header.samples && next * GITAXMAP_SAMPLE < zeros + c) {
+            map->samples[next] = w * 64 + select_in_word(x, next * GITAXMAP_SAMPLE - zeros);
+            next++;
+        }
+        zeros += c;
+    }
+    return map;
+}
+
+/*
+ * Index of the key in the map or -1
+ */
+int64_t gitaxmap_find_index(GiTaxMap_t *map, uint64_t key) {
+    unsigned int lowBits = map->header->lowBits;
+    uint64_t high;
+
+    if (map->header->count == 0 || key > map->header->maxKey) return -1;
+    high = key >> lowBits;
+    return gitaxmap_scan(map, gitaxmap_bucket(map, high), high, key & (((uint64_t) 1 << lowBits) - 1));
+}
+
+/*
+ * Find the taxIds of the keys (see GiTaxMapFindBatch). If indexes is not
+ * NULL it returns the index of each key or -1
+ */
+void gitaxmap_find_batch(GiTaxMap_t *map, const int *gis, const uint64_t *keys, int n, int *taxIds, int64_t *indexes) {
+    int64_t index;
+    unsigned int lowBits = map->header->lowBits;
+    uint64_t key[GITAXMAP_BATCH], high[GITAXMAP_BATCH], pos[GITAXMAP_BATCH], sample, bit;
+    int i, j, m;
+
+    for (i = 0; i < n; i += GITAXMAP_BATCH) {
+        m = (n - i < GITAXMAP_BATCH) ? n - i : GITAXMAP_BATCH;
+        /* The zero samples */
+        for (j = 0; j < m; j++) {
+            key[j] = gitaxmap_key(gis, keys, i + j);
+            if ((gis != NULL && gis[i + j] < 0) || map->header->count == 0 || key[j] > map->header->maxKey) {
+                taxIds[i + j] = -1;
+                continue;
+            }
+            taxIds[i + j] = 0;
+            high[j] = key[j] >> lowBits;
+            if (high[j] > 0) __builtin_prefetch(&map->samples[(high[j] - 1) / GITAXMAP_SAMPLE], 0, 1);
+        }
+        /* The high bits words after the samples */
+        for (j = 0; j < m; j++) {
+            if (taxIds[i + j] == -1 || high[j] == 0) continue;
+            sample = map->samples[(high[j] - 1) / GITAXMAP_SAMPLE];
+            __builtin_prefetch(&map->upper[sample >> 6], 0, 1);
+        }
+        /* The buckets, then the low bits and taxIds of their first key */
+        for (j = 0; j < m; j++) {
+            if (taxIds[i + j] == -1) continue;
+            pos[j] = gitaxmap_bucket(map, high[j]);
+            bit = (pos[j] - high[j]) * lowBits;
+            __builtin_prefetch(&map->low[bit >> 6], 0, 1);
+            bit = (pos[j] - high[j]) * map->header->taxIdBits;
+            __builtin_prefetch(&map->taxIds[bit >> 6], 0, 1);
+        }
+        for (j = 0; j < m; j++) {
+            index = -1;
+            if (taxIds[i + j] != -1) {
+                index = gitaxmap_scan(map, pos[j], high[j], key[j] & (((uint64_t) 1 << lowBits) - 1));
+                taxIds[i + j] = (index < 0) ? -1 : (int) packed_get(map->taxIds, index, map->header->taxIdBits);
+            }
+            if (indexes) indexes[i + j] = index;
+        }
+    }
+}
+
+/**
+ * Build a map in memory. The negative Gis are not included
+ *
+ * @param gis the Gis sorted and without repetitions
+ * @param taxIds the taxId of each Gi
+ * @param count the number of Gis
+ * @return the map
+ */
+GiTaxMap_t *GiTaxMapCreate(int *gis, int *taxIds, int count) {
+    int first = 0;
+
+    while (first < count && gis[first] < 0) first++;
+    return gitaxmap_create(gis, NULL, taxIds, first, count);
+}
+
+/**
+ * Build a map in memory with 64 bits keys
+ *
+ * @param keys the keys sorted and without repetitions
+ * @param taxIds the taxId of each key
+ * @param count the number of keys
+ * @return the map
+ */
+GiTaxMap_t *GiTaxMapCreate64(uint64_t *keys, int *taxIds, uint64_t count) {
+    return gitaxmap_create(NULL, keys, taxIds, 0, count);
+}
+
+/**
+ * Read the gi_taxid_nucl.dmp file (see TaxonomyNuclLoad) into a map
+ *
+ * @param gi_taxid_nucl the gi_taxid_nucl.dmp complete path
+ * @param threads the number of threads (0 to use all the processors)
+ * @param verbose 1 to print a verbose info
+ * @return the map
+ */
+GiTaxMap_t *GiTaxMapLoad(char *gi_taxid_nucl, int threads, int verbose) {
+    struct timespec start, stop;
+    GiTaxMap_t *map;
+    int count, *gis, *taxIds;
+
+    if (verbose) printf("\n");
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    count = TaxonomyNuclLoad(gi_taxid_nucl, threads, &gis, &taxIds, verbose);
+    map = GiTaxMapCreate(gis, taxIds, count);
+    free(gis);
+    free(taxIds);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    if (verbose) {
+        printf("\n\tThere are %d GIs into the map (%.2f bytes per GI). Elapsed time: %.2f sec\n\n",
+                count, (count > 0) ? (double) map->size / count : 0.0, timespecDiffSec(&stop, &start));
+    }
+    fflush(NULL);
+    return map;
+}
+
+/**
+ * Write the map to a file
+ *
+ * @param map the map
+ * @param name the file name
+ */
+void GiTaxMapWrite(GiTaxMap_t *map, char *name) {
+    FILE *fo = checkPointerError(fopen(name, "wb"), "Can't open the GI map file", __FILE__, __LINE__, -1);
+
+    if (fwrite(map->map, 1, map->size, fo) != map->size || fclose(fo) != 0) {
+        checkPointerError(NULL, "Can't write the GI map file", __FILE__, __LINE__, -1);
+    }
+}
+
+/**
+ * Check if the file is a Gi to taxId map
+ *
+ * @param name the file name
+ * @return 1 if the file starts with the map magic number, 0 otherwise
+ */
+int GiTaxMapCheck(char *name) {
+    char magic[sizeof (GITAXMAP_MAGIC)];
+    FILE *fd;
+    int isMap = 0;
+
+    if ((fd = fopen(name, "rb")) != NULL) {
+        if (fread(magic, sizeof (magic), 1, fd) == 1) {
+            isMap = (memcmp(magic, GITAXMAP_MAGIC, sizeof (magic)) == 0);
+        }
+        fclose(fd);
+    }
+    return isMap;
+}
+
+/**
+ * Map a Gi to taxId map file read-only. The program exits if the file
+ * is not a valid map
+ *
+ * @param name the file name
+ * @return the map
+ */
+GiTaxMap_t *GiTaxMapOpen(char *name) {
+    GiTaxMap_t *map;
+    GiTaxMapHeader_t *header;
+    struct stat st;
+    int fd;
+
+    if ((fd = open(name, O_RDONLY)) == -1 || fstat(fd, &st) == -1) {
+        checkPointerError(NULL, "Can't open the GI map file", __FILE__, __LINE__, -1);
+    }
+    if (st.st_size < (off_t) sizeof (GiTaxMapHeader_t)) {
+        checkPointerError(NULL, "The file is not a GI map", __FILE__, __LINE__, -1);
+    }
+    map = allocate(sizeof (GiTaxMap_t), __FILE__, __LINE__);
+    map->size = st.st_size;
+    map->mapped = 1;
+    map->map = mmap(NULL, map->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map->map == MAP_FAILED) {
+        checkPointerError(NULL, "Can't map the GI map file", __FILE__, __LINE__, -1);
+    }
+    madvise(map->map, map->size, MADV_RANDOM);
+
+    header = (GiTaxMapHeader_t *) map->map;
+    if (memcmp(header->magic, GITAXMAP_MAGIC, sizeof (GITAXMAP_MAGIC)) != 0
+            || header->version != GITAXMAP_VERSION) {
+        checkPointerError(NULL, "The file is not a GI map", __FILE__, __LINE__, -1);
+    }
+    if (header->size != map->size || gitaxmap_size(header) != map->size
+            || header->lowBits > 63 || header->taxIdBits > 31) {
+        checkPointerError(NULL, "The GI map file is truncated or corrupted", __FILE__, __LINE__, -1);
+    }
+    gitaxmap_layout(map);
+    return map;
+}
+
+/**
+ * Find the taxId of a Gi
+ *
+ * @param map the map
+ * @param gi the Gi
+ * @return the taxId or -1 if the Gi is not in the map
+ */
+int GiTaxMapFind(GiTaxMap_t *map, int gi) {
+    return (gi < 0) ? -1 : GiTaxMapFind64(map, gi);
+}
+
+/**
+ * Find the taxId of a 64 bits key
+ *
+ * @param map the map
+ * @param key the key
+ * @return the taxId or -1 if the key is not in the map
+ */
+int GiTaxMapFind64(GiTaxMap_t *map, uint64_t key) {
+    int64_t index = gitaxmap_find_index(map, key);
+
+    return (index < 0) ? -1 : (int) packed_get(map->taxIds, index, map->header->taxIdBits);
+}
+
+/**
+ * Find the taxIds of many Gis at once. The Gis are searched in groups
+ * and the memory of each step is prefetched for the whole group, so
+ * the accesses of the different Gis overlap. The results are the same
+ * that GiTaxMapFind returns for each Gi
+ *
+ * @param map the map
+ * @param gis the Gis
+ * @param n the number of Gis
+ * @param taxIds array of n elements with the taxId of each Gi or -1
+ */
+void GiTaxMapFindBatch(GiTaxMap_t *map, int *gis, int n, int *taxIds) {
+    gitaxmap_find_batch(map, gis, NULL, n, taxIds, NULL);
+}
+
+/**
+ * Find the taxIds of many 64 bits keys at once (see GiTaxMapFindBatch)
+ *
+ * @param map the map
+ * @param keys the keys
+ * @param n the number of keys
+ * @param taxIds array of n elements with the taxId of each key or -1
+ */
+void GiTaxMapFindBatch64(GiTaxMap_t *map, uint64_t *keys, int n, int *taxIds) {
+    gitaxmap_find_batch(map, NULL, keys, n, taxIds, NULL);
+}
+
+/**
+ * Free the map (unmap the file)
+ *
+ * @param map the map
+ */
+void GiTaxMapFree(GiTaxMap_t *map) {
+    if (map) {
+        if (map->mapped) {
+            munmap(map->map, map->size);
+        } else {
+            free(map->map);
+        }
+        free(map);
+    }
+}
@@ -10,13 +10,17 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <zlib.h>
 #include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "bmemory.h"
 #include "bstring.h"
 #include "berror.h"
 #include "btree.h"
 #include "btime.h"
+#include "bzreader.h"
 #include "taxonomy.h"
 
 /**
@@ -146,6 +150,27 @@ taxonomy_l CreateTaxonomy() {
     return tax;
 }
 
+/*
+ * Split a .dmp line in place. The fields are separated by "\t|\t" and
+ * the line ends with "\t|". Returns the number of fields found
+ */
+int split_dmp_line(char *line, char **fields, int max) {
+    int n = 0;
+    char *p = line, *end;
+
+    while (n < max && *p != '\0' && *p != '\n') {
+        fields[n++] = p;
+        if ((end = strstr(p, "\t|")) == NULL) {
+            p[strcspn(p, "\n")] = '\0';
+            break;
+        }
+        *end = '\0';
+        p = end + 2;
+        if (*p == '\t') p++;
+    }
+    return n;
+}
+
 /**
  * Read a taxonomy entry from the files
  * 
@@ -160,29 +185,23 @@ taxonomy_l ReadTaxonomy(FILE *nodes, FILE *names) {
     size_t len = 0;
     ssize_t read;
     off_t pos = 0;
-    char **ids;
-    int ids_number;
+    char *fields[4];
 
     if (getline(&line, &len, nodes) != -1) {
         self = CreateTaxonomy();
-        ids_number = splitString(&ids, line, "\t|");
-        if (ids_number < 3) {
-            fprintf(stderr, "LINE: %s", line);
-            fprintf(stderr, "ids number: %d\n", ids_number);
+        if (split_dmp_line(line, fields, 3) < 3) {
+            fprintf(stderr, "LINE: %s\n", line);
             checkPointerError(NULL, "Can't parse the nodes.dmp file", __FILE__, __LINE__, -1);
         }
-        self->setTaxId(self, atoi(ids[0]));
-        self->setParentTaxId(self, atoi(ids[1]));
-        self->setRank(self, ids[2]);
+        self->setTaxId(self, atoi(fields[0]));
+        self->setParentTaxId(self, atoi(fields[1]));
+        self->setRank(self, fields[2]);
 
-        freeArrayofPointers((void **) ids, ids_number);
         while ((read = getline(&line, &len, names)) != -1) {
             i = atoi(line);
             if (i == self->taxId) {
-                if (strstr(line, "scientific name") != NULL) {
-                    ids_number = splitString(&ids, line, "\t|");
-                    self->setName(self, ids[1]);
-                    freeArrayofPointers((void **) ids, ids_number);
+                if (split_dmp_line(line, fields, 4) == 4 && strcmp(fields[3], "scientific name") == 0) {
+                    self->setName(self, fields[1]);
                 }
             }
             if (i > self->taxId) {
@@ -205,42 +224,325 @@ taxonomy_l ReadTaxonomy(FILE *nodes, FILE *names) {
  * @return the NCBI Taxonomy db in a Btree index
  */
 BtreeNode_t *TaxonomyDBIndex(char *dir, int verbose) {
-    struct timespec stop, mid;
-    char *tmp;
-    FILE *nodes, *names;
+    TaxonomyTable_t *table;
     BtreeNode_t *root = NULL;
     taxonomy_l tax;
+    int *keys = NULL;
+    void **values = NULL;
+    int taxId, count = 0, capacity = 0;
 
-    clock_gettime(CLOCK_MONOTONIC, &mid);
-    if (verbose) {
-        printf("Reading the Taxonomy database ... ");
-        fflush(stdout);
+    table = TaxonomyTableLoad(dir, 0, verbose);
+    for (taxId = 1; taxId <= table->maxTaxId; taxId++) {
+        if (!TaxonomyTableContains(table, taxId)) continue;
+        tax = CreateTaxonomy();
+        tax->setTaxId(tax, taxId);
+        tax->setParentTaxId(tax, table->nodes[taxId].parentTaxId);
+        tax->setRank(tax, TaxonomyTableRank(table, taxId));
+        if (TaxonomyTableName(table, taxId) != NULL) {
+            tax->setName(tax, TaxonomyTableName(table, taxId));
+        }
+        BtreeBulkAppend(&keys, &values, &count, &capacity, taxId, tax);
     }
+    root = BtreeBulkLoad(keys, values, count);
+    if (keys) free(keys);
+    if (values) free(values);
+    TaxonomyTableFree(table);
+    return root;
+}
 
-    tmp = allocate(sizeof (char) * (strlen(dir) + 11), __FILE__, __LINE__);
-    sprintf(tmp, "%s/nodes.dmp", dir);
-    nodes = checkPointerError(fopen(tmp, "r"), "Can't open the nodes file", __FILE__, __LINE__, -1);
-    sprintf(tmp, "%s/names.dmp", dir);
-    names = checkPointerError(fopen(tmp, "r"), "Can't open the names file", __FILE__, __LINE__, -1);
+/* Minimum size of the gi_taxid file chunks parsed by a thread */
+#define NUCL_CHUNK_MIN (4 << 20)
 
-    while ((tax = ReadTaxonomy(nodes, names)) != NULL) {
-        root = BtreeInsert(root, tax->taxId, tax);
+/* 10^i for the numbers parsed in 8 digits steps */
+unsigned int ten_powers[9] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+/*
+ * Parse the decimal number at *p and move *p after it. While 8 bytes can
+ * be read before end the digits are found and combined 8 at a time in a
+ * 64 bits word (SWAR), otherwise one at a time
+ */
+unsigned int parse_number(char **p, char *end) {
+    unsigned int value = 0;
+    uint64_t word, nondigit;
+    int digits;
+
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (end - *p >= 8) {
+        memcpy(&word, *p, 8);
+        word ^= 0x3030303030303030ULL;
+        /* High bit set in the bytes that are not '0' to '9' */
+        nondigit = ((word + 0x7676767676767676ULL) | word) & 0x8080808080808080ULL;
+        digits = (nondigit == 0) ? 8 : __builtin_ctzll(nondigit) >> 3;
+        if (digits == 0) return value;
+        /* Align the digits to the top of the word so the missing ones are leading zeros */
+        if (digits < 8) word <<= (8 - digits) * 8;
+        word = ((word & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+        word = ((word & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+        word = ((word & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+        value = value * ten_powers[digits] + (unsigned int) word;
+        *p += digits;
+        if (digits < 8) return value;
+    }
+#endif
+    while (*p < end && (unsigned) (**p - '0') < 10) {
+        value = value * 10 + (**p - '0');
+        (*p)++;
     }
+    return value;
+}
 
-    fclose(nodes);
-    fclose(names);
-    free(tmp);
+/*
+ * A piece of the mapped gi_taxid file parsed by one thread
+ */
+typedef struct nucl_chunk_t {
+    char *start;
+    char *end;
+    char *mapEnd;
+    int *gis;
+    int *taxIds;
+    int count;
+    int capacity;
+    int sorted;
+} nucl_chunk_t;
+
+/*
+ * Order of the (gi, position) pairs used to sort a chunk keeping the
+ * file order of duplicated gis
+ */
+int compare_nucl_pair(const void *a, const void *b) {
+    const int *x = (const int *) a, *y = (const int *) b;
+    if (x[0] != y[0]) return (x[0] < y[0]) ? -1 : 1;
+    return (x[1] < y[1]) ? -1 : (x[1] > y[1]);
+}
+
+/*
+ * Parse the "gi\ttaxid" lines from start to end and append them to the
+ * chunk. The numbers may be read up to mapEnd
+ */
+void parse_nucl_lines(nucl_chunk_t *chunk, char *start, char *end, char *mapEnd) {
+    char *p = start, *lineEnd;
+
+    while (p < end) {
+        if ((lineEnd = memchr(p, '\n', end - p)) == NULL) lineEnd = end;
+        if (chunk->count == chunk->capacity) {
+            chunk->capacity = (chunk->capacity == 0) ? 1 << 16 : chunk->capacity * 2;
+            chunk->gis = reallocate(chunk->gis, sizeof (int) * chunk->capacity, __FILE__, __LINE__);
+            chunk->taxIds = reallocate(chunk->taxIds, sizeof (int) * chunk->capacity, __FILE__, __LINE__);
+        }
+        if ((unsigned) (*p - '0') < 10) {
+            chunk->gis[chunk->count] = parse_number(&p, mapEnd);
+            while (p < lineEnd && (unsigned) (*p - '0') >= 10) p++;
+            if (p < lineEnd) {
+                chunk->taxIds[chunk->count] = parse_number(&p, mapEnd);
+                if (chunk->count > 0 && chunk->gis[chunk->count - 1] >= chunk->gis[chunk->count]) chunk->sorted = 0;
+                chunk->count++;
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+/*
+ * Sort the chunk by gi if it is not sorted and remove the duplicated gis
+ * (the first one is kept)
+ */
+void sort_nucl_chunk(nucl_chunk_t *chunk) {
+    int i, n;
+    int *pairs, *gis, *taxIds;
+
+    if (chunk->sorted) return;
+    pairs = allocate(sizeof (int) * 2 * chunk->count, __FILE__, __LINE__);
+    for (i = 0; i < chunk->count; i++) {
+        pairs[2 * i] = chunk->gis[i];
+        pairs[2 * i + 1] = i;
+    }
+    qsort(pairs, chunk->count, sizeof (int) * 2, compare_nucl_pair);
+    gis = allocate(sizeof (int) * chunk->count, __FILE__, __LINE__);
+    taxIds = allocate(sizeof (int) * chunk->count, __FILE__, __LINE__);
+    for (i = n = 0; i < chunk->count; i++) {
+        if (n > 0 && gis[n - 1] == pairs[2 * i]) continue;
+        gis[n] = pairs[2 * i];
+        taxIds[n++] = chunk->taxIds[pairs[2 * i + 1]];
+    }
+    free(pairs);
+    free(chunk->gis);
+    free(chunk->taxIds);
+    chunk->gis = gis;
+    chunk->taxIds = taxIds;
+    chunk->count = chunk->capacity = n;
+    chunk->sorted = 1;
+}
+
+/*
+ * Thread function: parse and sort a chunk of the mapped file
+ */
+void *parse_nucl_chunk(void *arg) {
+    nucl_chunk_t *chunk = (nucl_chunk_t *) arg;
+    parse_nucl_lines(chunk, chunk->start, chunk->end, chunk->mapEnd);
+    sort_nucl_chunk(chunk);
+    return NULL;
+}
+
+/*
+ * Order of the chunks in the merge heap by their next Gi and then by the
+ * chunk number, so on ties the first chunk wins
+ */
+int nucl_heap_less(nucl_chunk_t *chunks, int *pos, int a, int b) {
+    int x = chunks[a].gis[pos[a]], y = chunks[b].gis[pos[b]];
+    return x < y || (x == y && a < b);
+}
+
+/*
+ * Move down the chunk at position i of the merge heap
+ */
+void nucl_heap_down(nucl_chunk_t *chunks, int *pos, int *heap, int size, int i) {
+    int child, tmp;
+
+    while ((child = 2 * i + 1) < size) {
+        if (child + 1 < size && nucl_heap_less(chunks, pos, heap[child + 1], heap[child])) child++;
+        if (!nucl_heap_less(chunks, pos, heap[child], heap[i])) break;
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
+
+/**
+ * Read the gi_taxid_nucl.dmp file from NCBI Taxonomy into two arrays 
+ * sorted by Gi. A plain file is mapped in memory and parsed in parallel,
+ * a gzip file is parsed while a background thread inflates it. If a Gi 
+ * is repeated the first line is kept
+ * 
+ * @param gi_taxid_nucl the gi_taxid_nucl.dmp complete path
+ * @param threads the number of threads (0 to use all the processors)
+ * @param gis returns the sorted Gis
+ * @param taxIds returns the taxId of each Gi
+ * @param verbose 1 to print a verbose info
+ * @return the number of Gis
+ */
+int TaxonomyNuclLoad(char *gi_taxid_nucl, int threads, int **gis, int **taxIds, int verbose) {
+    struct timespec start, stop;
+    nucl_chunk_t *chunks;
+    ZReader_t *reader;
+    pthread_t *tids;
+    char *map, *p, *cut, *end;
+    size_t size, total;
+    int i, j, n, best, concatenated, heapSize, *pos, *heap;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (threads <= 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+
+    if (isGzipFile(gi_taxid_nucl)) {
+        /* Compressed file: one parser fed by the inflate thread */
+        threads = 1;
+        chunks = allocate(sizeof (nucl_chunk_t), __FILE__, __LINE__);
+        memset(chunks, 0, sizeof (nucl_chunk_t));
+        chunks[0].sorted = 1;
+        reader = zreaderOpen(gi_taxid_nucl);
+        while ((p = zreaderLines(reader, &size)) != NULL) {
+            parse_nucl_lines(&chunks[0], p, p + size, p + size);
+        }
+        zreaderClose(reader);
+        sort_nucl_chunk(&chunks[0]);
+        map = NULL;
+        size = 0;
+    } else {
+        map = mapFile(gi_taxid_nucl, &size, __FILE__, __LINE__);
+        if ((size_t) threads > size / NUCL_CHUNK_MIN + 1) threads = size / NUCL_CHUNK_MIN + 1;
+        chunks = allocate(sizeof (nucl_chunk_t) * threads, __FILE__, __LINE__);
+        tids = allocate(sizeof (pthread_t) * threads, __FILE__, __LINE__);
+        memset(chunks, 0, sizeof (nucl_chunk_t) * threads);
+        p = map;
+        end = map + size;
+        for (i = 0; i < threads; i++) {
+            chunks[i].start = p;
+            cut = (i == threads - 1) ? end : map + (size / threads) * (i + 1);
+            if (cut < p) cut = p;
+            if (cut < end && (cut = memchr(cut, '\n', end - cut)) != NULL) {
+                p = cut + 1;
+            } else {
+                p = end;
+            }
+            chunks[i].end = p;
+            chunks[i].mapEnd = end;
+            chunks[i].sorted = 1;
+            if (pthread_create(&tids[i], NULL, parse_nucl_chunk, &chunks[i]) != 0) {
+                checkPointerError(NULL, "Can't create the parser thread", __FILE__, __LINE__, -1);
+            }
+        }
+        for (i = 0; i < threads; i++) {
+            pthread_join(tids[i], NULL);
+        }
+        free(tids);
+    }
+    total = 0;
+    for (i = 0; i < threads; i++) {
+        total += chunks[i].count;
+    }
+    if (total > INT32_MAX) {
+        checkPointerError(NULL, "Too many Gis in the gi_taxid file", __FILE__, __LINE__, -1);
+    }
+
+    /* The file is usually sorted so the chunks are just concatenated */
+    concatenated = 1;
+    for (i = 1, j = 0; i < threads; i++) {
+        if (chunks[i].count == 0) continue;
+        if (chunks[j].count != 0 && chunks[j].gis[chunks[j].count - 1] >= chunks[i].gis[0]) concatenated = 0;
+        j = i;
+    }
+    *gis = allocate(sizeof (int) * (total + 1), __FILE__, __LINE__);
+    *taxIds = allocate(sizeof (int) * (total + 1), __FILE__, __LINE__);
+    n = 0;
+    if (concatenated) {
+        for (i = 0; i < threads; i++) {
+            memcpy(*gis + n, chunks[i].gis, sizeof (int) * chunks[i].count);
+            memcpy(*taxIds + n, chunks[i].taxIds, sizeof (int) * chunks[i].count);
+            n += chunks[i].count;
+        }
+    } else {
+        /* Merge the sorted chunks, on ties the first chunk wins */
+        pos = allocate(sizeof (int) * threads, __FILE__, __LINE__);
+        heap = allocate(sizeof (int) * threads, __FILE__, __LINE__);
+        memset(pos, 0, sizeof (int) * threads);
+        heapSize = 0;
+        for (i = 0; i < threads; i++) {
+            if (chunks[i].count > 0) heap[heapSize++] = i;
+        }
+        for (i = heapSize / 2 - 1; i >= 0; i--) {
+            nucl_heap_down(chunks, pos, heap, heapSize, i);
+        }
+        while (heapSize > 0) {
+            best = heap[0];
+            if (n == 0 || (*gis)[n - 1] != chunks[best].gis[pos[best]]) {
+                (*gis)[n] = chunks[best].gis[pos[best]];
+                (*taxIds)[n++] = chunks[best].taxIds[pos[best]];
+            }
+            if (++pos[best] == chunks[best].count) heap[0] = heap[--heapSize];
+            nucl_heap_down(chunks, pos, heap, heapSize, 0);
+        }
+        free(heap);
+        free(pos);
+    }
+    for (i = 0; i < threads; i++) {
+        if (chunks[i].gis) free(chunks[i].gis);
+        if (chunks[i].taxIds) free(chunks[i].taxIds);
+    }
+    free(chunks);
+    unmapFile(map, size);
     clock_gettime(CLOCK_MONOTONIC, &stop);
     if (verbose) {
-        printf("%.2f sec\n", timespecDiffSec(&stop, &mid));
+        printf("\n\tThere are %d GIs in the file. Elapsed time: %.2f sec\n", n, timespecDiffSec(&stop, &start));
         fflush(stdout);
     }
-    return root;
+    return n;
 }
 
 /**
  * Read the gi_taxid_nucl.dmp file from NCBI Taxonomy and return a Btree 
- * index over the Gi
+ * index over the Gi. The values point into a single array of taxIds so 
+ * the index has to be released with TaxonomyNuclFree
  * 
  * @param filename the gi_taxid_nucl.dmp complete path
  * @param verbose 1 to print a verbose info
@@ -248,34 +550,483 @@ BtreeNode_t *TaxonomyDBIndex(char *dir, int verbose) {
  */
 BtreeNode_t *TaxonomyNuclIndex(char *gi_taxid_nucl, int verbose) {
     struct timespec start, stop;
-    FILE *fi;
     BtreeNode_t *root = NULL;
-    int gi;
-    int *taxid;
-    int count = 0;
-    char *line = NULL;
-    size_t len = 0;
-    ssize_t read;
+    int i, count;
+    int *gis, *taxIds;
+    void **values;
 
     if (verbose) printf("\n");
     clock_gettime(CLOCK_MONOTONIC, &start);
-    fi = checkPointerError(fopen(gi_taxid_nucl, "r"), "Can't open the gi_taxid_nucl.dmp.gz file", __FILE__, __LINE__, -1);
-
-    while ((read = getline(&line, &len, fi)) != -1) {
-        taxid = (int *) malloc(sizeof (int));
-        sscanf(line, "%d\t%d\n", &gi, taxid);
-        root = BtreeInsert(root, gi, taxid);
-        if (verbose && count % 10000 == 0) {
-            clock_gettime(CLOCK_MONOTONIC, &stop);
-            printf("\tReading GIs: Total: %10d\t\tTime: %.2f   \r", count, timespecDiffSec(&stop, &start));
-        }
-        count++;
+    count = TaxonomyNuclLoad(gi_taxid_nucl, 0, &gis, &taxIds, verbose);
+    values = allocate(sizeof (void *) * (count + 1), __FILE__, __LINE__);
+    for (i = 0; i < count; i++) {
+        values[i] = &taxIds[i];
     }
+    root = BtreeBulkLoad(gis, values, count);
+    if (root == NULL) free(taxIds);
 
-    if (line) free(line);
-    fclose(fi);
+    free(gis);
+    free(values);
     clock_gettime(CLOCK_MONOTONIC, &stop);
     if (verbose) printf("\n\tThere are %d GIs into the B+Tree. Elapsed time: %.2f sec\n\n", count, timespecDiffSec(&stop, &start));
     fflush(NULL);
     return root;
-}
\ No newline at end of file
+}
+
+/**
+ * Free the index returned by TaxonomyNuclIndex
+ * 
+ * @param root the index
+ */
+void TaxonomyNuclFree(BtreeNode_t *root) {
+    BtreeNode_t *leaf = root;
+    if (root == NULL) return;
+    while (!leaf->is_leaf) leaf = (BtreeNode_t *) leaf->pointers[0];
+    /* The first Gi has the first element of the taxIds array */
+    free(leaf->records[0].value);
+    BTreeFree(root, NULL);
+}
+
+/* Minimum size of the .dmp file chunks parsed by a thread */
+#define DMP_CHUNK_MIN (1 << 20)
+
+/* Rank names of the fixed TaxonomyRank_t ids */
+char *taxonomy_fixed_ranks[TAXONOMY_RANK_FIXED] = {
+    "no rank", "species", "genus", "family", "order", "class", "phylum", "superkingdom"
+};
+
+/*
+ * Return the rank id of the rank name, adding it to the table if it is new
+ */
+int taxonomy_table_rank_id(TaxonomyTable_t *table, char *rank, int length) {
+    int i;
+    for (i = 0; i < table->ranks_number; i++) {
+        if (strncmp(table->ranks[i], rank, length) == 0 && table->ranks[i][length] == '\0') return i;
+    }
+    if (table->ranks_number == 256) {
+        checkPointerError(NULL, "Too many ranks in the nodes.dmp file", __FILE__, __LINE__, -1);
+    }
+    table->ranks = reallocate(table->ranks, sizeof (char *) * (table->ranks_number + 1), __FILE__, __LINE__);
+    table->ranks[table->ranks_number] = strndup(rank, length);
+    return table->ranks_number++;
+}
+
+/*
+ * Return the parent of the taxId in the lineage or 0 if the lineage ends
+ * at the taxId
+ */
+int lineage_parent(TaxonomyTable_t *table, int taxId) {
+    int parent = table->nodes[taxId].parentTaxId;
+    if (parent == 1 || parent == taxId || !TaxonomyTableContains(table, parent)) return 0;
+    return parent;
+}
+
+/*
+ * Return the next field of the .dmp line at *p. The fields are separated
+ * by "\t|\t" and the line ends with "\t|". *p is moved to the next field.
+ * Nothing is copied or modified so it works over a read-only mapping
+ */
+char *dmp_field(char **p, char *lineEnd, int *length) {
+    char *field = *p, *q = field;
+
+    while ((q = memchr(q, '\t', lineEnd - q)) != NULL && (q + 1 == lineEnd || q[1] != '|')) q++;
+    if (q == NULL) q = lineEnd;
+    *length = q - field;
+    *p = (q + 2 < lineEnd) ? q + 2 : lineEnd;
+    if (*p < lineEnd && **p == '\t') (*p)++;
+    return field;
+}
+
+/*
+ * Parse a non negative decimal number of length chars
+ */
+int dmp_int(char *str, int length) {
+    int value = 0;
+    while (length-- > 0 && (unsigned) (*str - '0') < 10) value = value * 10 + (*str++ - '0');
+    return value;
+}
+
+/*
+ * One useful line of a .dmp file: the taxId, the parent taxId (nodes.dmp)
+ * and the rank (nodes.dmp) or the scientific name (names.dmp) inside the
+ * mapping
+ */
+typedef struct dmp_entry_t {
+    int taxId;
+    int parentTaxId;
+    char *text;
+    int length;
+} dmp_entry_t;
+
+/*
+ * A piece of a mapped .dmp file parsed by one thread
+ */
+typedef struct dmp_chunk_t {
+    char *start;
+    char *end;
+    int names;
+    dmp_entry_t *entries;
+    int count;
+    int maxTaxId;
+    size_t textSize;
+    int error;
+} dmp_chunk_t;
+
+/*
+ * Parse the lines of a chunk of nodes.dmp or names.dmp (only the 
+ * scientific names are kept)
+ */
+void *parse_dmp_chunk(void *arg) {
+    dmp_chunk_t *chunk = (dmp_chunk_t *) arg;
+    char *p = chunk->start, *lineEnd, *fields[4];
+    int lengths[4], n, capacity = 0;
+    dmp_entry_t *entry;
+
+    while (p < chunk->end) {
+        if ((lineEnd = memchr(p, '\n', chunk->end - p)) == NULL) lineEnd = chunk->end;
+        for (n = 0; n < 4 && p < lineEnd; n++) {
+            fields[n] = dmp_field(&p, lineEnd, &lengths[n]);
+        }
+        p = lineEnd + 1;
+        if (n == 0) continue;
+        if (n < (chunk->names ? 4 : 3)) {
+            chunk->error = 1;
+            break;
+        }
+        if (chunk->names && (lengths[3] != 15 || memcmp(fields[3], "scientific name", 15) != 0)) continue;
+        if (chunk->count == capacity) {
+            capacity = (capacity == 0) ? 4096 : capacity * 2;
+            chunk->entries = reallocate(chunk->entries, sizeof (dmp_entry_t) * capacity, __FILE__, __LINE__);
+        }
+        entry = &chunk->entries[chunk->count];
+        if ((entry->taxId = dmp_int(fields[0], lengths[0])) <= 0) continue;
+        chunk->count++;
+        if (chunk->names) {
+            entry->text = fields[1];
+            entry->length = lengths[1];
+            chunk->textSize += lengths[1] + 1;
+        } else {
+            entry->parentTaxId = dmp_int(fields[1], lengths[1]);
+            entry->text = fields[2];
+            entry->length = lengths[2];
+        }
+        if (entry->taxId > chunk->maxTaxId) chunk->maxTaxId = entry->taxId;
+    }
+    return NULL;
+}
+
+/*
+ * Map a .dmp file and parse it with one thread per chunk. The chunks are
+ * cut at line boundaries. Returns the chunks, the mapping stays alive
+ * because the entries point into it
+ */
+dmp_chunk_t *parse_dmp_file(char *name, int names, int threads, char **map, size_t *size) {
+    dmp_chunk_t *chunks;
+    pthread_t *tids;
+    char *p, *cut, *end;
+    int i;
+
+    *map = mapFile(name, size, __FILE__, __LINE__);
+    /* Small files are not worth a thread */
+    if ((size_t) threads > *size / DMP_CHUNK_MIN + 1) threads = *size / DMP_CHUNK_MIN + 1;
+    chunks = allocate(sizeof (dmp_chunk_t) * (threads + 1), __FILE__, __LINE__);
+    tids = allocate(sizeof (pthread_t) * threads, __FILE__, __LINE__);
+    memset(chunks, 0, sizeof (dmp_chunk_t) * (threads + 1));
+    p = *map;
+    end = *map + *size;
+    for (i = 0; i < threads; i++) {
+        chunks[i].start = p;
+        cut = (i == threads - 1) ? end : *map + (*size / threads) * (i + 1);
+        if (cut < p) cut = p;
+        if (cut < end && (cut = memchr(cut, '\n', end - cut)) != NULL) {
+            p = cut + 1;
+        } else {
+            p = end;
+        }
+        chunks[i].end = p;
+        chunks[i].names = names;
+        if (pthread_create(&tids[i], NULL, parse_dmp_chunk, &chunks[i]) != 0) {
+            checkPointerError(NULL, "Can't create the parser thread", __FILE__, __LINE__, -1);
+        }
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        if (chunks[i].error) {
+            checkPointerError(NULL, names ? "Can't parse the names.dmp file" : "Can't parse the nodes.dmp file", __FILE__, __LINE__, -1);
+        }
+    }
+    free(tids);
+    return chunks;
+}
+
+/**
+ * Read the NCBI Taxonomy nodes.dmp and names.dmp files into a table
+ * indexed by taxId. The files are mapped in memory and parsed in 
+ * parallel
+ * 
+ * @param dir the NCBI Taxonomy DB directory
+ * @param threads the number of threads (0 to use all the processors)
+ * @param verbose 1 to print a verbose info
+ * @return the NCBI Taxonomy table
+ */
+TaxonomyTable_t *TaxonomyTableLoad(char *dir, int threads, int verbose) {
+    struct timespec stop, mid;
+    TaxonomyTable_t *table;
+    dmp_chunk_t *nodes, *names;
+    dmp_entry_t *entry;
+    char *tmp, *nodesMap, *namesMap;
+    size_t nodesSize, namesSize, textSize = 0;
+    int i, j, taxId, rank = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &mid);
+    if (verbose) {
+        printf("Reading the Taxonomy database ... ");
+        fflush(stdout);
+    }
+    if (threads <= 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+
+    tmp = allocate(sizeof (char) * (strlen(dir) + 11), __FILE__, __LINE__);
+    sprintf(tmp, "%s/nodes.dmp", dir);
+    nodes = parse_dmp_file(tmp, 0, threads, &nodesMap, &nodesSize);
+    sprintf(tmp, "%s/names.dmp", dir);
+    names = parse_dmp_file(tmp, 1, threads, &namesMap, &namesSize);
+
+    table = allocate(sizeof (TaxonomyTable_t), __FILE__, __LINE__);
+    table->maxTaxId = table->count = 0;
+    for (i = 0; nodes[i].start != NULL; i++) {
+        if (nodes[i].maxTaxId > table->maxTaxId) table->maxTaxId = nodes[i].maxTaxId;
+    }
+    table->nodes = allocate(sizeof (TaxonomyNode_t) * (table->maxTaxId + 1), __FILE__, __LINE__);
+    memset(table->nodes, 0, sizeof (TaxonomyNode_t) * (table->maxTaxId + 1));
+    table->ranks = allocate(sizeof (char *) * TAXONOMY_RANK_FIXED, __FILE__, __LINE__);
+    for (i = 0; i < TAXONOMY_RANK_FIXED; i++) {
+        table->ranks[i] = strdup(taxonomy_fixed_ranks[i]);
+    }
+    table->ranks_number = TAXONOMY_RANK_FIXED;
+    table->enter = table->exit = table->preorder = NULL;
+
+    /* The chunks are merged in file order so the last line of a taxId wins */
+    for (i = 0; nodes[i].start != NULL; i++) {
+        for (j = 0; j < nodes[i].count; j++) {
+            entry = &nodes[i].entries[j];
+            taxId = entry->taxId;
+            if (table->nodes[taxId].parentTaxId == 0) table->count++;
+            table->nodes[taxId].parentTaxId = entry->parentTaxId;
+            table->nodes[taxId].name = -1;
+            if (strncmp(table->ranks[rank], entry->text, entry->length) != 0 || table->ranks[rank][entry->length] != '\0') {
+                rank = taxonomy_table_rank_id(table, entry->text, entry->length);
+            }
+            table->nodes[taxId].rank = rank;
+        }
+        if (nodes[i].entries) free(nodes[i].entries);
+    }
+
+    for (i = 0; names[i].start != NULL; i++) textSize += names[i].textSize;
+    table->names = allocate(sizeof (char) * (textSize + 1), __FILE__, __LINE__);
+    table->names_size = 0;
+    for (i = 0; names[i].start != NULL; i++) {
+        for (j = 0; j < names[i].count; j++) {
+            entry = &names[i].entries[j];
+            if (!TaxonomyTableContains(table, entry->taxId)) continue;
+            memcpy(table->names + table->names_size, entry->text, entry->length);
+            table->names[table->names_size + entry->length] = '\0';
+            table->nodes[entry->taxId].name = table->names_size;
+            table->names_size += entry->length + 1;
+        }
+        if (names[i].entries) free(names[i].entries);
+    }
+
+    free(nodes);
+    free(names);
+    unmapFile(nodesMap, nodesSize);
+    unmapFile(namesMap, namesSize);
+    free(tmp);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    if (verbose) {
+        printf("%.2f sec\n", timespecDiffSec(&stop, &mid));
+        fflush(stdout);
+    }
+    return table;
+}
+
+/**
+ * Check if the taxId is in the table
+ * 
+ * @param table the NCBI Taxonomy table
+ * @param taxId the taxId
+ * @return 1 if the taxId is in the table
+ */
+int TaxonomyTableContains(TaxonomyTable_t *table, int taxId) {
+    return taxId > 0 && taxId <= table->maxTaxId && table->nodes[taxId].parentTaxId != 0;
+}
+
+/**
+ * Return the scientific name of the taxId
+ * 
+ * @param table the NCBI Taxonomy table
+ * @param taxId the taxId (it has to be in the table)
+ * @return the name or NULL if the taxId has no name
+ */
+char *TaxonomyTableName(TaxonomyTable_t *table, int taxId) {
+    if (table->nodes[taxId].name == -1) return NULL;
+    return table->names + table->nodes[taxId].name;
+}
+
+/**
+ * Return the rank name of the taxId
+ * 
+ * @param table the NCBI Taxonomy table
+ * @param taxId the taxId (it has to be in the table)
+ * @return the rank name
+ */
+char *TaxonomyTableRank(TaxonomyTable_t *table, int taxId) {
+    return table->ranks[table->nodes[taxId].rank];
+}
+
+/**
+ * Append to the lineage array the taxId and its ancestors up to the 
+ * root (the root, taxId 1, is not included). It is the same list 
+ * returned by the getLineage method
+ * 
+ * @param table the NCBI Taxonomy table
+ * @param taxId the taxId
+ * @param lineage the array of TaxIds of the lineage
+ * @param count the number of elements in the lineage array
+ */
+void TaxonomyTableLineage(TaxonomyTable_t *table, int taxId, int **lineage, int *count) {
+    int capacity = *count;
+
+    if (!TaxonomyTableContains(table, taxId)) return;
+    while (taxId != 0) {
+        if (*count == capacity) {
+            capacity = (capacity == 0) ? 32 : capacity * 2;
+            *lineage = reallocate(*lineage, sizeof (int) * capacity, __FILE__, __LINE__);
+        }
+        (*lineage)[(*count)++] = taxId;
+        taxId = lineage_parent(table, taxId);
+    }
+}
+
+/**
+ * Number the taxonomies in a depth first walk of the tree (Euler tour)
+ * so the descendants of a taxId are a contiguous interval. The tree 
+ * is the one used by TaxonomyTableLineage: the root (taxId 1) is not 
+ * an ancestor of the other taxonomies
+ * 
+ * @param table the NCBI Taxonomy table
+ */
+void TaxonomyTableEulerTour(TaxonomyTable_t *table) {
+    int *first, *children, *stack, *next;
+    int i, taxId, parent, top, number = 0;
+    int size = table->maxTaxId + 1;
+
+    if (table->preorder) return;
+    table->enter = allocate(sizeof (int) * size, __FILE__, __LINE__);
+    table->exit = allocate(sizeof (int) * size, __FILE__, __LINE__);
+    table->preorder = allocate(sizeof (int) * (table->count + 1), __FILE__, __LINE__);
+
+    /* Children lists in one array: children of p are first[p] to first[p + 1] - 1 */
+    first = allocate(sizeof (int) * (size + 1), __FILE__, __LINE__);
+    children = allocate(sizeof (int) * (table->count + 1), __FILE__, __LINE__);
+    memset(first, 0, sizeof (int) * (size + 1));
+    for (taxId = 1; taxId < size; taxId++) {
+        if ((parent = lineage_parent(table, taxId)) != 0) first[parent + 1]++;
+    }
+    for (i = 0; i < size; i++) first[i + 1] += first[i];
+    next = allocate(sizeof (int) * size, __FILE__, __LINE__);
+    memcpy(next, first, sizeof (int) * size);
+    for (taxId = 1; taxId < size; taxId++) {
+        if ((parent = lineage_parent(table, taxId)) != 0) children[next[parent]++] = taxId;
+    }
+
+    /* Iterative walk from every taxonomy without parent. next[p] is the next child to visit */
+    stack = allocate(sizeof (int) * (table->count + 1), __FILE__, __LINE__);
+    memcpy(next, first, sizeof (int) * size);
+    for (taxId = 0; taxId < size; taxId++) {
+        table->enter[taxId] = table->exit[taxId] = -1;
+    }
+    for (taxId = 1; taxId < size; taxId++) {
+        if (!TaxonomyTableContains(table, taxId) || lineage_parent(table, taxId) != 0) continue;
+        top = 0;
+        stack[top++] = taxId;
+        table->enter[taxId] = number;
+        table->preorder[number++] = taxId;
+        while (top > 0) {
+            parent = stack[top - 1];
+            if (next[parent] < first[parent + 1]) {
+                i = children[next[parent]++];
+                stack[top++] = i;
+                table->enter[i] = number;
+                table->preorder[number++] = i;
+            } else {
+                table->exit[parent] = number - 1;
+                top--;
+            }
+        }
+    }
+    if (number != table->count) {
+        checkPointerError(NULL, "The nodes.dmp file has a cycle in the taxonomy tree", __FILE__, __LINE__, -1);
+    }
+    free(first);
+    free(children);
+    free(next);
+    free(stack);
+}
+
+/**
+ * Check if the ancestor is in the lineage of the taxId (a taxId is its
+ * own ancestor). TaxonomyTableEulerTour has to be called before
+ * 
+ * @param table the NCBI Taxonomy table
+ * @param taxId the taxId
+ * @param ancestor the ancestor taxId
+ * @return 1 if the ancestor is in the lineage of the taxId
+ */
+int TaxonomyTableIsDescendant(TaxonomyTable_t *table, int taxId, int ancestor) {
+    if (!TaxonomyTableContains(table, taxId) || !TaxonomyTableContains(table, ancestor)) return 0;
+    return table->enter[ancestor] <= table->enter[taxId] && table->enter[taxId] <= table->exit[ancestor];
+}
+
+/**
+ * Fill the mark array with 1 for the taxonomies that have any of the 
+ * taxIds in their lineage and 0 for the rest. It is a single pass 
+ * over the Euler tour (TaxonomyTableEulerTour has to be called before)
+ * 
+ * @param table the NCBI Taxonomy table
+ * @param taxIds the ancestor taxIds
+ * @param count the number of ancestor taxIds
+ * @param mark an array of maxTaxId + 1 elements
+ */
+void TaxonomyTableDescendants(TaxonomyTable_t *table, int *taxIds, int count, char *mark) {
+    int i, taxId, parent;
+
+    memset(mark, 0, sizeof (char) * (table->maxTaxId + 1));
+    for (i = 0; i < count; i++) {
+        if (TaxonomyTableContains(table, taxIds[i])) mark[taxIds[i]] = 1;
+    }
+    /* The parents are visited before their children */
+    for (i = 0; i < table->count; i++) {
+        taxId = table->preorder[i];
+        if (!mark[taxId] && (parent = lineage_parent(table, taxId)) != 0) {
+            mark[taxId] = mark[parent];
+        }
+    }
+}
+
+/**
+ * Free the table
+ * 
+ * @param table the NCBI Taxonomy table
+ */
+void TaxonomyTableFree(TaxonomyTable_t *table) {
+    if (table) {
+        freeArrayofPointers((void **) table->ranks, table->ranks_number);
+        if (table->nodes) free(table->nodes);
+        if (table->names) free(table->names);
+        if (table->enter) free(table->enter);
+        if (table->exit) free(table->exit);
+        if (table->preorder) free(table->preorder);
+        free(table);
+    }
+}
@@ -0,0 +1,158 @@
+/*
+ * File:   accessiontest.c
+ * Author: roberto
+ *
+ * Created on Oct 19, 2026, 4:20:13 PM
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <CUnit/Basic.h>
+#include "../include/gitaxmap.h"
+#include "../include/accession.h"
+
+/*
+ * CUnit Test Suite
+ */
+
+int init_suite(void) {
+    return 0;
+}
+
+int clean_suite(void) {
+    return 0;
+}
+
+void testAccession() {
+    char name[] = "/tmp/accessiontestXXXXXX", index[] = "/tmp/accindextestXXXXXX";
+    char prefix[ACCESSION_PREFIX], accession[ACCESSION_LENGTH], *query[5];
+    const char *start;
+    int i, fd, digits, version, lengths[5], out[5];
+    uint64_t number, key;
+    AccTaxMap_t *map;
+    FILE *fo;
+
+    CU_ASSERT(AccessionParse("NZ_CP012345.2", 13, prefix, &number, &digits, &version) == 1);
+    CU_ASSERT(strcmp(prefix, "NZ_CP") == 0 && number == 12345 && digits == 6 && version == 2);
+    CU_ASSERT(AccessionParse("X00001", 6, prefix, &number, &digits, &version) == 1);
+    CU_ASSERT(version == 0);
+    CU_ASSERT(AccessionParse("12345.1", 7, prefix, &number, &digits, &version) == 0);
+    CU_ASSERT(AccessionParse("AB12x", 5, prefix, &number, &digits, &version) == 0);
+    CU_ASSERT(AccessionParse("AB12.", 5, prefix, &number, &digits, &version) == 0);
+    CU_ASSERT(AccessionParse("ABCDEFGHIJKLMNOP1", 17, prefix, &number, &digits, &version) == 0);
+    CU_ASSERT(AccessionParse("AB1234567890123", 15, prefix, &number, &digits, &version) == 0);
+    CU_ASSERT(AccessionFromHeader(">gi|42|gb|AB000001.1| some text", 31, &start) == 10);
+    CU_ASSERT(strncmp(start, "AB000001.1", 10) == 0);
+    CU_ASSERT(AccessionFromHeader(">ref|NC_000913.3|", 17, &start) == 11);
+    CU_ASSERT(strncmp(start, "NC_000913.3", 11) == 0);
+    CU_ASSERT(AccessionFromHeader(">NC_000913.3 Escherichia coli", 29, &start) == 11);
+    CU_ASSERT(strncmp(start, "NC_000913.3", 11) == 0);
+
+    fd = mkstemp(name);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+    fd = mkstemp(index);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+    fo = fopen(name, "w");
+    CU_ASSERT_FATAL(fo != NULL);
+    fprintf(fo, "accession\taccession.version\ttaxid\tgi\n");
+    for (i = 0; i < 1000; i++) {
+        fprintf(fo, "NZ_CP%06d\tNZ_CP%06d.1\t%d\t%d\n", 3 * i, 3 * i, i + 1, i);
+    }
+    fprintf(fo, "AB000001\tAB000001.1\t10\t0\n");
+    fprintf(fo, "AB000001\tAB000001.3\t30\t0\n");
+    fprintf(fo, "AAAA01000001\tAAAA01000001.1\t562\t0\n");
+    fprintf(fo, "bad\tbad.1\t7\t0\n");
+    fclose(fo);
+
+    CU_ASSERT(AccTaxMapCheckText(name) == 1);
+    fo = fopen(index, "w");
+    CU_ASSERT_FATAL(fo != NULL);
+    fprintf(fo, "12\t562\n13\t9606\n");
+    fclose(fo);
+    CU_ASSERT(AccTaxMapCheckText(index) == 0);
+    fo = fopen(index, "w");
+    CU_ASSERT_FATAL(fo != NULL);
+    fprintf(fo, "NZ_CP000003\tNZ_CP000003.1\t2\t1\n");
+    fclose(fo);
+    CU_ASSERT(AccTaxMapCheckText(index) == 1);
+
+    map = AccTaxMapLoad(name, 0);
+    AccTaxMapWrite(map, index);
+    AccTaxMapFree(map);
+    CU_ASSERT(AccTaxMapCheck(index) == 1);
+    CU_ASSERT(AccTaxMapCheck(name) == 0);
+
+    map = AccTaxMapOpen(index);
+    CU_ASSERT(map->header->count == 1002);
+    CU_ASSERT(map->header->groups == 3);
+    for (i = 0; i < 1000; i++) {
+        sprintf(accession, "NZ_CP%06d.1", 3 * i);
+        CU_ASSERT(AccTaxMapFind(map, accession, strlen(accession)) == i + 1);
+        CU_ASSERT(AccTaxMapFind(map, accession, strlen(accession) - 2) == i + 1);
+        sprintf(accession, "NZ_CP%06d.1", 3 * i + 1);
+        CU_ASSERT(AccTaxMapFind(map, accession, strlen(accession)) == -1);
+    }
+    CU_ASSERT(AccTaxMapFind(map, "AB000001.3", 10) == 30);
+    CU_ASSERT(AccTaxMapFind(map, "AB000001.1", 10) == -1);
+    CU_ASSERT(AccTaxMapFind(map, "AB00001.3", 9) == -1);
+    CU_ASSERT(AccTaxMapFind(map, "AAAA01000001", 12) == 562);
+    CU_ASSERT(AccTaxMapFind(map, "ZZ000001", 8) == -1);
+    CU_ASSERT(AccTaxMapFind(map, "NZ_CP002998", 11) == -1);
+    CU_ASSERT(AccTaxMapFind(map, "AAAA01000002", 12) == -1);
+
+    key = AccessionEncode(map, "AAAA01000001.1", 14, &version);
+    CU_ASSERT(key != 0 && version == 1);
+    CU_ASSERT(AccessionDecode(map, key, version, accession) == 14);
+    CU_ASSERT(strcmp(accession, "AAAA01000001.1") == 0);
+    AccessionDecode(map, key, 0, accession);
+    CU_ASSERT(strcmp(accession, "AAAA01000001") == 0);
+    key = AccessionEncode(map, "NZ_CP002997", 11, &version);
+    CU_ASSERT(AccessionDecode(map, key, 0, accession) == 11);
+    CU_ASSERT(strcmp(accession, "NZ_CP002997") == 0);
+    CU_ASSERT(AccessionDecode(map, 0, 0, accession) == 0);
+
+    query[0] = "NZ_CP000003.1";
+    query[1] = "AB000001.1";
+    query[2] = "AB000001";
+    query[3] = "NZ_CP000004.1";
+    query[4] = "bad.1";
+    for (i = 0; i < 5; i++) lengths[i] = strlen(query[i]);
+    AccTaxMapFindBatch(map, query, lengths, 5, out);
+    CU_ASSERT(out[0] == 2 && out[1] == -1 && out[2] == 30 && out[3] == -1 && out[4] == -1);
+    AccTaxMapFree(map);
+
+    unlink(name);
+    unlink(index);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* Initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* Add a suite to the registry */
+    pSuite = CU_add_suite("accessiontest", init_suite, clean_suite);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "testAccession", testAccession))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,222 @@
+/*
+ * File:   bitsettest.c
+ * Author: roberto
+ *
+ * Created on Oct 20, 2026, 10:12:41 AM
+ */
+
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <CUnit/Basic.h>
+#include "../include/bbitset.h"
+
+/*
+ * CUnit Test Suite
+ */
+
+/* Not a multiple of 64, so the last word is partially used */
+#define BITSET_TEST_SIZE 1000
+
+char testDir[] = "/tmp/bitsettestXXXXXX";
+char bitsetName[256];
+
+int init_suite(void) {
+    if (mkdtemp(testDir) == NULL) return -1;
+    sprintf(bitsetName, "%s/test.bitset", testDir);
+    return 0;
+}
+
+int clean_suite(void) {
+    unlink(bitsetName);
+    return rmdir(testDir);
+}
+
+/*
+ * Check the set against a reference array of size bytes
+ */
+int checkBitset(Bitset_t *set, char *reference, int size) {
+    size_t count = 0;
+    int i;
+
+    for (i = 0; i < size; i++) {
+        if (bitsetTest(set, i) != reference[i]) return 0;
+        count += reference[i];
+    }
+    return bitsetCount(set) == count;
+}
+
+void testBitsetSetClear() {
+    Bitset_t *set = bitsetCreate(BITSET_TEST_SIZE);
+    char reference[BITSET_TEST_SIZE];
+    int i;
+
+    memset(reference, 0, sizeof (reference));
+    CU_ASSERT(checkBitset(set, reference, BITSET_TEST_SIZE));
+    for (i = 0; i < BITSET_TEST_SIZE; i += 3) {
+        bitsetSet(set, i);
+        reference[i] = 1;
+    }
+    bitsetSet(set, 63);
+    bitsetSet(set, 64);
+    bitsetSet(set, BITSET_TEST_SIZE - 1);
+    reference[63] = reference[64] = reference[BITSET_TEST_SIZE - 1] = 1;
+    CU_ASSERT(checkBitset(set, reference, BITSET_TEST_SIZE));
+
+    for (i = 0; i < BITSET_TEST_SIZE; i += 6) {
+        bitsetClear(set, i);
+        reference[i] = 0;
+    }
+    bitsetClear(set, 64);
+    reference[64] = 0;
+    CU_ASSERT(checkBitset(set, reference, BITSET_TEST_SIZE));
+
+    /* Setting an integer twice and clearing an absent one */
+    bitsetSet(set, 3);
+    bitsetClear(set, 1);
+    CU_ASSERT(checkBitset(set, reference, BITSET_TEST_SIZE));
+
+    /* Integers out of range are ignored and never in the set */
+    bitsetSet(set, -1);
+    bitsetSet(set, BITSET_TEST_SIZE);
+    bitsetSet(set, BITSET_TEST_SIZE + 1);
+    bitsetClear(set, -64);
+    bitsetClear(set, BITSET_TEST_SIZE);
+    CU_ASSERT(checkBitset(set, reference, BITSET_TEST_SIZE));
+    CU_ASSERT(bitsetTest(set, -1) == 0);
+    CU_ASSERT(bitsetTest(set, BITSET_TEST_SIZE) == 0);
+    CU_ASSERT(bitsetTest(set, BITSET_TEST_SIZE + 20) == 0);
+    CU_ASSERT(set->words[BITSET_TEST_SIZE / 64] >> (BITSET_TEST_SIZE % 64) == 0);
+    bitsetFree(set);
+
+    /* Empty set */
+    set = bitsetCreate(0);
+    bitsetSet(set, 0);
+    CU_ASSERT(bitsetTest(set, 0) == 0);
+    CU_ASSERT(bitsetCount(set) == 0);
+    bitsetFree(set);
+}
+
+void testBitsetUnionDifference() {
+    Bitset_t *set = bitsetCreate(BITSET_TEST_SIZE);
+    Bitset_t *small = bitsetCreate(100);
+    Bitset_t *large = bitsetCreate(BITSET_TEST_SIZE + 100);
+    char reference[BITSET_TEST_SIZE];
+    int i;
+
+    memset(reference, 0, sizeof (reference));
+    for (i = 0; i < BITSET_TEST_SIZE; i += 5) {
+        bitsetSet(set, i);
+        reference[i] = 1;
+    }
+
+    /* Union with a smaller set */
+    for (i = 0; i < 100; i += 2) {
+        bitsetSet(small, i);
+        reference[i] = 1;
+    }
+    bitsetUnion(set, small);
+    CU_ASSERT(checkBitset(set, reference, BITSET_TEST_SIZE));
+
+    /*
+     * Union with a larger set: its integers beyond the set size share the
+     * last word of the set and must not be added
+     */
+    for (i = 0; i < BITSET_TEST_SIZE + 100; i += 7) bitsetSet(large, i);
+    for (i = 0; i < BITSET_TEST_SIZE; i += 7) reference[i] = 1;
+    bitsetUnion(set, large);
+    CU_ASSERT(checkBitset(set, reference, BITSET_TEST_SIZE));
+    CU_ASSERT(set->words[BITSET_TEST_SIZE / 64] >> (BITSET_TEST_SIZE % 64) == 0);
+    CU_ASSERT(bitsetTest(set, 1001) == 0);
+
+    /* Difference with a smaller and a larger set */
+    bitsetDifference(set, small);
+    for (i = 0; i < 100; i += 2) reference[i] = 0;
+    CU_ASSERT(checkBitset(set, reference, BITSET_TEST_SIZE));
+    bitsetDifference(set, large);
+    for (i = 0; i < BITSET_TEST_SIZE; i += 7) reference[i] = 0;
+    CU_ASSERT(checkBitset(set, reference, BITSET_TEST_SIZE));
+
+    /* The smaller set keeps only its own range */
+    bitsetUnion(small, set);
+    for (i = 0; i < 100; i++) CU_ASSERT(bitsetTest(small, i) == (i % 2 == 0 || reference[i]));
+    CU_ASSERT(small->words[1] >> (100 % 64) == 0);
+
+    bitsetFree(set);
+    bitsetFree(small);
+    bitsetFree(large);
+}
+
+void testBitsetWriteRead() {
+    Bitset_t *set = bitsetCreate(BITSET_TEST_SIZE), *copy;
+    FILE *fo;
+    int i;
+
+    CU_ASSERT(bitsetRead(bitsetName, 1) == NULL);
+    for (i = 0; i < BITSET_TEST_SIZE; i += 11) bitsetSet(set, i);
+    bitsetSet(set, BITSET_TEST_SIZE - 1);
+    bitsetWrite(set, bitsetName, 0x1234567890abcdefULL);
+
+    copy = bitsetRead(bitsetName, 0x1234567890abcdefULL);
+    CU_ASSERT_FATAL(copy != NULL);
+    CU_ASSERT(copy->size == set->size);
+    CU_ASSERT(memcmp(copy->words, set->words, sizeof (uint64_t) * ((BITSET_TEST_SIZE + 63) / 64)) == 0);
+    CU_ASSERT(bitsetCount(copy) == bitsetCount(set));
+    bitsetFree(copy);
+
+    /* A different key */
+    CU_ASSERT(bitsetRead(bitsetName, 0x1234567890abcdeeULL) == NULL);
+
+    /* A truncated file */
+    CU_ASSERT_FATAL(truncate(bitsetName, sizeof (BitsetHeader_t) + 8) == 0);
+    CU_ASSERT(bitsetRead(bitsetName, 0x1234567890abcdefULL) == NULL);
+
+    /* A file that is not a set */
+    fo = fopen(bitsetName, "wb");
+    CU_ASSERT_FATAL(fo != NULL);
+    for (i = 0; i < 100; i++) fputs("text ", fo);
+    fclose(fo);
+    CU_ASSERT(bitsetRead(bitsetName, 0x1234567890abcdefULL) == NULL);
+
+    /* An empty set */
+    bitsetFree(set);
+    set = bitsetCreate(0);
+    bitsetWrite(set, bitsetName, 7);
+    copy = bitsetRead(bitsetName, 7);
+    CU_ASSERT_FATAL(copy != NULL);
+    CU_ASSERT(copy->size == 0);
+    bitsetFree(copy);
+    bitsetFree(set);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* Initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* Add a suite to the registry */
+    pSuite = CU_add_suite("bitsettest", init_suite, clean_suite);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "testBitsetSetClear", testBitsetSetClear)) ||
+            (NULL == CU_add_test(pSuite, "testBitsetUnionDifference", testBitsetUnionDifference)) ||
+            (NULL == CU_add_test(pSuite, "testBitsetWriteRead", testBitsetWriteRead))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,337 @@
+/*
+ * File:   btreetest.c
+ * Author: roberto
+ *
+ * Created on Oct 18, 2026, 9:12:41 AM
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <CUnit/Basic.h>
+#include "../include/btree.h"
+#include "../include/btreeimage.h"
+#include "../include/btreestring.h"
+#include "../include/bsimd.h"
+
+/*
+ * CUnit Test Suite
+ */
+
+int init_suite(void) {
+    return 0;
+}
+
+int clean_suite(void) {
+    return 0;
+}
+
+/*
+ * Check that every key in [0, max) is found in the tree with
+ * the value stored in values[key] and that keys not in the
+ * tree are not found
+ */
+void checkTree(BtreeNode_t *root, int *values, int max) {
+    int i;
+    BtreeRecord_t *rec;
+
+    for (i = 0; i < max; i++) {
+        rec = BTreeFind(root, i, false);
+        if (values[i] == -1) {
+            CU_ASSERT(rec == NULL);
+        } else {
+            CU_ASSERT(rec != NULL && *((int *) rec->value) == values[i]);
+        }
+    }
+}
+
+void testBtreeBulkLoad() {
+    int sizes[] = {0, 1, 2, DEFAULT_ORDER - 1, DEFAULT_ORDER, DEFAULT_ORDER + 1, 1000, 100003};
+    int i, j, s, n, tmp;
+    int *keys, *expected, *data;
+    void **values;
+    BtreeNode_t *root;
+
+    for (s = 0; s < sizeof (sizes) / sizeof (int); s++) {
+        n = sizes[s];
+        keys = malloc(sizeof (int) * (n + 1));
+        values = malloc(sizeof (void *) * (n + 1));
+        data = malloc(sizeof (int) * (n + 1));
+        expected = malloc(sizeof (int) * (2 * n + 1));
+        for (i = 0; i < 2 * n + 1; i++) expected[i] = -1;
+
+        /* Even keys shuffled, every tenth key is duplicated */
+        for (i = 0; i < n; i++) keys[i] = 2 * i;
+        for (i = n - 1; i > 0; i--) {
+            j = rand() % (i + 1);
+            tmp = keys[i];
+            keys[i] = keys[j];
+            keys[j] = tmp;
+        }
+        for (i = 0; i < n; i++) {
+            if (i % 10 == 9) keys[i] = keys[i - 1];
+            data[i] = i;
+            values[i] = &(data[i]);
+            if (expected[keys[i]] == -1) expected[keys[i]] = i;
+        }
+
+        root = BtreeBulkLoad(keys, values, n);
+        if (n == 0) {
+            CU_ASSERT(root == NULL);
+        }
+        checkTree(root, expected, 2 * n + 1);
+        for (i = 1; i < n; i++) {
+            CU_ASSERT(keys[i - 1] <= keys[i]);
+        }
+
+        /* The tree must keep working with the insertion function */
+        for (i = 0; i < n; i++) {
+            if (expected[2 * i + 1] == -1 && i % 3 == 0) {
+                root = BtreeInsert(root, 2 * i + 1, &(data[i]));
+                expected[2 * i + 1] = i;
+            }
+        }
+        checkTree(root, expected, 2 * n + 1);
+
+        BTreeFree(root, NULL);
+        free(keys);
+        free(values);
+        free(data);
+        free(expected);
+    }
+}
+
+void testBtreeInsert() {
+    int orders[] = {MIN_ORDER, 4, 7, DEFAULT_ORDER};
+    int i, o, key, n = 20000;
+    int *expected, *data;
+    BtreeNode_t *root;
+
+    expected = malloc(sizeof (int) * n);
+    data = malloc(sizeof (int) * n);
+    for (o = 0; o < sizeof (orders) / sizeof (int); o++) {
+        CU_ASSERT(BtreeSetOrder(orders[o]) == orders[o]);
+        root = NULL;
+        for (i = 0; i < n; i++) expected[i] = -1;
+        for (i = 0; i < n; i++) {
+            key = rand() % n;
+            data[i] = i;
+            root = BtreeInsert(root, key, &(data[i]));
+            if (expected[key] == -1) expected[key] = i;
+        }
+        checkTree(root, expected, n);
+        BTreeFree(root, NULL);
+    }
+    CU_ASSERT(BtreeSetOrder(MAX_ORDER + 1) == DEFAULT_ORDER);
+    free(expected);
+    free(data);
+}
+
+void testBTreeFindBatch() {
+    int i, n = 50000, m = 3 * 50000;
+    int *keys, *data, *query;
+    void **values;
+    BtreeRecord_t **out;
+    BtreeNode_t *root;
+
+    keys = malloc(sizeof (int) * n);
+    data = malloc(sizeof (int) * n);
+    values = malloc(sizeof (void *) * n);
+    query = malloc(sizeof (int) * m);
+    out = malloc(sizeof (BtreeRecord_t *) * m);
+    for (i = 0; i < n; i++) {
+        keys[i] = 2 * i;
+        data[i] = i;
+        values[i] = &(data[i]);
+    }
+    root = BtreeBulkLoad(keys, values, n);
+    for (i = 0; i < m; i++) query[i] = rand() % (2 * n + 10) - 5;
+
+    BTreeFindBatch(root, query, m, out);
+    for (i = 0; i < m; i++) {
+        CU_ASSERT(out[i] == BTreeFind(root, query[i], false));
+    }
+    BTreeFindBatch(NULL, query, 20, out);
+    for (i = 0; i < 20; i++) {
+        CU_ASSERT(out[i] == NULL);
+    }
+    BTreeFree(root, NULL);
+    free(keys);
+    free(data);
+    free(values);
+    free(query);
+    free(out);
+}
+
+/*
+ * Return 1 if the two files have the same bytes
+ */
+int sameFiles(char *a, char *b) {
+    FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    int ca, cb, same = (fa != NULL && fb != NULL);
+
+    while (same) {
+        ca = getc(fa);
+        cb = getc(fb);
+        if (ca != cb) same = 0;
+        if (ca == EOF) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+void testBtreeImage() {
+    int sizes[] = {0, 1, 339, 340, 341, 200000};
+    char name[] = "/tmp/btreetestXXXXXX", arraysName[] = "/tmp/btreetestXXXXXX";
+    int i, s, n, fd;
+    int *keys, *data, *value, *repeated, *repeatedData;
+    void **values;
+    BtreeNode_t *root;
+    BtreeImage_t *image;
+
+    fd = mkstemp(name);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+    fd = mkstemp(arraysName);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+    for (s = 0; s < sizeof (sizes) / sizeof (int); s++) {
+        n = sizes[s];
+        keys = malloc(sizeof (int) * (n + 1));
+        values = malloc(sizeof (void *) * (n + 1));
+        data = malloc(sizeof (int) * (n + 1));
+        for (i = 0; i < n; i++) {
+            keys[i] = 3 * i - n;
+            data[i] = i;
+            values[i] = &(data[i]);
+        }
+        root = BtreeBulkLoad(keys, values, n);
+        BtreeImageWrite(name, root, sizeof (int));
+        CU_ASSERT(BtreeImageCheck(name) == 1);
+
+        image = BtreeImageOpen(name, sizeof (int));
+        CU_ASSERT(image->header->numKeys == n);
+        for (i = 0; i < n; i++) {
+            value = BtreeImageFind(image, 3 * i - n);
+            CU_ASSERT(value != NULL && *value == i);
+            CU_ASSERT(BtreeImageFind(image, 3 * i - n + 1) == NULL);
+        }
+        CU_ASSERT(BtreeImageFind(image, -n - 1) == NULL);
+        CU_ASSERT(BtreeImageFind(image, 3 * n) == NULL);
+        BtreeImageClose(image);
+
+        /* The image of the arrays is the image of the tree */
+        BtreeImageWriteArrays(arraysName, keys, data, n, sizeof (int));
+        CU_ASSERT(sameFiles(name, arraysName));
+
+        /* Only the first value of a repeated key is written */
+        repeated = malloc(sizeof (int) * (2 * n + 1));
+        repeatedData = malloc(sizeof (int) * (2 * n + 1));
+        for (i = 0; i < n; i++) {
+            repeated[2 * i] = repeated[2 * i + 1] = keys[i];
+            repeatedData[2 * i] = data[i];
+            repeatedData[2 * i + 1] = -1;
+        }
+        BtreeImageWriteArrays(arraysName, repeated, repeatedData, 2 * n, sizeof (int));
+        CU_ASSERT(sameFiles(name, arraysName));
+        free(repeated);
+        free(repeatedData);
+
+        BTreeFree(root, NULL);
+        free(keys);
+        free(values);
+        free(data);
+    }
+    unlink(name);
+    unlink(arraysName);
+}
+
+void testSimdSearch() {
+    int keys[300];
+    uint64_t prefixes[300];
+    int i, n, level, key, expected;
+
+    for (i = 0; i < 300; i++) {
+        keys[i] = 4 * i - 500;
+        prefixes[i] = 0x7ffffffffffffff0ULL + 8 * i;
+    }
+    for (level = SIMD_SCALAR; level <= getSimdSupported(); level++) {
+        CU_ASSERT(setSimdLevel(level) == level);
+        for (n = 0; n < 40; n++) {
+            for (key = -510; key < 4 * n - 490; key++) {
+                expected = 0;
+                while (expected < n && keys[expected] < key) expected++;
+                CU_ASSERT(countLessInt(keys, n, key) == expected);
+            }
+            for (i = 0; i <= n; i++) {
+                CU_ASSERT(countLessPrefix(prefixes, n, 0x7ffffffffffffff0ULL + 8 * i) == i);
+                CU_ASSERT(countLessPrefix(prefixes, n, 0x7ffffffffffffff0ULL + 8 * i + 1) == (i < n ? i + 1 : n));
+            }
+        }
+    }
+    setSimdLevel(SIMD_AVX2);
+    CU_ASSERT(stringPrefix("a") < stringPrefix("ab"));
+    CU_ASSERT(stringPrefix("abcdefgh") == stringPrefix("abcdefghij"));
+    CU_ASSERT(stringPrefix("\xff") > stringPrefix("zzzzzzzz"));
+}
+
+void testBtreeString() {
+    int i, n = 5000;
+    int *data;
+    char key[64];
+    BtreeNodeString_t *root = NULL;
+    BtreeRecord_t *rec;
+
+    data = malloc(sizeof (int) * n);
+    for (i = 0; i < n; i++) {
+        data[i] = i;
+        /* Long shared prefixes make the prefix compare tie */
+        sprintf(key, "%s%d", (i % 2) ? "ACCESSION_" : "A", (i * 7919) % n);
+        root = BtreeInsertString(root, strdup(key), &(data[i]));
+    }
+    for (i = 0; i < n; i++) {
+        sprintf(key, "%s%d", (i % 2) ? "ACCESSION_" : "A", (i * 7919) % n);
+        rec = BTreeFindString(root, key, false);
+        CU_ASSERT(rec != NULL && *((int *) rec->value) == i);
+        sprintf(key, "%s%d_", (i % 2) ? "ACCESSION_" : "A", (i * 7919) % n);
+        CU_ASSERT(BTreeFindString(root, key, false) == NULL);
+    }
+    BTreeStringFree(root, NULL);
+    free(data);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* Initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* Add a suite to the registry */
+    pSuite = CU_add_suite("btreetest", init_suite, clean_suite);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "testBtreeBulkLoad", testBtreeBulkLoad)) ||
+            (NULL == CU_add_test(pSuite, "testBtreeInsert", testBtreeInsert)) ||
+            (NULL == CU_add_test(pSuite, "testBTreeFindBatch", testBTreeFindBatch)) ||
+            (NULL == CU_add_test(pSuite, "testBtreeImage", testBtreeImage)) ||
+            (NULL == CU_add_test(pSuite, "testSimdSearch", testSimdSearch)) ||
+            (NULL == CU_add_test(pSuite, "testBtreeString", testBtreeString))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,228 @@
+/*
+ * File:   bzindextest.c
+ * Author: roberto
+ *
+ * Created on Oct 19, 2026, 2:40:18 PM
+ */
+
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <zlib.h>
+#include <CUnit/Basic.h>
+#include "../include/bzindex.h"
+
+/*
+ * CUnit Test Suite
+ */
+
+/* Small span so the test file has many access points */
+#define BZINDEX_TEST_SPAN 65536
+#define BZINDEX_TEST_READS 400
+
+char testDir[] = "/tmp/bzindextestXXXXXX";
+char gzName[256], indexName[256];
+char *text;
+size_t textSize;
+
+/*
+ * Text of lines of random bases, so the deflate blocks and the windows
+ * are not trivial
+ */
+char *createText(size_t *size) {
+    size_t capacity = 3 << 20, n = 0, len;
+    char *text = malloc(capacity);
+    int i;
+
+    srand(23);
+    while (n + 200 < capacity) {
+        n += sprintf(text + n, ">entry %d\n", rand());
+        len = rand() % 150;
+        for (i = 0; i < len; i++) text[n++] = "ACGT"[rand() % 4];
+        text[n++] = '\n';
+    }
+    *size = n;
+    return text;
+}
+
+/*
+ * Write the text as concatenated gzip members of different sizes, one of
+ * them empty. Returns 0 if the file can't be written
+ */
+int writeMembers(char *name, char *text, size_t size) {
+    size_t cuts[] = {0, 1000, 1000, 700000, 2000000, size};
+    gzFile gz;
+    int i;
+
+    for (i = 0; i < sizeof (cuts) / sizeof (size_t) - 1; i++) {
+        gz = gzopen(name, (i == 0) ? "wb6" : "ab6");
+        if (gz == NULL) return 0;
+        if (cuts[i + 1] > cuts[i]) gzwrite(gz, text + cuts[i], cuts[i + 1] - cuts[i]);
+        gzclose(gz);
+    }
+    return 1;
+}
+
+int init_suite(void) {
+    if (mkdtemp(testDir) == NULL) return -1;
+    sprintf(gzName, "%s/test.fasta.gz", testDir);
+    sprintf(indexName, "%s/test.fasta.gz%s", testDir, ZINDEX_EXTENSION);
+    text = createText(&textSize);
+    return writeMembers(gzName, text, textSize) ? 0 : -1;
+}
+
+int clean_suite(void) {
+    free(text);
+    unlink(gzName);
+    unlink(indexName);
+    return rmdir(testDir);
+}
+
+/*
+ * Read size bytes at offset and compare them with the text
+ */
+int checkRead(FILE *fd, off_t offset, size_t size) {
+    char *buffer = malloc(size + 1);
+    size_t expected = (offset < textSize) ? textSize - offset : 0, n;
+    int ok;
+
+    if (expected > size) expected = size;
+    ok = fseeko(fd, offset, SEEK_SET) == 0 && ftello(fd) == offset;
+    n = fread(buffer, 1, size, fd);
+    ok = ok && n == expected && memcmp(buffer, text + offset, n) == 0;
+    free(buffer);
+    return ok;
+}
+
+/*
+ * Random reads forward and backward, some of them longer than the
+ * output buffer of the stream
+ */
+void checkRandomReads(FILE *fd) {
+    off_t offset;
+    size_t size;
+    int i;
+
+    for (i = 0; i < BZINDEX_TEST_READS; i++) {
+        offset = ((off_t) rand() * RAND_MAX + rand()) % textSize;
+        size = (i % 10 == 0) ? 2 * ZINDEX_CHUNK + rand() % 1000 : rand() % 5000;
+        CU_ASSERT(checkRead(fd, offset, size));
+        /* Short seek backward, in the output buffer */
+        if (offset > 100) CU_ASSERT(checkRead(fd, offset - 100, 50));
+    }
+    CU_ASSERT(checkRead(fd, 0, 100));
+    CU_ASSERT(checkRead(fd, textSize - 10, 100));
+    CU_ASSERT(checkRead(fd, textSize, 100));
+    CU_ASSERT(checkRead(fd, textSize + 1000, 100));
+}
+
+/*
+ * Seek from the end: the size is only known once the end is inflated
+ */
+void checkSeekEnd(FILE *fd) {
+    char buffer[200];
+
+    CU_ASSERT(fseeko(fd, -150, SEEK_END) == 0);
+    CU_ASSERT(ftello(fd) == (off_t) textSize - 150);
+    CU_ASSERT(fread(buffer, 1, sizeof (buffer), fd) == 150);
+    CU_ASSERT(memcmp(buffer, text + textSize - 150, 150) == 0);
+    CU_ASSERT(fseeko(fd, 0, SEEK_END) == 0);
+    CU_ASSERT(ftello(fd) == (off_t) textSize);
+    CU_ASSERT(fread(buffer, 1, sizeof (buffer), fd) == 0);
+}
+
+void testZindexOpen() {
+    ZIndex_t *index;
+    FILE *fd;
+
+    /* Random reads while the index is built */
+    index = zindexCreate(BZINDEX_TEST_SPAN);
+    fd = zindexOpen(gzName, index);
+    srand(5);
+    checkRandomReads(fd);
+    fclose(fd);
+
+    /* Seek from the end with a new index and then random reads */
+    zindexFree(index);
+    index = zindexCreate(BZINDEX_TEST_SPAN);
+    fd = zindexOpen(gzName, index);
+    checkSeekEnd(fd);
+    CU_ASSERT(index->size == (off_t) textSize);
+    CU_ASSERT(index->count > textSize / BZINDEX_TEST_SPAN / 2);
+    checkRandomReads(fd);
+    checkSeekEnd(fd);
+    fclose(fd);
+    zindexFree(index);
+}
+
+void testZindexWriteRead() {
+    ZIndex_t *index, *copy;
+    FILE *fd;
+    int i;
+
+    CU_ASSERT(zindexRead(indexName) == NULL);
+
+    /* Complete index of a sequential read */
+    index = zindexCreate(BZINDEX_TEST_SPAN);
+    fd = zindexOpen(gzName, index);
+    CU_ASSERT(checkRead(fd, 0, textSize + 1));
+    fclose(fd);
+    CU_ASSERT(index->size == (off_t) textSize);
+
+    zindexWrite(index, indexName);
+    copy = zindexRead(indexName);
+    CU_ASSERT_FATAL(copy != NULL);
+    CU_ASSERT(copy->span == index->span);
+    CU_ASSERT(copy->size == index->size);
+    CU_ASSERT_FATAL(copy->count == index->count);
+    for (i = 0; i < index->count; i++) {
+        CU_ASSERT(copy->points[i].out == index->points[i].out);
+        CU_ASSERT(copy->points[i].in == index->points[i].in);
+        CU_ASSERT(copy->points[i].bits == index->points[i].bits);
+        CU_ASSERT_FATAL(copy->points[i].windowSize == index->points[i].windowSize);
+        if (index->points[i].windowSize > 0) {
+            CU_ASSERT(memcmp(copy->points[i].window, index->points[i].window, index->points[i].windowSize) == 0);
+        }
+    }
+    zindexFree(index);
+
+    /* The index read from the file is used to restart the inflate */
+    fd = zindexOpen(gzName, copy);
+    srand(7);
+    checkRandomReads(fd);
+    checkSeekEnd(fd);
+    fclose(fd);
+    zindexFree(copy);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* Initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* Add a suite to the registry */
+    pSuite = CU_add_suite("bzindextest", init_suite, clean_suite);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "testZindexOpen", testZindexOpen)) ||
+            (NULL == CU_add_test(pSuite, "testZindexWriteRead", testZindexWriteRead))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,186 @@
+/*
+ * File:   bzreadertest.c
+ * Author: roberto
+ *
+ * Created on Oct 19, 2026, 11:20:37 AM
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+#include <CUnit/Basic.h>
+#include "../include/bzreader.h"
+
+/*
+ * CUnit Test Suite
+ */
+
+int init_suite(void) {
+    return 0;
+}
+
+int clean_suite(void) {
+    return 0;
+}
+
+/*
+ * Text of about 5 slots: a line ending at the end of the first slot, lines
+ * split between slots, empty lines, a line longer than two slots and a
+ * last line without newline
+ */
+char *createText(size_t *size) {
+    size_t capacity = 5 * (size_t) ZREADER_BLOCK, n = 0, len;
+    char *text = malloc(capacity);
+    int i;
+
+    srand(11);
+    while (n + 300 < ZREADER_BLOCK) {
+        len = rand() % 200;
+        for (i = 0; i < len; i++) text[n++] = 'a' + i % 26;
+        text[n++] = '\n';
+    }
+    memset(text + n, 'b', ZREADER_BLOCK - 1 - n);
+    text[ZREADER_BLOCK - 1] = '\n';
+    n = ZREADER_BLOCK;
+    while (n + 300 < 2 * (size_t) ZREADER_BLOCK + ZREADER_BLOCK / 2) {
+        len = rand() % 200;
+        for (i = 0; i < len; i++) text[n++] = 'c' + i % 20;
+        text[n++] = '\n';
+    }
+    len = 2 * (size_t) ZREADER_BLOCK + 1000;
+    memset(text + n, 'L', len);
+    n += len;
+    text[n++] = '\n';
+    while (n + 300 < capacity) {
+        len = rand() % 200;
+        for (i = 0; i < len; i++) text[n++] = 'd' + i % 20;
+        text[n++] = '\n';
+    }
+    memcpy(text + n, "last", 4);
+    n += 4;
+    *size = n;
+    return text;
+}
+
+/*
+ * Read the file with zreaderLines and zreaderGetline and compare it with
+ * the text
+ */
+void checkReader(char *name, char *text, size_t size) {
+    ZReader_t *reader;
+    char *block, *line = NULL, *p;
+    size_t blockSize, pos = 0, len = 0;
+    ssize_t n;
+    int ok = 1;
+
+    reader = zreaderOpen(name);
+    while ((block = zreaderLines(reader, &blockSize)) != NULL) {
+        CU_ASSERT(blockSize > 0);
+        if (pos + blockSize > size || memcmp(block, text + pos, blockSize) != 0) ok = 0;
+        pos += blockSize;
+        /* Only complete lines, the last one of the file without newline */
+        if (pos < size && block[blockSize - 1] != '\n') ok = 0;
+    }
+    CU_ASSERT(ok);
+    CU_ASSERT(pos == size);
+    zreaderClose(reader);
+
+    reader = zreaderOpen(name);
+    pos = 0;
+    ok = 1;
+    while ((n = zreaderGetline(&line, &len, reader)) != -1) {
+        p = memchr(text + pos, '\n', size - pos);
+        if (n != ((p != NULL) ? p + 1 - (text + pos) : size - pos)
+                || memcmp(line, text + pos, n) != 0 || line[n] != '\0') {
+            ok = 0;
+            break;
+        }
+        pos += n;
+    }
+    CU_ASSERT(ok);
+    CU_ASSERT(pos == size);
+    zreaderClose(reader);
+    free(line);
+}
+
+void testZReader() {
+    char name[] = "/tmp/bzreadertestXXXXXX";
+    char gzName[] = "/tmp/bzreadertestXXXXXX.gz";
+    size_t size;
+    char *text = createText(&size), *block;
+    ZReader_t *reader;
+    FILE *fo;
+    gzFile gz;
+    int fd;
+
+    fd = mkstemp(name);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+    fd = mkstemps(gzName, 3);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+
+    fo = fopen(name, "w");
+    fwrite(text, 1, size, fo);
+    fclose(fo);
+    CU_ASSERT(isGzipFile(name) == 0);
+    checkReader(name, text, size);
+
+    gz = gzopen(gzName, "wb1");
+    gzwrite(gz, text, size);
+    gzclose(gz);
+    CU_ASSERT(isGzipFile(gzName) == 1);
+    checkReader(gzName, text, size);
+
+    /* A file of complete lines ends with the last slot */
+    fo = fopen(name, "w");
+    fwrite(text, 1, ZREADER_BLOCK, fo);
+    fclose(fo);
+    checkReader(name, text, ZREADER_BLOCK);
+
+    /* An empty file */
+    fo = fopen(name, "w");
+    fclose(fo);
+    reader = zreaderOpen(name);
+    CU_ASSERT(zreaderLines(reader, &size) == NULL);
+    zreaderClose(reader);
+    block = NULL;
+    size = 0;
+    reader = zreaderOpen(name);
+    CU_ASSERT(zreaderGetline(&block, &size, reader) == -1);
+    zreaderClose(reader);
+
+    unlink(name);
+    unlink(gzName);
+    free(text);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* Initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* Add a suite to the registry */
+    pSuite = CU_add_suite("bzreadertest", init_suite, clean_suite);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "testZReader", testZReader))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
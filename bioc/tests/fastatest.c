@@ -5,21 +5,36 @@
  * Created on Apr 14, 2014, 2:22:39 PM
  */
 
+#define _FILE_OFFSET_BITS 64
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <zlib.h>
 #include <CUnit/Basic.h>
+#include "../include/btree.h"
+#include "../include/bsimd.h"
 #include "../include/fasta.h"
 
 /*
  * CUnit Test Suite
  */
 
+char testDir[] = "/tmp/fastatestXXXXXX";
+char fastaName[256];
+
 int init_suite(void) {
+    if (mkdtemp(testDir) == NULL) return -1;
+    sprintf(fastaName, "%s/test.fasta", testDir);
     return 0;
 }
 
 int clean_suite(void) {
-    return 0;
+    unlink(fastaName);
+    return rmdir(testDir);
 }
 
 void testCreateFasta() {
@@ -35,6 +50,651 @@ void testCreateFasta() {
     result->free(result);
 }
 
+/*
+ * Test records: empty, shorter than one segment and long enough for
+ * several splitter tasks, with lowercase, N runs and other IUPAC codes
+ */
+#define FASTA_TEST_RECORDS 4
+
+int testLengths[FASTA_TEST_RECORDS] = {0, 30, 1000000, 250001};
+
+char *createSequence(int len) {
+    char *seq = malloc(len + 1);
+    int i, j, run;
+
+    for (i = 0; i < len; i += run) {
+        run = 1 + rand() % 300;
+        if (run > len - i) run = len - i;
+        for (j = i; j < i + run; j++) {
+            switch (rand() % 20) {
+                case 0: seq[j] = 'N';
+                    break;
+                case 1: seq[j] = "RYKMSW"[rand() % 6];
+                    break;
+                default: seq[j] = "ACGT"[rand() % 4];
+            }
+        }
+        if (rand() % 10 == 0) memset(seq + i, (rand() % 2) ? 'N' : 'n', run);
+        /* Low complexity runs for the DUST score */
+        if (rand() % 10 == 1) {
+            for (j = i; j < i + run; j++) seq[j] = "CA"[j % 2];
+        }
+        if (rand() % 5 == 0) {
+            for (j = i; j < i + run; j++) seq[j] |= 0x20;
+        }
+    }
+    seq[len] = '\0';
+    return seq;
+}
+
+/*
+ * Code of an ACGT base, upper or lower case, or -1
+ */
+int baseCode(char c) {
+    switch (c & ~0x20) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+    }
+    return -1;
+}
+
+/*
+ * Check the filter over the window [start, end) counting its bases
+ */
+int referenceFilter(FastaSegmentFilter_t *filter, char *seq, int start, int end) {
+    int triplets[64], p, a, b, c, run = 0, maxRun = 0, size = end - start;
+    size_t n = 0, acgt = 0;
+    long long int repeats = 0;
+
+    memset(triplets, 0, sizeof (triplets));
+    for (p = start; p < end; p++) {
+        run = (seq[p] == 'N') ? run + 1 : 0;
+        if (run > maxRun) maxRun = run;
+        n += (seq[p] == 'N');
+        acgt += (baseCode(seq[p]) >= 0);
+        if (p + 2 < end && (a = baseCode(seq[p])) >= 0 && (b = baseCode(seq[p + 1])) >= 0 && (c = baseCode(seq[p + 2])) >= 0) {
+            repeats += triplets[(a << 4) | (b << 2) | c]++;
+        }
+    }
+    if (filter->maxN >= 0 && n > (size_t) filter->maxN) return 0;
+    if (filter->minACGT >= 0 && size > 0 && acgt < filter->minACGT * size) return 0;
+    if (filter->maxDust >= 0 && size > 3 && repeats > filter->maxDust * (size - 2)) return 0;
+    if (filter->maxNRun >= 0 && maxRun > filter->maxNRun) return 0;
+    return 1;
+}
+
+/*
+ * The segments of the sequence written one by one, the reference of the
+ * splitter output. filter is NULL to keep all the segments
+ */
+void referenceSegments(FILE *out, int gi, char *seq, int len, int length, int offset, int lineLength, FastaSegmentFilter_t *filter) {
+    int start, end, p;
+
+    for (start = 0; start < len; start += offset) {
+        end = (start + length < len) ? start + length : len;
+        if (filter && !referenceFilter(filter, seq, start, end)) {
+            if (start + length >= len) break;
+            continue;
+        }
+        fprintf(out, ">%d|%d-%d\n", gi, start, start + length);
+        for (p = start; p < end; p += lineLength) {
+            fprintf(out, "%.*s\n", (p + lineLength < end) ? lineLength : end - p, seq + p);
+        }
+        if (start + length >= len) break;
+    }
+}
+
+/*
+ * Split the records with a splitter and compare the output with the
+ * reference
+ */
+void checkSplitter(char **seqs, int length, int offset, int lineLength, int threads, int packed, FastaSegmentFilter_t *filter) {
+    FastaSplitter_t *splitter;
+    fasta_l fasta;
+    FILE *out, *ref;
+    char *outText, *refText, header[64];
+    size_t outSize, refSize;
+    int i;
+
+    out = open_memstream(&outText, &outSize);
+    ref = open_memstream(&refText, &refSize);
+    splitter = CreateFastaSplitter(out, NULL, length, offset, lineLength, threads, filter);
+    for (i = 0; i < FASTA_TEST_RECORDS; i++) {
+        sprintf(header, "gi|%d|ref|test %d", 1001 + i, i);
+        fasta = CreateFasta();
+        fasta->setHeader(fasta, header);
+        fasta->setSeq(fasta, seqs[i]);
+        if (packed) fasta->pack(fasta);
+        FastaSplitterAdd(splitter, fasta);
+        referenceSegments(ref, 1001 + i, seqs[i], testLengths[i], length, offset, lineLength, filter);
+    }
+    FreeFastaSplitter(splitter);
+    fclose(out);
+    fclose(ref);
+    CU_ASSERT(outSize == refSize);
+    CU_ASSERT(outSize == refSize && memcmp(outText, refText, refSize) == 0);
+    free(outText);
+    free(refText);
+}
+
+void testFastaSplitter() {
+    char *seqs[FASTA_TEST_RECORDS];
+    int i, threads, packed;
+
+    srand(31);
+    for (i = 0; i < FASTA_TEST_RECORDS; i++) {
+        seqs[i] = createSequence(testLengths[i]);
+    }
+    for (packed = 0; packed <= 1; packed++) {
+        for (threads = 1; threads <= 4; threads += 3) {
+            /* Overlapped segments, segments with a gap between them */
+            checkSplitter(seqs, 100, 50, 60, threads, packed, NULL);
+            checkSplitter(seqs, 80, 120, 80, threads, packed, NULL);
+            checkSplitter(seqs, 1000, 700, 70, threads, packed, NULL);
+        }
+    }
+    for (i = 0; i < FASTA_TEST_RECORDS; i++) {
+        free(seqs[i]);
+    }
+}
+
+/*
+ * The one entry splitter of the splitInSegments method, which does not
+ * free the entry, and a splitter that changes its output file between
+ * records
+ */
+void testSplitInSegments() {
+    FastaSplitter_t *splitter;
+    fasta_l fasta;
+    FILE *out[FASTA_TEST_RECORDS], *ref;
+    char *seqs[FASTA_TEST_RECORDS], *outText[FASTA_TEST_RECORDS], *refText, header[64];
+    size_t outSize[FASTA_TEST_RECORDS], refSize;
+    int i, threads;
+
+    srand(37);
+    for (i = 0; i < FASTA_TEST_RECORDS; i++) {
+        seqs[i] = createSequence(testLengths[i]);
+    }
+    for (threads = 1; threads <= 4; threads += 3) {
+        for (i = 0; i < FASTA_TEST_RECORDS; i++) {
+            sprintf(header, "gi|%d|ref|test %d", 2001 + i, i);
+            fasta = CreateFasta();
+            fasta->setHeader(fasta, header);
+            fasta->setSeq(fasta, seqs[i]);
+            out[0] = open_memstream(&outText[0], &outSize[0]);
+            ref = open_memstream(&refText, &refSize);
+            fasta->splitInSegments(fasta, out[0], NULL, 100, 50, 60, threads, 0);
+            CU_ASSERT(fasta->len == testLengths[i]);
+            fasta->free(fasta);
+            referenceSegments(ref, 2001 + i, seqs[i], testLengths[i], 100, 50, 60, NULL);
+            fclose(out[0]);
+            fclose(ref);
+            CU_ASSERT(outSize[0] == refSize && memcmp(outText[0], refText, refSize) == 0);
+            free(outText[0]);
+            free(refText);
+        }
+
+        splitter = CreateFastaSplitter(NULL, NULL, 100, 50, 60, threads, NULL);
+        for (i = 0; i < FASTA_TEST_RECORDS; i++) {
+            out[i] = open_memstream(&outText[i], &outSize[i]);
+            FastaSplitterSetOutput(splitter, out[i]);
+            sprintf(header, "gi|%d|ref|test %d", 2001 + i, i);
+            fasta = CreateFasta();
+            fasta->setHeader(fasta, header);
+            fasta->setSeq(fasta, seqs[i]);
+            FastaSplitterAdd(splitter, fasta);
+        }
+        FreeFastaSplitter(splitter);
+        for (i = 0; i < FASTA_TEST_RECORDS; i++) {
+            fclose(out[i]);
+            ref = open_memstream(&refText, &refSize);
+            referenceSegments(ref, 2001 + i, seqs[i], testLengths[i], 100, 50, 60, NULL);
+            fclose(ref);
+            CU_ASSERT(outSize[i] == refSize && memcmp(outText[i], refText, refSize) == 0);
+            free(outText[i]);
+            free(refText);
+        }
+    }
+    for (i = 0; i < FASTA_TEST_RECORDS; i++) {
+        free(seqs[i]);
+    }
+}
+
+/*
+ * The splitter filter moves its counts from one window to the next, the
+ * reference counts each window. The windows overlap, are contiguous or
+ * have gaps between them
+ */
+void testFastaSegmentFilter() {
+    FastaSegmentFilter_t filters[] = {
+        {-1, FASTA_FILTER_N_RUN, -1, -1},
+        {5, -1, -1, -1},
+        {-1, -1, 0.9, -1},
+        {-1, -1, -1, 2.0},
+        {-1, -1, -1, 0.5},
+        {10, 6, 0.8, 1.5}
+    };
+    char *seqs[FASTA_TEST_RECORDS];
+    int i, f, level;
+
+    srand(41);
+    for (i = 0; i < FASTA_TEST_RECORDS; i++) {
+        seqs[i] = createSequence(testLengths[i]);
+    }
+    for (level = SIMD_SCALAR; level <= getSimdSupported(); level++) {
+        setSimdLevel(level);
+        for (f = 0; f < sizeof (filters) / sizeof (FastaSegmentFilter_t); f++) {
+            checkSplitter(seqs, 64, 7, 60, 4, 0, &filters[f]);
+            checkSplitter(seqs, 100, 100, 60, 1, 1, &filters[f]);
+            checkSplitter(seqs, 80, 120, 80, 3, 1, &filters[f]);
+        }
+    }
+    setSimdLevel(SIMD_AVX2);
+    for (i = 0; i < FASTA_TEST_RECORDS; i++) {
+        free(seqs[i]);
+    }
+}
+
+/*
+ * Index test file: about 3 MB of records of random size with duplicated
+ * Gis. Some records are placed so the ranges of 2, 3 and 5 threads start
+ * on a '>', on the new line before a header and inside a header
+ */
+#define FASTA_INDEX_TEST_SIZE 3000000
+#define FASTA_INDEX_TEST_RANGE 65536
+
+/*
+ * Write a record of exactly size bytes with lines of 60 bases. Returns
+ * the number of bytes written
+ */
+int writeIndexRecord(char *text, int gi, int number, int size) {
+    int n = sprintf(text, ">gi|%d|emb|X%06d| index test entry %d\n", gi, number, rand());
+    int line;
+
+    if (size - n == 1) text[n - 1] = ' ', text[n++] = '\n';
+    while (n < size) {
+        line = (size - n > 61) ? 60 : size - n - 1;
+        memset(text + n, "ACGT"[rand() % 4], line);
+        n += line;
+        text[n++] = '\n';
+    }
+    return n;
+}
+
+char *createIndexText() {
+    /* Records start at these offsets, the last one is the file size */
+    off_t starts[] = {599990, 1000001, 1500000, 2000000, FASTA_INDEX_TEST_SIZE};
+    char *text = malloc(FASTA_INDEX_TEST_SIZE);
+    int i, n = 0, number = 0, size;
+
+    for (i = 0; i < sizeof (starts) / sizeof (off_t); i++) {
+        while (n < starts[i]) {
+            size = 80 + rand() % 5000;
+            if (starts[i] - n < size + 80) size = starts[i] - n;
+            n += writeIndexRecord(text + n, 1 + rand() % 500, number++, size);
+        }
+    }
+    return text;
+}
+
+/*
+ * Order of the index records by Gi and then by offset
+ */
+int compareIndexRecords(const void *a, const void *b) {
+    const char *x = a, *y = b;
+    int gx, gy;
+    off_t ox, oy;
+
+    memcpy(&gx, x, sizeof (int));
+    memcpy(&gy, y, sizeof (int));
+    memcpy(&ox, x + sizeof (int), sizeof (off_t));
+    memcpy(&oy, y + sizeof (int), sizeof (off_t));
+    if (gx != gy) return (gx < gy) ? -1 : 1;
+    return (ox < oy) ? -1 : (ox > oy);
+}
+
+/*
+ * The threads index their ranges and merge them: the result is the
+ * sequential index sorted by Gi with the duplicated Gis in file order
+ */
+void testFastaIndexParallel() {
+    int threads[] = {1, 2, 3, 4, 5, 6, 7, 8, 16, 40, 0};
+    char *text, *records;
+    size_t recordSize = sizeof (int) + sizeof (off_t);
+    int i, t, count, expected, *gis, gi;
+    off_t *offsets, offset;
+    BtreeNode_t *root;
+    BtreeRecord_t *record;
+    FILE *fd, *fo;
+
+    srand(59);
+    text = createIndexText();
+    CU_ASSERT(text[599990] == '>' && text[1000000] == '\n' && text[1000001] == '>');
+    CU_ASSERT(text[1500000] == '>' && text[2000000] == '>' && text[FASTA_INDEX_TEST_SIZE - 1] == '\n');
+    fd = fopen(fastaName, "w");
+    CU_ASSERT_FATAL(fd != NULL);
+    fwrite(text, 1, FASTA_INDEX_TEST_SIZE, fd);
+    fclose(fd);
+    free(text);
+
+    /* Sequential index, sorted by Gi and offset */
+    fd = fopen(fastaName, "r");
+    fo = tmpfile();
+    CU_ASSERT_FATAL(fd != NULL && fo != NULL);
+    expected = CreateFastaIndexToFile(fd, fo, 0);
+    fclose(fd);
+    CU_ASSERT_FATAL(expected > 500);
+    records = malloc(recordSize * expected);
+    rewind(fo);
+    CU_ASSERT_FATAL(fread(records, recordSize, expected, fo) == expected);
+    fclose(fo);
+    qsort(records, expected, recordSize, compareIndexRecords);
+
+    for (t = 0; t < sizeof (threads) / sizeof (int); t++) {
+        count = FastaIndexParallel(fastaName, NULL, threads[t], FASTA_INDEX_TEST_RANGE, &gis, &offsets, 0);
+        CU_ASSERT(count == expected);
+        for (i = 0; i < count && i < expected; i++) {
+            memcpy(&gi, records + i * recordSize, sizeof (int));
+            memcpy(&offset, records + i * recordSize + sizeof (int), sizeof (off_t));
+            if (gis[i] != gi || offsets[i] != offset) break;
+        }
+        CU_ASSERT(i == expected);
+        free(gis);
+        free(offsets);
+    }
+
+    /* The tree keeps the first entry of a duplicated Gi */
+    root = CreateBtreeFromFastaParallel(fastaName, 4, 0);
+    for (i = 0; i < expected; i++) {
+        memcpy(&gi, records + i * recordSize, sizeof (int));
+        memcpy(&offset, records + i * recordSize + sizeof (int), sizeof (off_t));
+        if (i > 0 && memcmp(records + (i - 1) * recordSize, &gi, sizeof (int)) == 0) continue;
+        record = BTreeFind(root, gi, false);
+        CU_ASSERT(record != NULL && *((off_t *) record->value) == offset);
+    }
+    BTreeFree(root, free);
+    free(records);
+    unlink(fastaName);
+}
+
+/*
+ * Reader test file: the first block of the reader ends on the new line
+ * before a header, a record is bigger than the reader buffer, there are
+ * blank lines before some headers, a header without sequence, a header
+ * across a block boundary and the last line has no new line
+ */
+#define READER_TEST_RECORDS 6
+
+char *readerHeaders[READER_TEST_RECORDS] = {
+    "first desc", "second\tsecond record", "third", "filler", "straddle|gi|77|name desc", "last"
+};
+int readerLineBases[READER_TEST_RECORDS] = {70, 60, 60, 80, 61, 50};
+int readerBlanks[READER_TEST_RECORDS] = {2, 0, 3, 0, 0, 0};
+int readerLens[READER_TEST_RECORDS];
+off_t readerOffsets[READER_TEST_RECORDS], readerSeqOffsets[READER_TEST_RECORDS];
+char *readerSeq;
+
+/*
+ * Append the blank lines, the header and len bases in lines of lineBases
+ * to the text. The last line has no new line if newline is 0
+ */
+size_t appendReaderRecord(char *text, size_t n, int i, int len, int newline) {
+    int p, line;
+
+    memset(text + n, '\n', readerBlanks[i]);
+    n += readerBlanks[i];
+    readerOffsets[i] = n;
+    n += sprintf(text + n, ">%s\n", readerHeaders[i]);
+    readerSeqOffsets[i] = n;
+    readerLens[i] = len;
+    for (p = 0; p < len; p += line) {
+        line = (len - p < readerLineBases[i]) ? len - p : readerLineBases[i];
+        memcpy(text + n, readerSeq + p, line);
+        n += line;
+        if (p + line < len || newline) text[n++] = '\n';
+    }
+    return n;
+}
+
+/*
+ * Number of bases of a sequence of exactly size bytes with new lines
+ */
+int readerBasesForBytes(size_t size, int lineBases) {
+    int len = size;
+
+    while (len > 0 && len + (len + lineBases - 1) / lineBases > size) len--;
+    return len;
+}
+
+/*
+ * The text of the reader test file. Returns its size
+ */
+size_t createReaderText(char **text) {
+    size_t n = 0, size = 5 << 20;
+    int i, len;
+
+    *text = malloc(size);
+    readerSeq = malloc(size);
+    for (i = 0; i < size; i++) readerSeq[i] = "ACGTNacgt"[rand() % 9];
+    /* The first record ends at the end of the first reader block */
+    len = readerBasesForBytes(FASTA_READER_BUFFER - readerBlanks[0] - strlen(readerHeaders[0]) - 2, readerLineBases[0]);
+    n = appendReaderRecord(*text, n, 0, len, 1);
+    n = appendReaderRecord(*text, n, 1, 5 * FASTA_READER_BUFFER / 2 + 17, 1);
+    n = appendReaderRecord(*text, n, 2, 0, 1);
+    /* The next header starts 5 bytes before the end of the 4th block */
+    len = readerBasesForBytes(4 * FASTA_READER_BUFFER - 5 - n - strlen(readerHeaders[3]) - 2, readerLineBases[3]);
+    n = appendReaderRecord(*text, n, 3, len, 1);
+    n = appendReaderRecord(*text, n, 4, 1000, 1);
+    n = appendReaderRecord(*text, n, 5, 123, 0);
+    return n;
+}
+
+/*
+ * Write the reader test file. Returns its size
+ */
+size_t writeReaderFile() {
+    char *text;
+    size_t size = createReaderText(&text);
+    FILE *fd = fopen(fastaName, "w");
+
+    fwrite(text, 1, size, fd);
+    fclose(fd);
+    free(text);
+    return size;
+}
+
+/*
+ * The .fai lines computed from the records written to the test file
+ */
+void testCreateFastaFaiToFile() {
+    FILE *fd, *fo, *ref;
+    char *outText, *refText;
+    size_t outSize, refSize;
+    int i, lineBases, lineWidth;
+
+    srand(61);
+    writeReaderFile();
+    CU_ASSERT(readerOffsets[1] == FASTA_READER_BUFFER);
+    CU_ASSERT(readerOffsets[4] == 4 * FASTA_READER_BUFFER - 5);
+    ref = open_memstream(&refText, &refSize);
+    for (i = 0; i < READER_TEST_RECORDS; i++) {
+        lineBases = (readerLens[i] < readerLineBases[i]) ? readerLens[i] : readerLineBases[i];
+        lineWidth = (lineBases == 0) ? 0 : lineBases + (i < READER_TEST_RECORDS - 1 || readerLens[i] > lineBases);
+        fprintf(ref, "%.*s\t%d\t%lld\t%d\t%d\n", (int) strcspn(readerHeaders[i], " \t"), readerHeaders[i],
+                readerLens[i], (long long int) readerSeqOffsets[i], lineBases, lineWidth);
+    }
+    fclose(ref);
+
+    fd = fopen(fastaName, "r");
+    CU_ASSERT_FATAL(fd != NULL);
+    fo = open_memstream(&outText, &outSize);
+    CU_ASSERT(CreateFastaFaiToFile(fd, fo, 0) == READER_TEST_RECORDS);
+    fclose(fo);
+    fclose(fd);
+    CU_ASSERT(strncmp(outText, "first\t1033793\t14\t70\t71\n", 23) == 0);
+    CU_ASSERT(outSize == refSize && memcmp(outText, refText, refSize) == 0);
+    free(outText);
+    free(refText);
+
+    /* A blank first line and a single last line without new line */
+    fd = fopen(fastaName, "w");
+    fputs(">one\nACGTA\n>two x\n\n>three\nAC", fd);
+    fclose(fd);
+    fd = fopen(fastaName, "r");
+    fo = open_memstream(&outText, &outSize);
+    CU_ASSERT(CreateFastaFaiToFile(fd, fo, 0) == 3);
+    fclose(fo);
+    fclose(fd);
+    CU_ASSERT(strcmp(outText, "one\t5\t5\t5\t6\ntwo\t0\t18\t0\t1\nthree\t2\t26\t2\t2\n") == 0);
+    free(outText);
+    free(readerSeq);
+    unlink(fastaName);
+}
+
+/*
+ * Offset where the reader is before the record: the blank lines before a
+ * header are read with the previous record
+ */
+off_t readerTell(int i) {
+    return (i == 0) ? 0 : readerOffsets[i];
+}
+
+/*
+ * Check a record read from the reader test file
+ */
+int checkReaderRecord(fasta_l fasta, int i, int excludeSeq) {
+    if (fasta == NULL || strcmp(fasta->header, readerHeaders[i]) != 0) return 0;
+    if (excludeSeq) return fasta->seq == NULL;
+    return fasta->len == readerLens[i] && fasta->seq != NULL && strlen(fasta->seq) == readerLens[i]
+            && memcmp(fasta->seq, readerSeq, readerLens[i]) == 0;
+}
+
+/*
+ * Read the records sequentially with the reader and with ReadFasta, that
+ * leaves the file at the next record, and from their offsets
+ */
+void testFastaReader() {
+    FastaReader_t *reader;
+    fasta_l fasta;
+    FILE *fd;
+    size_t size;
+    int i, excludeSeq, bufferSize;
+
+    srand(67);
+    size = writeReaderFile();
+    fd = fopen(fastaName, "r");
+    CU_ASSERT_FATAL(fd != NULL);
+
+    for (excludeSeq = 0; excludeSeq <= 1; excludeSeq++) {
+        rewind(fd);
+        reader = CreateFastaReader(fd);
+        for (i = 0; i < READER_TEST_RECORDS; i++) {
+            CU_ASSERT(FastaReaderTell(reader) == readerTell(i));
+            fasta = FastaReaderNext(reader, excludeSeq);
+            CU_ASSERT(checkReaderRecord(fasta, i, excludeSeq));
+            if (fasta) fasta->free(fasta);
+        }
+        CU_ASSERT(FastaReaderTell(reader) == size);
+        CU_ASSERT(FastaReaderNext(reader, excludeSeq) == NULL);
+        FreeFastaReader(reader);
+    }
+
+    /* ReadFasta with its default buffer and with buffers smaller than a line */
+    for (bufferSize = 1; bufferSize <= 65536; bufferSize *= 16) {
+        rewind(fd);
+        for (i = 0; i < READER_TEST_RECORDS; i++) {
+            CU_ASSERT(ftello(fd) == readerTell(i));
+            fasta = (bufferSize == 65536) ? ReadFasta(fd, 0) : ReadFastaBuffer(fd, bufferSize, 0);
+            CU_ASSERT(checkReaderRecord(fasta, i, 0));
+            if (fasta) fasta->free(fasta);
+        }
+        CU_ASSERT(ftello(fd) == size);
+        CU_ASSERT(ReadFasta(fd, 0) == NULL);
+    }
+
+    for (i = READER_TEST_RECORDS - 1; i >= 0; i--) {
+        fasta = ReadFastaFromOffset(fd, readerOffsets[i], i % 2);
+        CU_ASSERT(checkReaderRecord(fasta, i, i % 2));
+        if (fasta) fasta->free(fasta);
+    }
+    fclose(fd);
+    free(readerSeq);
+    unlink(fastaName);
+}
+
+/*
+ * Write the records with a writer to a file with a descriptor or to a
+ * memory stream and compare the output with toFileFasta
+ */
+void checkWriter(char **seqs, int *lengths, int n, int lineLength, int packed, int memory) {
+    FastaWriter_t *writer;
+    fasta_l fasta;
+    FILE *out, *ref;
+    char *outText = NULL, *refText, header[64];
+    size_t outSize = 0, refSize;
+    int i;
+
+    out = (memory) ? open_memstream(&outText, &outSize) : tmpfile();
+    ref = open_memstream(&refText, &refSize);
+    /* Written to the FILE before the writer */
+    fputs("; test file\n", out);
+    fputs("; test file\n", ref);
+    writer = CreateFastaWriter(out, lineLength);
+    for (i = 0; i < n; i++) {
+        sprintf(header, "gi|%d|ref|writer test %d", 2001 + i, lengths[i]);
+        fasta = CreateFasta();
+        fasta->setHeader(fasta, header);
+        fasta->setSeq(fasta, seqs[i]);
+        fasta->toFile(fasta, ref, lineLength);
+        if (packed) fasta->pack(fasta);
+        FastaWriterWriteFasta(writer, fasta);
+        fasta->free(fasta);
+    }
+    FreeFastaWriter(writer);
+    fclose(ref);
+    if (!memory) {
+        fseeko(out, 0, SEEK_END);
+        outSize = ftello(out);
+        outText = malloc(outSize + 1);
+        rewind(out);
+        CU_ASSERT(fread(outText, 1, outSize, out) == outSize);
+    }
+    fclose(out);
+    CU_ASSERT(outSize == refSize);
+    CU_ASSERT(outSize == refSize && memcmp(outText, refText, refSize) == 0);
+    free(outText);
+    free(refText);
+}
+
+/*
+ * Sequences shorter, as long and longer than a line and a sequence bigger
+ * than the writer buffer
+ */
+void testFastaWriter() {
+    int lengths[] = {0, 1, 59, 60, 61, 120, 3 * FASTA_WRITER_BUFFER / 2 + 7, 80};
+    int lineLengths[] = {1, 60, 61, 80};
+    int n = sizeof (lengths) / sizeof (int);
+    char *seqs[sizeof (lengths) / sizeof (int)];
+    int i, l, packed, memory;
+
+    srand(71);
+    for (i = 0; i < n; i++) {
+        seqs[i] = createSequence(lengths[i]);
+    }
+    for (l = 0; l < sizeof (lineLengths) / sizeof (int); l++) {
+        for (packed = 0; packed <= 1; packed++) {
+            for (memory = 0; memory <= 1; memory++) {
+                checkWriter(seqs, lengths, n, lineLengths[l], packed, memory);
+            }
+        }
+    }
+    for (i = 0; i < n; i++) {
+        free(seqs[i]);
+    }
+}
+
 int main() {
     CU_pSuite pSuite = NULL;
 
@@ -50,7 +710,14 @@ int main() {
     }
 
     /* Add the tests to the suite */
-    if ((NULL == CU_add_test(pSuite, "testCreateFasta", testCreateFasta))) {
+    if ((NULL == CU_add_test(pSuite, "testCreateFasta", testCreateFasta)) ||
+            (NULL == CU_add_test(pSuite, "testFastaSplitter", testFastaSplitter)) ||
+            (NULL == CU_add_test(pSuite, "testSplitInSegments", testSplitInSegments)) ||
+            (NULL == CU_add_test(pSuite, "testFastaSegmentFilter", testFastaSegmentFilter)) ||
+            (NULL == CU_add_test(pSuite, "testFastaIndexParallel", testFastaIndexParallel)) ||
+            (NULL == CU_add_test(pSuite, "testCreateFastaFaiToFile", testCreateFastaFaiToFile)) ||
+            (NULL == CU_add_test(pSuite, "testFastaReader", testFastaReader)) ||
+            (NULL == CU_add_test(pSuite, "testFastaWriter", testFastaWriter))) {
         CU_cleanup_registry();
         return CU_get_error();
     }
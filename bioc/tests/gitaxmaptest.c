@@ -0,0 +1,104 @@
+/*
+ * File:   gitaxmaptest.c
+ * Author: roberto
+ *
+ * Created on Oct 19, 2026, 4:05:51 PM
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <CUnit/Basic.h>
+#include "../include/gitaxmap.h"
+
+/*
+ * CUnit Test Suite
+ */
+
+int init_suite(void) {
+    return 0;
+}
+
+int clean_suite(void) {
+    return 0;
+}
+
+void testGiTaxMap() {
+    int sizes[] = {0, 1, 127, 128, 129, 200000};
+    char name[] = "/tmp/gitaxmaptestXXXXXX";
+    int i, s, n, fd;
+    int *gis, *taxIds, *query, *out;
+    GiTaxMap_t *map;
+
+    fd = mkstemp(name);
+    CU_ASSERT_FATAL(fd != -1);
+    close(fd);
+    for (s = 0; s < sizeof (sizes) / sizeof (int); s++) {
+        n = sizes[s];
+        gis = malloc(sizeof (int) * (n + 1));
+        taxIds = malloc(sizeof (int) * (n + 1));
+        query = malloc(sizeof (int) * (2 * n + 2));
+        out = malloc(sizeof (int) * (2 * n + 2));
+        /* Runs of close Gis separated by big gaps */
+        for (i = 0; i < n; i++) {
+            gis[i] = (i / 16) * 100000 + 3 * (i % 16) + 1;
+            taxIds[i] = (i * 7919) % 2000000;
+        }
+        map = GiTaxMapCreate(gis, taxIds, n);
+        GiTaxMapWrite(map, name);
+        GiTaxMapFree(map);
+        CU_ASSERT(GiTaxMapCheck(name) == 1);
+
+        map = GiTaxMapOpen(name);
+        CU_ASSERT(map->header->count == n);
+        for (i = 0; i < n; i++) {
+            CU_ASSERT(GiTaxMapFind(map, gis[i]) == taxIds[i]);
+            CU_ASSERT(GiTaxMapFind(map, gis[i] + 1) == -1);
+            query[2 * i] = gis[i];
+            query[2 * i + 1] = gis[i] - 1;
+        }
+        CU_ASSERT(GiTaxMapFind(map, 0) == -1);
+        CU_ASSERT(GiTaxMapFind(map, -1) == -1);
+        CU_ASSERT(GiTaxMapFind(map, 2147483647) == -1);
+        GiTaxMapFindBatch(map, query, 2 * n, out);
+        for (i = 0; i < n; i++) {
+            CU_ASSERT(out[2 * i] == taxIds[i]);
+            CU_ASSERT(out[2 * i + 1] == -1);
+        }
+        GiTaxMapFree(map);
+
+        free(gis);
+        free(taxIds);
+        free(query);
+        free(out);
+    }
+    unlink(name);
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* Initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* Add a suite to the registry */
+    pSuite = CU_add_suite("gitaxmaptest", init_suite, clean_suite);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "testGiTaxMap", testGiTaxMap))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}
@@ -0,0 +1,246 @@
+/*
+ * File:   taxonomytest.c
+ * Author: roberto
+ *
+ * Created on Oct 19, 2026, 10:05:12 AM
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <CUnit/Basic.h>
+#include "../include/btree.h"
+#include "../include/taxonomy.h"
+
+/*
+ * CUnit Test Suite
+ */
+
+/* Taxonomy files in the test dir */
+#define TAXONOMY_TEST_TAXIDS 100000
+#define TAXONOMY_TEST_GIS 400000
+
+char testDir[] = "/tmp/taxonomytestXXXXXX";
+char *ranks[] = {"species", "genus", "subspecies", "no rank", "clade", "family"};
+
+int init_suite(void) {
+    return (mkdtemp(testDir) == NULL) ? -1 : 0;
+}
+
+int clean_suite(void) {
+    return rmdir(testDir);
+}
+
+/*
+ * Write the text to dir/name without its last newline
+ */
+void writeTestFile(char *name, char *text, size_t size) {
+    char path[256];
+    FILE *fo;
+
+    sprintf(path, "%s/%s", testDir, name);
+    fo = fopen(path, "w");
+    CU_ASSERT_FATAL(fo != NULL);
+    if (size > 0 && text[size - 1] == '\n') size--;
+    fwrite(text, 1, size, fo);
+    fclose(fo);
+}
+
+void removeTestFile(char *name) {
+    char path[256];
+
+    sprintf(path, "%s/%s", testDir, name);
+    unlink(path);
+}
+
+/*
+ * The test taxonomy: every taxId not multiple of 7 with parent taxId / 2
+ * (or 1) and a rank and a name from the taxId
+ */
+int testParent(int taxId) {
+    return (taxId / 2 > 0 && (taxId / 2) % 7 != 0) ? taxId / 2 : 1;
+}
+
+void testTaxonomyTableLoad() {
+    int threads[] = {1, 3, 4};
+    char *text, name[64];
+    size_t size;
+    FILE *fo;
+    int t, taxId;
+    TaxonomyTable_t *table;
+
+    /*
+     * More than one parser chunk, with a repeated taxId where the last
+     * line wins. The last line of the files has not newline
+     */
+    fo = open_memstream(&text, &size);
+    for (taxId = 1; taxId <= TAXONOMY_TEST_TAXIDS; taxId++) {
+        if (taxId % 7 == 0) continue;
+        fprintf(fo, "%d\t|\t%d\t|\t%s\t|\t\t|\t8\t|\t0\t|\t1\t|\t0\t|\t0\t|\t0\t|\t0\t|\t0\t|\t\t|\n",
+                taxId, (taxId == 5) ? 3 : testParent(taxId), ranks[taxId % 6]);
+    }
+    fprintf(fo, "5\t|\t%d\t|\t%s\t|\t\t|\t8\t|\t0\t|\t1\t|\t0\t|\t0\t|\t0\t|\t0\t|\t0\t|\t\t|\n", testParent(5), ranks[5 % 6]);
+    fclose(fo);
+    writeTestFile("nodes.dmp", text, size);
+    free(text);
+
+    /* Only the scientific names of the taxIds in nodes.dmp are kept */
+    fo = open_memstream(&text, &size);
+    for (taxId = TAXONOMY_TEST_TAXIDS + 1; taxId <= TAXONOMY_TEST_TAXIDS + 10; taxId++) {
+        fprintf(fo, "%d\t|\tTaxon %d\t|\t\t|\tscientific name\t|\n", taxId, taxId);
+    }
+    for (taxId = 1; taxId <= TAXONOMY_TEST_TAXIDS; taxId++) {
+        if (taxId % 7 == 0) continue;
+        fprintf(fo, "%d\t|\tsynonym %d\t|\t\t|\tsynonym\t|\n", taxId, taxId);
+        fprintf(fo, "%d\t|\tTaxon %d\t|\t\t|\tscientific name\t|\n", taxId, taxId);
+    }
+    fclose(fo);
+    writeTestFile("names.dmp", text, size);
+    free(text);
+
+    for (t = 0; t < sizeof (threads) / sizeof (int); t++) {
+        table = TaxonomyTableLoad(testDir, threads[t], 0);
+        CU_ASSERT(table->maxTaxId == TAXONOMY_TEST_TAXIDS);
+        CU_ASSERT(table->count == TAXONOMY_TEST_TAXIDS - TAXONOMY_TEST_TAXIDS / 7);
+        for (taxId = 0; taxId <= TAXONOMY_TEST_TAXIDS + 1; taxId++) {
+            if (taxId == 0 || taxId % 7 == 0 || taxId > TAXONOMY_TEST_TAXIDS) {
+                CU_ASSERT(TaxonomyTableContains(table, taxId) == 0);
+                continue;
+            }
+            CU_ASSERT_FATAL(TaxonomyTableContains(table, taxId) == 1);
+            CU_ASSERT(table->nodes[taxId].parentTaxId == testParent(taxId));
+            CU_ASSERT(strcmp(TaxonomyTableRank(table, taxId), ranks[taxId % 6]) == 0);
+            sprintf(name, "Taxon %d", taxId);
+            CU_ASSERT(strcmp(TaxonomyTableName(table, taxId), name) == 0);
+        }
+        TaxonomyTableFree(table);
+    }
+    removeTestFile("nodes.dmp");
+    removeTestFile("names.dmp");
+}
+
+/*
+ * The Gis of the test have from 1 to 10 digits
+ */
+int testGi(int k) {
+    return k * 5003 + 1 + k % 3;
+}
+
+int testTaxId(int k) {
+    return (int) (((long) k * 7919) % 3000000) + 1;
+}
+
+/*
+ * Load the gi_taxid file and compare it with the test Gis
+ */
+void checkNuclLoad(char *name, int threads) {
+    char path[256];
+    int k, n, *gis, *taxIds;
+
+    sprintf(path, "%s/%s", testDir, name);
+    n = TaxonomyNuclLoad(path, threads, &gis, &taxIds, 0);
+    CU_ASSERT_FATAL(n == TAXONOMY_TEST_GIS);
+    for (k = 0; k < n; k++) {
+        CU_ASSERT(gis[k] == testGi(k));
+        CU_ASSERT(taxIds[k] == testTaxId(k));
+    }
+    free(gis);
+    free(taxIds);
+}
+
+void testTaxonomyNuclLoad() {
+    int threads[] = {1, 2, 3, 4, 8};
+    char *text, path[256];
+    size_t size;
+    FILE *fo;
+    gzFile gz;
+    int i, k, t, tmp, *order;
+
+    /*
+     * Sorted file of several parser chunks where every Gi is repeated in
+     * the next line and the first line wins, so some repeated Gis are in
+     * both sides of a chunk cut. The last line has not newline
+     */
+    fo = open_memstream(&text, &size);
+    for (k = 0; k < TAXONOMY_TEST_GIS; k++) {
+        fprintf(fo, "%d\t%d\n%d\t%d\n", testGi(k), testTaxId(k), testGi(k), testTaxId(k) + 1);
+    }
+    fclose(fo);
+    writeTestFile("gi_taxid_nucl.dmp", text, size);
+    free(text);
+    for (t = 0; t < sizeof (threads) / sizeof (int); t++) {
+        checkNuclLoad("gi_taxid_nucl.dmp", threads[t]);
+    }
+
+    /*
+     * Unsorted file: the chunks are sorted and merged. The repeated Gis
+     * are in the second half of the file, in other chunks
+     */
+    order = malloc(sizeof (int) * TAXONOMY_TEST_GIS);
+    for (k = 0; k < TAXONOMY_TEST_GIS; k++) order[k] = k;
+    srand(17);
+    for (k = TAXONOMY_TEST_GIS - 1; k > 0; k--) {
+        i = rand() % (k + 1);
+        tmp = order[k];
+        order[k] = order[i];
+        order[i] = tmp;
+    }
+    fo = open_memstream(&text, &size);
+    for (k = 0; k < TAXONOMY_TEST_GIS; k++) {
+        fprintf(fo, "%d\t%d\n", testGi(order[k]), testTaxId(order[k]));
+    }
+    for (k = TAXONOMY_TEST_GIS - 1; k >= 0; k--) {
+        fprintf(fo, "%d\t%d\n", testGi(k), testTaxId(k) + 1);
+    }
+    fclose(fo);
+    writeTestFile("gi_taxid_unsorted.dmp", text, size);
+    for (t = 0; t < sizeof (threads) / sizeof (int); t++) {
+        checkNuclLoad("gi_taxid_unsorted.dmp", threads[t]);
+    }
+
+    /* The same lines compressed */
+    sprintf(path, "%s/gi_taxid_nucl.dmp.gz", testDir);
+    gz = gzopen(path, "wb");
+    CU_ASSERT_FATAL(gz != NULL);
+    gzwrite(gz, text, size - 1);
+    gzclose(gz);
+    checkNuclLoad("gi_taxid_nucl.dmp.gz", 4);
+    free(text);
+    free(order);
+
+    removeTestFile("gi_taxid_nucl.dmp");
+    removeTestFile("gi_taxid_unsorted.dmp");
+    removeTestFile("gi_taxid_nucl.dmp.gz");
+}
+
+int main() {
+    CU_pSuite pSuite = NULL;
+
+    /* Initialize the CUnit test registry */
+    if (CUE_SUCCESS != CU_initialize_registry())
+        return CU_get_error();
+
+    /* Add a suite to the registry */
+    pSuite = CU_add_suite("taxonomytest", init_suite, clean_suite);
+    if (NULL == pSuite) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Add the tests to the suite */
+    if ((NULL == CU_add_test(pSuite, "testTaxonomyTableLoad", testTaxonomyTableLoad)) ||
+            (NULL == CU_add_test(pSuite, "testTaxonomyNuclLoad", testTaxonomyNuclLoad))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+    /* Run all tests using the CUnit Basic interface */
+    CU_basic_set_mode(CU_BRM_VERBOSE);
+    CU_basic_run_tests();
+    CU_cleanup_registry();
+    return CU_get_error();
+}